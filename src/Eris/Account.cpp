@@ -93,6 +93,7 @@ Account::Account(Connection& con) :
 		m_doingCharacterRefresh(false) {
 	m_con.Connected.connect(sigc::mem_fun(*this, &Account::netConnected));
 	m_con.Failure.connect(sigc::mem_fun(*this, &Account::netFailure));
+	m_con.Reconnecting.connect(sigc::mem_fun(*this, &Account::netReconnecting));
 }
 
 Account::~Account() {
@@ -122,6 +123,8 @@ Result Account::login(const std::string& uname, const std::string& password) {
 		return ALREADY_LOGGED_IN;
 	}
 
+	// store for re-logins
+	m_pass = password;
 	return internalLogin(uname, password);
 }
 
@@ -408,11 +411,19 @@ void Account::loginComplete(const AtlasAccount& p) {
 	m_con.registerRouterForTo(m_router.get(), m_accountId);
 	updateFromObject(p);
 
+	if (!m_disconnectingConnection.connected()) {
+		m_disconnectingConnection = m_con.Disconnecting.connect(sigc::mem_fun(*this, &Account::netDisconnecting));
+	}
+	m_timeout.reset();
+
+	if (!m_activeAvatars.empty()) {
+		// logged in again after a reconnect, with the session still active
+		resumeAvatars();
+		return;
+	}
+
 	// notify an people watching us
 	LoginSuccess.emit();
-
-	m_con.Disconnecting.connect(sigc::mem_fun(*this, &Account::netDisconnecting));
-	m_timeout.reset();
 }
 
 void Account::avatarLogoutRequested(Avatar* avatar) {
@@ -565,9 +576,28 @@ void Account::handleLoginTimeout() {
 }
 
 void Account::possessResponse(const RootOperation& op) {
+	std::string resumedEntityId;
+	auto resumeRequest = m_resumeRequests.find(op->getRefno());
+	if (resumeRequest != m_resumeRequests.end()) {
+		resumedEntityId = resumeRequest->second;
+		m_resumeRequests.erase(resumeRequest);
+	}
+
 	if (op->instanceOf(ERROR_NO)) {
 		std::string msg = getErrorMessage(op);
 
+		if (!resumedEntityId.empty()) {
+			warning() << "Could not take over character " << resumedEntityId << " again after reconnecting: " << msg;
+			for (auto& entry : m_activeAvatars) {
+				if (entry.second->getEntityId() == resumedEntityId) {
+					destroyAvatar(entry.first);
+					break;
+				}
+			}
+			m_status = Account::Status::LOGGED_IN;
+			return;
+		}
+
 		// creating or taking a character failed for some reason
 		AvatarFailure(msg);
 		m_status = Account::Status::LOGGED_IN;
@@ -602,6 +632,23 @@ void Account::possessResponse(const RootOperation& op) {
 			return;
 		}
 
+		if (!resumedEntityId.empty()) {
+			auto I = m_activeAvatars.find(ent->getId());
+			if (I != m_activeAvatars.end() && I->second->getEntityId() == entityObj->getId()) {
+				m_status = Account::Status::LOGGED_IN;
+				I->second->resume();
+				AvatarResumed.emit(I->second.get());
+				return;
+			}
+			//The server gave the character a new mind, so the avatar has to be created anew.
+			for (auto& entry : m_activeAvatars) {
+				if (entry.second->getEntityId() == resumedEntityId) {
+					destroyAvatar(entry.first);
+					break;
+				}
+			}
+		}
+
 		if (m_activeAvatars.find(ent->getId()) != m_activeAvatars.end()) {
 			warning() << "got possession response for character already created";
 			return;
@@ -693,6 +740,40 @@ bool Account::netDisconnecting() {
 		return true;
 }
 
+void Account::netReconnecting() {
+	if (!isLoggedIn()) {
+		return;
+	}
+	debug() << "Account " << m_username << " lost its connection, keeping the session to resume it";
+
+	// the server will see this as a new login, but the avatars and their views are kept
+	m_con.unregisterRouterForTo(m_router.get(), m_accountId);
+	m_status = Status::DISCONNECTED;
+	m_timeout.reset();
+	m_resumeRequests.clear();
+	for (auto& entry : m_activeAvatars) {
+		entry.second->suspend();
+	}
+}
+
+void Account::resumeAvatars() {
+	for (auto& entry : m_activeAvatars) {
+		Anonymous what;
+		what->setId(entry.second->getEntityId());
+
+		Atlas::Objects::Operation::Generic possessOp;
+		possessOp->setParent("possess");
+		possessOp->setFrom(m_accountId);
+		possessOp->setArgs1(what);
+		possessOp->setSerialno(getNewSerialno());
+		m_con.send(possessOp);
+
+		m_con.getResponder().await(possessOp->getSerialno(), this, &Account::possessResponse);
+		m_resumeRequests.emplace(possessOp->getSerialno(), entry.second->getEntityId());
+	}
+	m_status = Status::TAKING_CHAR;
+}
+
 void Account::netFailure(const std::string& /*msg*/) {
 
 }
@@ -206,6 +206,13 @@ class Account : virtual public sigc::trackable {
         */
         sigc::signal<void(Avatar *)> AvatarSuccess;
 
+        /**
+        Emitted when an avatar kept through a reconnect has been taken over
+        again, and its View is being resynchronised with the server.
+        @see Connection::setAutoReconnect
+        */
+        sigc::signal<void(Avatar *)> AvatarResumed;
+
         /**
         Emitted when creating or taking a character fails for some reason.
         String argument is the error message from the server.
@@ -243,6 +250,12 @@ class Account : virtual public sigc::trackable {
         /// help! the plug is being pulled!
         bool netDisconnecting();
 
+        /// Callback for the connection being lost, and about to be re-established
+        void netReconnecting();
+
+        /// Takes over the avatars kept through a reconnect again
+        void resumeAvatars();
+
         void netFailure(const std::string &msg);
 
         void loginResponse(const Atlas::Objects::Operation::RootOperation &op);
@@ -301,6 +314,13 @@ class Account : virtual public sigc::trackable {
         ActiveCharacterMap m_activeAvatars;
         std::unique_ptr<TimedEvent> m_timeout;
 
+        /**
+         * @brief The entity ids of the avatars being taken over again after a reconnect, keyed by the serial of the possess op.
+         */
+        std::map<std::int64_t, std::string> m_resumeRequests;
+
+        sigc::connection m_disconnectingConnection;
+
         /**
          * @brief A map of available spawn points.
          * These are points from which a new avatar can be created.
@@ -0,0 +1,123 @@
+#include "AsyncLogSink.h"
+
+namespace Eris
+{
+
+namespace {
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+	std::size_t result = 2;
+	while (result < value) {
+		result <<= 1;
+	}
+	return result;
+}
+}
+
+AsyncLogSink::AsyncLogSink(Handler handler, std::size_t capacity) :
+		m_slots(new Slot[roundUpToPowerOfTwo(capacity)]),
+		m_mask(roundUpToPowerOfTwo(capacity) - 1),
+		m_writePosition(0),
+		m_readPosition(0),
+		m_running(true),
+		m_sleeping(false),
+		m_dropped(0),
+		m_handler(std::move(handler))
+{
+	for (std::size_t i = 0; i <= m_mask; ++i) {
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	m_thread = std::thread([this]() { run(); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running = false;
+		m_wakeup.notify_one();
+	}
+	m_thread.join();
+}
+
+bool AsyncLogSink::push(LogLevel level, std::string message)
+{
+	auto position = m_writePosition.load(std::memory_order_relaxed);
+	Slot* slot;
+	while (true) {
+		slot = &m_slots[position & m_mask];
+		auto sequence = slot->sequence.load(std::memory_order_acquire);
+		auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+		if (difference == 0) {
+			//The slot is free; claim it, unless another thread got there first.
+			if (m_writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (difference < 0) {
+			//The slot still holds a message from the previous turn of the ring, which means it's full.
+			m_dropped++;
+			return false;
+		} else {
+			position = m_writePosition.load(std::memory_order_relaxed);
+		}
+	}
+	slot->level = level;
+	slot->message = std::move(message);
+	slot->sequence.store(position + 1, std::memory_order_release);
+
+	//Pairs with the fence in run(), so that either the thread sees the message, or we see that it's sleeping.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_wakeup.notify_one();
+	}
+	return true;
+}
+
+std::uint64_t AsyncLogSink::getDropped() const
+{
+	return m_dropped;
+}
+
+bool AsyncLogSink::hasMessage() const
+{
+	auto& slot = m_slots[m_readPosition & m_mask];
+	return slot.sequence.load(std::memory_order_acquire) == m_readPosition + 1;
+}
+
+void AsyncLogSink::run()
+{
+	int idle = 0;
+	while (true) {
+		if (hasMessage()) {
+			auto& slot = m_slots[m_readPosition & m_mask];
+			auto level = slot.level;
+			auto message = std::move(slot.message);
+			//Hand the slot back to the writers for the next turn of the ring.
+			slot.sequence.store(m_readPosition + m_mask + 1, std::memory_order_release);
+			m_readPosition++;
+			m_handler(level, message);
+			idle = 0;
+			continue;
+		}
+		//Messages tend to come in bursts, so wait a little before going to sleep, and making writers wake us.
+		if (idle++ < 64) {
+			std::this_thread::yield();
+			continue;
+		}
+		idle = 0;
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!m_running) {
+			break;
+		}
+		m_sleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!hasMessage()) {
+			//The timeout is only a safeguard; writers wake us up when we're sleeping.
+			m_wakeup.wait_for(lock, std::chrono::milliseconds(100));
+		}
+		m_sleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef ERIS_ASYNCLOGSINK_H
+#define ERIS_ASYNCLOGSINK_H
+
+#include "Log.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Eris
+{
+
+/**
+ * @brief Hands log messages to a handler on a background thread.
+ *
+ * Messages are passed through a fixed size lock-free ring, so logging never waits for the handler, or for
+ * other threads logging at the same time. If the handler can't keep up and the ring fills up, new messages
+ * are dropped and counted.
+ *
+ * Install it with setAsyncLogSink(), and uninstall it before destroying it.
+ */
+class AsyncLogSink
+{
+public:
+	typedef std::function<void(LogLevel, const std::string&)> Handler;
+
+	/**
+	 * @param handler Called on the background thread for each message, in the order they were pushed.
+	 * @param capacity The number of messages the ring holds, rounded up to a power of two.
+	 */
+	explicit AsyncLogSink(Handler handler, std::size_t capacity = 4096);
+
+	/**
+	 * Hands any messages left to the handler, and then stops the thread.
+	 */
+	~AsyncLogSink();
+
+	/**
+	 * @brief Queues a message for the handler. Can be called from any thread.
+	 * @return False if the ring was full, and the message was dropped.
+	 */
+	bool push(LogLevel level, std::string message);
+
+	/**
+	 * @brief Gets the number of messages dropped because the ring was full.
+	 */
+	std::uint64_t getDropped() const;
+
+private:
+	struct Slot
+	{
+		/**
+		 * Equals the position the slot is next to be written at when it's free, and that position plus one
+		 * once it's been written.
+		 */
+		std::atomic<std::size_t> sequence;
+		LogLevel level;
+		std::string message;
+	};
+
+	std::unique_ptr<Slot[]> m_slots;
+	const std::size_t m_mask;
+
+	std::atomic<std::size_t> m_writePosition;
+	std::size_t m_readPosition; ///< only used by the background thread
+
+	std::atomic<bool> m_running;
+	std::atomic<bool> m_sleeping;
+	std::atomic<std::uint64_t> m_dropped;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+
+	Handler m_handler;
+	std::thread m_thread;
+
+	bool hasMessage() const;
+
+	void run();
+};
+
+}
+
+#endif //ERIS_ASYNCLOGSINK_H
@@ -87,6 +87,15 @@ namespace Eris {
                                                      });
     }
 
+    void Avatar::suspend() {
+        m_view->markEntitiesStale();
+    }
+
+    void Avatar::resume() {
+        m_account.getConnection().getTypeService().setTypeProviderId(m_mindId);
+        m_view->resynchronise();
+    }
+
     void Avatar::touch(Entity *e, const WFMath::Point<3> &pos) {
         Touch touchOp;
         touchOp->setFrom(m_mindId);
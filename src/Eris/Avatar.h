@@ -196,6 +196,16 @@ protected:
 	void updateWorldTime(double t);
 
 protected:
+	/**
+	 * @brief Called by the Account when the connection has been lost, but the session is to be resumed.
+	 */
+	void suspend();
+
+	/**
+	 * @brief Called by the Account once the avatar has been taken over again after a reconnect.
+	 */
+	void resume();
+
 	void onEntityAppear(Entity* ent);
 
 	/**
@@ -0,0 +1,132 @@
+#include "BackgroundDecoder.h"
+#include "EventService.h"
+#include "RingBuffer.h"
+
+#include <Atlas/Message/DecoderBase.h>
+#include <Atlas/Codecs/Bach.h>
+#include <Atlas/Codecs/Packed.h>
+#include <Atlas/Codecs/XML.h>
+
+#include <ostream>
+
+namespace Eris
+{
+
+namespace
+{
+
+/**
+ * Collects all decoded messages.
+ */
+struct MessageCollector : Atlas::Message::DecoderBase
+{
+	std::vector<Atlas::Message::MapType> messages;
+
+	void messageArrived(Atlas::Message::MapType obj) override
+	{
+		messages.push_back(std::move(obj));
+	}
+};
+
+template<typename CodecT>
+BackgroundDecoder::CodecFactory createFactory()
+{
+	return [](std::istream& in, std::ostream& out, Atlas::Bridge& bridge) -> std::unique_ptr<Atlas::Codec> {
+		return std::make_unique<CodecT>(in, out, bridge);
+	};
+}
+
+}
+
+BackgroundDecoder::BackgroundDecoder(EventService& eventService, CodecFactory codecFactory, MessagesHandler handler) :
+		mEventService(eventService),
+		mCodecFactory(std::move(codecFactory)),
+		mHandler(std::move(handler)),
+		mShutdown(false),
+		mThread([this]() { run(); })
+{
+}
+
+BackgroundDecoder::~BackgroundDecoder()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+	mCondition.notify_one();
+	mThread.join();
+}
+
+void BackgroundDecoder::push(std::string data)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mInput.push_back(std::move(data));
+	}
+	mCondition.notify_one();
+}
+
+void BackgroundDecoder::stop()
+{
+	*mActiveMarker.getMarker() = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+	mCondition.notify_one();
+}
+
+void BackgroundDecoder::run()
+{
+	RingBuffer buffer;
+	std::istream inStream(&buffer);
+	//The codec is only used for decoding, so anything it writes is discarded.
+	std::ostream outStream(nullptr);
+	MessageCollector collector;
+	auto codec = mCodecFactory(inStream, outStream, collector);
+
+	std::deque<std::string> input;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [&]() { return mShutdown || !mInput.empty(); });
+			if (mShutdown) {
+				return;
+			}
+			input.swap(mInput);
+		}
+
+		for (auto& data : input) {
+			auto buffers = buffer.prepare(data.size());
+			boost::asio::buffer_copy(buffers, boost::asio::buffer(data));
+			buffer.commit(data.size());
+		}
+		buffer.recordBurst(buffer.size());
+		input.clear();
+
+		codec->poll();
+
+		if (!collector.messages.empty()) {
+			//The std::function must be copyable, so the messages are put in a shared_ptr.
+			auto messages = std::make_shared<std::vector<Atlas::Message::MapType>>(std::move(collector.messages));
+			collector.messages.clear();
+			mEventService.runOnMainThread([this, messages]() {
+				mHandler(std::move(*messages));
+			}, mActiveMarker);
+		}
+	}
+}
+
+BackgroundDecoder::CodecFactory BackgroundDecoder::getFactoryFor(const Atlas::Codec& codec)
+{
+	if (dynamic_cast<const Atlas::Codecs::Packed*>(&codec)) {
+		return createFactory<Atlas::Codecs::Packed>();
+	} else if (dynamic_cast<const Atlas::Codecs::XML*>(&codec)) {
+		return createFactory<Atlas::Codecs::XML>();
+	} else if (dynamic_cast<const Atlas::Codecs::Bach*>(&codec)) {
+		return createFactory<Atlas::Codecs::Bach>();
+	}
+	return {};
+}
+
+}
@@ -0,0 +1,117 @@
+#ifndef ERIS_BACKGROUNDDECODER_H
+#define ERIS_BACKGROUNDDECODER_H
+
+#include "ActiveMarker.h"
+
+#include <Atlas/Message/Element.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Atlas
+{
+class Bridge;
+class Codec;
+}
+
+namespace Eris
+{
+
+class EventService;
+
+/**
+ * @brief Decodes Atlas data in a background thread.
+ *
+ * Raw data received from the socket is handed to push(), and is decoded into Atlas messages by a codec
+ * running in a separate thread. The decoded messages are then passed back to the main thread through
+ * EventService::runOnMainThread.
+ *
+ * The result is messages rather than Atlas::Objects instances since these are created from allocators
+ * which aren't thread safe. Turning the messages into objects is however cheap compared to parsing them.
+ */
+class BackgroundDecoder : private boost::noncopyable
+{
+public:
+	/**
+	 * @brief Creates a codec which reads from the supplied stream.
+	 */
+	typedef std::function<std::unique_ptr<Atlas::Codec>(std::istream&, std::ostream&, Atlas::Bridge&)> CodecFactory;
+
+	/**
+	 * @brief Handles decoded messages. Called on the main thread.
+	 */
+	typedef std::function<void(std::vector<Atlas::Message::MapType>)> MessagesHandler;
+
+	/**
+	 * @brief Ctor.
+	 * @param eventService Used for passing decoded messages to the main thread.
+	 * @param codecFactory Creates the codec to use. This is called on the background thread.
+	 * @param handler Receives decoded messages on the main thread. It won't be called after this instance is destroyed.
+	 */
+	BackgroundDecoder(EventService& eventService, CodecFactory codecFactory, MessagesHandler handler);
+
+	/**
+	 * @brief Dtor. Stops the background thread; any data not yet decoded is discarded.
+	 */
+	~BackgroundDecoder();
+
+	/**
+	 * @brief Queues raw data for decoding.
+	 * @param data Data received from the server.
+	 */
+	void push(std::string data);
+
+	/**
+	 * @brief Stops decoding, and stops passing messages to the handler, including those already decoded.
+	 *
+	 * Unlike destruction this can be done from within the handler.
+	 */
+	void stop();
+
+	/**
+	 * @brief Gets a factory which creates codecs of the same type as the supplied one.
+	 * @param codec An existing codec, as created by the Atlas negotiation.
+	 * @return A factory, or an empty function if the type of codec isn't known.
+	 */
+	static CodecFactory getFactoryFor(const Atlas::Codec& codec);
+
+private:
+	EventService& mEventService;
+	CodecFactory mCodecFactory;
+	MessagesHandler mHandler;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+
+	/**
+	 * Data waiting to be decoded, protected by mMutex.
+	 */
+	std::deque<std::string> mInput;
+
+	/**
+	 * True when the thread should exit, protected by mMutex.
+	 */
+	bool mShutdown;
+
+	/**
+	 * Prevents handlers already posted to the main thread from running after destruction.
+	 */
+	ActiveMarker mActiveMarker;
+
+	std::thread mThread;
+
+	void run();
+};
+
+}
+
+#endif //ERIS_BACKGROUNDDECODER_H
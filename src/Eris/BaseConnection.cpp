@@ -8,6 +8,12 @@
 
 #include "Log.h"
 #include "StreamSocket_impl.h"
+#ifdef ERIS_HAVE_IO_URING
+#include "UringStreamSocket.h"
+#endif
+#ifdef ERIS_HAVE_SHARED_MEMORY
+#include "SharedMemoryStreamSocket.h"
+#endif
 
 #include <Atlas/Codec.h>
 #include <Atlas/Net/Stream.h>
@@ -22,6 +28,31 @@ using namespace boost::asio;
 namespace Eris
 {
 
+namespace
+{
+template<typename SocketT>
+SocketT* createSocket(BaseConnection::Transport transport, io_service& io_service, const std::string& clientName,
+                      Atlas::Bridge& bridge, const StreamSocket::Callbacks& callbacks)
+{
+    if (transport == BaseConnection::Transport::IO_URING) {
+#ifdef ERIS_HAVE_IO_URING
+        try {
+            return new UringStreamSocket<SocketT>(io_service, clientName, bridge, callbacks);
+        } catch (const NetworkFailure& e) {
+            //Happens if the kernel doesn't support io_uring, or it's been disabled.
+            warning() << "Could not use io_uring, falling back to asio: " << e.what();
+        }
+#else
+        warning() << "Eris was built without io_uring support, falling back to asio.";
+#endif
+    }
+    if (transport == BaseConnection::Transport::SHARED_MEMORY) {
+        warning() << "Shared memory can only be used for local connections on Linux, falling back to asio.";
+    }
+    return new SocketT(io_service, clientName, bridge, callbacks);
+}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////    
 
 BaseConnection::BaseConnection(io_service& io_service,
@@ -33,7 +64,10 @@ BaseConnection::BaseConnection(io_service& io_service,
 		_id(std::move(id)),
 		_clientName(std::move(clientName)),
 		_bridge(nullptr),
-		_port(0) {
+		_port(0),
+		_sendHighWatermark(256 * 1024),
+		_sendLowWatermark(64 * 1024),
+		_transport(Transport::ASIO) {
 	if (!_factories->hasFactory("sys")) {
 		Atlas::Objects::Entity::SYS_NO = _factories->addFactory("sys",
 													   &Atlas::Objects::factory<Atlas::Objects::Entity::SysData>, &Atlas::Objects::defaultInstance<Atlas::Objects::Entity::SysData>);
@@ -67,9 +101,14 @@ int BaseConnection::connectRemote(const std::string & host, short port)
                 ((ResolvableAsioStreamSocket<ip::tcp>*)_socket.get())->getAsioSocket().set_option(ip::tcp::no_delay(true));
             }
             this->stateChanged(state);};
-        auto socket = new ResolvableAsioStreamSocket<ip::tcp>(_io_service, _clientName,
+        callbacks.congestionChanged = [&](bool congested) {this->onCongestionChanged(congested);};
+        auto socket = createSocket<ResolvableAsioStreamSocket<ip::tcp>>(_transport, _io_service, _clientName,
                 *_bridge, callbacks);
         _socket.reset(socket);
+        _socket->setWriteWatermarks(_sendHighWatermark, _sendLowWatermark);
+        _socket->setCompression(_compression);
+        _socket->setCodecPreference(_codecPreference);
+        _socket->setCapture(_capture);
         std::stringstream ss;
         ss << port;
         ip::tcp::resolver::query query(host, ss.str());
@@ -98,9 +137,22 @@ int BaseConnection::connectLocal(const std::string & filename)
         callbacks.dispatch = [&] {this->dispatch();};
         callbacks.stateChanged =
                 [&](StreamSocket::Status state) {this->stateChanged(state);};
-        auto socket = new AsioStreamSocket<local::stream_protocol>(
-                _io_service, _clientName, *_bridge, callbacks);
+        callbacks.congestionChanged = [&](bool congested) {this->onCongestionChanged(congested);};
+        AsioStreamSocket<local::stream_protocol>* socket = nullptr;
+#ifdef ERIS_HAVE_SHARED_MEMORY
+        if (_transport == Transport::SHARED_MEMORY) {
+            socket = new SharedMemoryStreamSocket(_io_service, _clientName, *_bridge, callbacks);
+        }
+#endif
+        if (!socket) {
+            socket = createSocket<AsioStreamSocket<local::stream_protocol>>(_transport,
+                    _io_service, _clientName, *_bridge, callbacks);
+        }
         _socket.reset(socket);
+        _socket->setWriteWatermarks(_sendHighWatermark, _sendLowWatermark);
+        _socket->setCompression(_compression);
+        _socket->setCodecPreference(_codecPreference);
+        _socket->setCapture(_capture);
         setStatus(CONNECTING);
         socket->connect(local::stream_protocol::endpoint(filename));
     } catch (const std::exception& e) {
@@ -111,6 +163,34 @@ int BaseConnection::connectLocal(const std::string & filename)
 #endif
 }
 
+int BaseConnection::connectReplay(std::shared_ptr<CaptureReader> capture, ReplayStreamSocket::Pacing pacing)
+{
+    if (_socket) {
+        _socket->detach();
+        _socket.reset();
+    }
+    try {
+        StreamSocket::Callbacks callbacks;
+        callbacks.dispatch = [&] {this->dispatch();};
+        callbacks.stateChanged =
+                [&](StreamSocket::Status state) {this->stateChanged(state);};
+        callbacks.congestionChanged = [&](bool congested) {this->onCongestionChanged(congested);};
+        auto socket = std::make_shared<ReplayStreamSocket>(_io_service, _clientName, *_bridge, callbacks,
+                std::move(capture), pacing);
+        _socket = socket;
+        _socket->setWriteWatermarks(_sendHighWatermark, _sendLowWatermark);
+        _socket->setCompression(_compression);
+        _socket->setCodecPreference(_codecPreference);
+        setStatus(CONNECTING);
+        socket->connect();
+    } catch (const std::exception& e) {
+        error() << "Error when trying to replay capture: " << e.what();
+        hardDisconnect(true);
+        return -1;
+    }
+    return 0;
+}
+
 void BaseConnection::stateChanged(StreamSocket::Status status)
 {
     switch (status) {
@@ -170,6 +250,34 @@ void BaseConnection::onConnect()
     Connected.emit();
 }
 
+void BaseConnection::onCongestionChanged(bool)
+{
+}
+
+void BaseConnection::setSendWatermarks(std::size_t high, std::size_t low)
+{
+    _sendHighWatermark = high;
+    _sendLowWatermark = low;
+    if (_socket) {
+        _socket->setWriteWatermarks(high, low);
+    }
+}
+
+void BaseConnection::setCompression(std::shared_ptr<StreamCompression> compression)
+{
+    _compression = std::move(compression);
+}
+
+void BaseConnection::setCodecPreference(std::vector<std::string> codecs)
+{
+    _codecPreference = std::move(codecs);
+}
+
+void BaseConnection::setCapture(std::shared_ptr<CaptureWriter> capture)
+{
+    _capture = std::move(capture);
+}
+
 void BaseConnection::onConnectTimeout()
 {
     std::ostringstream os;
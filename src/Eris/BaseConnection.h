@@ -2,6 +2,7 @@
 #define ERIS_BASE_CONNECTION_H
 
 #include "StreamSocket.h"
+#include "ReplayStreamSocket.h"
 
 #include <Atlas/Objects/ObjectsFwd.h>
 #include <Atlas/Negotiate.h>
@@ -12,6 +13,7 @@
 #include <boost/asio/io_service.hpp>
 
 #include <string>
+#include <vector>
 #include <memory>
 #include <functional>
 
@@ -34,6 +36,7 @@ namespace Eris
 // Forward declarations 
 
 class StreamSocket;
+class StreamCompression;
 	
 /// Underlying Atlas connection, providing a send interface, and receive (dispatch) system
 class BaseConnection : virtual public sigc::trackable
@@ -51,6 +54,12 @@ public:
      */
     virtual int connectLocal(const std::string &socket);
 
+    /**
+     * Replay a captured session instead of connecting to a server.
+     * @see ReplayStreamSocket
+     */
+    virtual int connectReplay(std::shared_ptr<CaptureReader> capture, ReplayStreamSocket::Pacing pacing);
+
     /// possible states for the connection
     typedef enum {
         INVALID_STATUS = 0,	///< indicates an illegal state
@@ -64,6 +73,18 @@ public:
         QUERY_GET		///< meta-query performing GET operation
     } Status;
 
+    /// the mechanism used for reading from and writing to the socket
+    enum class Transport {
+        ASIO,		///< boost::asio, available everywhere
+        IO_URING,	///< Linux io_uring, if Eris was built with it; otherwise falls back to ASIO
+        /**
+         * Rings in shared memory, for local sockets on Linux; TCP connections and other platforms fall back to ASIO.
+         * The server must support it: if it rejects the handshake negotiation fails, and if it doesn't know the
+         * handshake it never answers, so the connection fails once the negotiate timeout expires.
+         */
+        SHARED_MEMORY
+    };
+
     /// get the current status of the connection
     Status getStatus() const
     { return _status; }
@@ -91,6 +112,41 @@ public:
 
 	const Atlas::Objects::Factories& getFactories() const;
 
+    /**
+     * @brief Sets the limits for how much outgoing data can be queued before the connection is considered congested.
+     *
+     * These apply to the current socket as well as any created when reconnecting.
+     * @see StreamSocket::setWriteWatermarks
+     */
+    void setSendWatermarks(std::size_t high, std::size_t low);
+
+    /**
+     * @brief Sets a compression layer to use for the connection, after the Atlas negotiation.
+     *
+     * Compression isn't part of the Atlas negotiation, so this should only be used when the server is known
+     * to expect it, such as for local socket setups. Takes effect on the next connection attempt.
+     * @param compression A compression layer, or null to disable compression.
+     */
+    void setCompression(std::shared_ptr<StreamCompression> compression);
+
+    /**
+     * @brief Sets the codecs to offer the server during the Atlas negotiation, in order of preference.
+     *
+     * Takes effect on the next connection attempt.
+     * @param codecs Codec names, such as "Packed", "Bach" or "XML". An empty list lets Atlas offer all codecs.
+     * @see StreamSocket::setCodecPreference
+     */
+    void setCodecPreference(std::vector<std::string> codecs);
+
+    /**
+     * @brief Records all data received from the server into a capture file, which can later be replayed.
+     *
+     * Takes effect on the next connection attempt.
+     * @param capture A capture file, or null to stop capturing.
+     * @see connectReplay
+     */
+    void setCapture(std::shared_ptr<CaptureWriter> capture);
+
     /// sent on successful negotiation of a game server connection
     sigc::signal<void()> Connected;
     
@@ -118,6 +174,9 @@ protected:
 
     virtual void dispatch() = 0;
 
+    /// derived-class notification when the socket becomes congested, or stops being congested
+    virtual void onCongestionChanged(bool congested);
+
     void onConnectTimeout();
     void onNegotiateTimeout();
     
@@ -140,6 +199,17 @@ protected:
 	
     std::string _host;	///< the host name we're connected to
     short _port;	///< the port we're connected to
+
+    std::size_t _sendHighWatermark; ///< see setSendWatermarks()
+    std::size_t _sendLowWatermark; ///< see setSendWatermarks()
+
+    std::shared_ptr<StreamCompression> _compression; ///< see setCompression()
+
+    std::vector<std::string> _codecPreference; ///< see setCodecPreference()
+
+    std::shared_ptr<CaptureWriter> _capture; ///< see setCapture()
+
+    Transport _transport; ///< the transport used for new sockets
 };
 		
 }	
@@ -0,0 +1,160 @@
+#include "Capture.h"
+#include "Exceptions.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+namespace Eris
+{
+
+namespace
+{
+
+const char capture_magic[8] = {'E', 'R', 'I', 'S', 'C', 'A', 'P', '\0'};
+const std::size_t header_size = 24;
+const std::size_t record_header_size = 12;
+
+template<typename T>
+void encode(char* target, T value)
+{
+	for (std::size_t i = 0; i < sizeof(T); ++i) {
+		target[i] = static_cast<char>((static_cast<std::uint64_t>(value) >> (i * 8)) & 0xff);
+	}
+}
+
+template<typename T>
+T decode(const char* source)
+{
+	std::uint64_t value = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i) {
+		value |= static_cast<std::uint64_t>(static_cast<unsigned char>(source[i])) << (i * 8);
+	}
+	return static_cast<T>(value);
+}
+
+}
+
+CaptureWriter::CaptureWriter(const std::string& path) :
+		mFile(path, std::ios::binary | std::ios::trunc),
+		mStart(std::chrono::steady_clock::now()),
+		mRecordCount(0)
+{
+	if (!mFile) {
+		throw BaseException("Could not open capture file '" + path + "' for writing.");
+	}
+	std::array<char, header_size> header{};
+	std::memcpy(header.data(), capture_magic, sizeof(capture_magic));
+	encode(header.data() + 8, VERSION);
+	encode(header.data() + 12, std::uint32_t(0));
+	encode(header.data() + 16, static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count()));
+	mFile.write(header.data(), header.size());
+}
+
+CaptureWriter::~CaptureWriter() = default;
+
+void CaptureWriter::writeRecordHeader(std::size_t length)
+{
+	std::array<char, record_header_size> header{};
+	encode(header.data(), static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - mStart).count()));
+	encode(header.data() + 8, static_cast<std::uint32_t>(length));
+	mFile.write(header.data(), header.size());
+}
+
+void CaptureWriter::flush()
+{
+	mFile.flush();
+}
+
+CaptureReader::CaptureReader(const std::string& path) :
+		mData(nullptr),
+		mSize(0),
+		mPosition(header_size),
+		mMapping(nullptr)
+{
+#ifndef _WIN32
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw BaseException("Could not open capture file '" + path + "': " + std::strerror(errno));
+	}
+	struct stat status{};
+	if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+		mSize = static_cast<std::size_t>(status.st_size);
+		auto mapping = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			mMapping = mapping;
+			mData = static_cast<const char*>(mapping);
+		}
+	}
+	::close(fd);
+#endif
+	if (!mData) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			throw BaseException("Could not open capture file '" + path + "'.");
+		}
+		mContents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		mData = mContents.data();
+		mSize = mContents.size();
+	}
+
+	if (mSize < header_size || std::memcmp(mData, capture_magic, sizeof(capture_magic)) != 0) {
+		unmap();
+		throw BaseException("'" + path + "' is not a capture file.");
+	}
+	auto version = decode<std::uint32_t>(mData + 8);
+	if (version != CaptureWriter::VERSION) {
+		unmap();
+		throw BaseException("Capture file '" + path + "' has unsupported version " + std::to_string(version) + ".");
+	}
+	mStartTime = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+			std::chrono::nanoseconds(decode<std::int64_t>(mData + 16))));
+}
+
+CaptureReader::~CaptureReader()
+{
+	unmap();
+}
+
+void CaptureReader::unmap()
+{
+#ifndef _WIN32
+	if (mMapping) {
+		::munmap(mMapping, mSize);
+		mMapping = nullptr;
+	}
+#endif
+}
+
+bool CaptureReader::next(Record& record)
+{
+	if (mSize - mPosition < record_header_size) {
+		return false;
+	}
+	auto length = decode<std::uint32_t>(mData + mPosition + 8);
+	if (mSize - mPosition - record_header_size < length) {
+		return false;
+	}
+	record.time = std::chrono::nanoseconds(decode<std::uint64_t>(mData + mPosition));
+	record.data = mData + mPosition + record_header_size;
+	record.size = length;
+	mPosition += record_header_size + length;
+	return true;
+}
+
+void CaptureReader::rewind()
+{
+	mPosition = header_size;
+}
+
+}
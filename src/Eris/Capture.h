@@ -0,0 +1,146 @@
+#ifndef ERIS_CAPTURE_H
+#define ERIS_CAPTURE_H
+
+#include <boost/asio/buffer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Eris
+{
+
+/**
+ * @brief Writes the data received on a connection to a capture file, so that the session can be replayed later.
+ *
+ * The file starts with a header of 24 bytes: the magic "ERISCAP" followed by a zero byte, a 32 bit version number,
+ * 32 reserved bits, and the wall clock time the capture was started, as signed 64 bit nanoseconds since the Unix epoch.
+ *
+ * It's followed by one record per read from the socket: the time since the capture was started as unsigned 64 bit
+ * nanoseconds, the length of the data as an unsigned 32 bit value, and the data itself. All numbers are little endian.
+ * Records aren't padded, so the file can be mapped into memory and read in place, as CaptureReader does.
+ *
+ * The data is captured exactly as received, including the Atlas negotiation and any compression.
+ */
+class CaptureWriter
+{
+public:
+	static const std::uint32_t VERSION = 1;
+
+	/**
+	 * @brief Creates the capture file, replacing any existing file.
+	 * @throws BaseException If the file can't be written.
+	 */
+	explicit CaptureWriter(const std::string& path);
+
+	~CaptureWriter();
+
+	/**
+	 * @brief Adds a record with the data, timestamped with the current time.
+	 */
+	template<typename ConstBufferSequence>
+	void record(const ConstBufferSequence& buffers);
+
+	/**
+	 * @brief Writes any buffered records to the file.
+	 */
+	void flush();
+
+	std::uint64_t getRecordCount() const;
+
+private:
+	std::ofstream mFile;
+	std::chrono::steady_clock::time_point mStart;
+	std::uint64_t mRecordCount;
+
+	void writeRecordHeader(std::size_t length);
+};
+
+/**
+ * @brief Reads a capture file written by CaptureWriter.
+ *
+ * The file is mapped into memory, and the records point straight into the mapping.
+ */
+class CaptureReader
+{
+public:
+
+	struct Record
+	{
+		std::chrono::nanoseconds time; ///< time since the capture was started
+		const char* data;
+		std::size_t size;
+	};
+
+	/**
+	 * @brief Opens the capture file.
+	 * @throws BaseException If the file can't be read, or isn't a capture file.
+	 */
+	explicit CaptureReader(const std::string& path);
+
+	~CaptureReader();
+
+	CaptureReader(const CaptureReader&) = delete;
+
+	CaptureReader& operator=(const CaptureReader&) = delete;
+
+	/**
+	 * @brief Gets the next record.
+	 *
+	 * A truncated record at the end of the file, as left if the capturing process died, is ignored.
+	 * @param record Filled in with the record.
+	 * @return False if there are no more records.
+	 */
+	bool next(Record& record);
+
+	/**
+	 * @brief Starts over from the first record.
+	 */
+	void rewind();
+
+	/**
+	 * @brief Gets the wall clock time at which the capture was started.
+	 */
+	std::chrono::system_clock::time_point getStartTime() const;
+
+private:
+	const char* mData;
+	std::size_t mSize;
+	std::size_t mPosition;
+	std::chrono::system_clock::time_point mStartTime;
+
+	/**
+	 * The mapping of the file, or null if it had to be read into mContents instead.
+	 */
+	void* mMapping;
+	std::vector<char> mContents;
+
+	void unmap();
+};
+
+template<typename ConstBufferSequence>
+void CaptureWriter::record(const ConstBufferSequence& buffers)
+{
+	writeRecordHeader(boost::asio::buffer_size(buffers));
+	for (auto I = boost::asio::buffer_sequence_begin(buffers); I != boost::asio::buffer_sequence_end(buffers); ++I) {
+		boost::asio::const_buffer buffer(*I);
+		mFile.write(static_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	}
+	mRecordCount++;
+}
+
+inline std::uint64_t CaptureWriter::getRecordCount() const
+{
+	return mRecordCount;
+}
+
+inline std::chrono::system_clock::time_point CaptureReader::getStartTime() const
+{
+	return mStartTime;
+}
+
+}
+
+#endif //ERIS_CAPTURE_H
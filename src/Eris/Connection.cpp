@@ -12,6 +12,9 @@
 #include "Response.h"
 #include "EventService.h"
 #include "TypeService.h"
+#include "BackgroundDecoder.h"
+#include "WaitFreeQueue.h"
+#include "OpDispatchTable.h"
 
 #include <Atlas/Objects/Encoder.h>
 #include <Atlas/Objects/Operation.h>
@@ -22,6 +25,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <iterator>
 
 #define ATLAS_LOG 0
 
@@ -49,36 +53,92 @@ Connection::Connection(boost::asio::io_service& io_service,
 					   EventService& eventService,
 					   std::string clientName,
 					   const std::string& host,
-					   short port) :
+					   short port,
+					   Transport transport) :
 		BaseConnection(io_service, std::move(clientName), "game_"),
 		m_decoder(new ConnectionDecoder(*this, *_factories)),
 		_eventService(eventService),
+		m_currentLane(0),
+		m_laneCredit(0),
+		m_queuedOps(0),
 		m_typeService(new TypeService(*this)),
 		m_defaultRouter(nullptr),
 		m_lock(0),
 		m_info{host},
-		m_responder(new ResponseTracker) {
+		m_responder(new ResponseTracker),
+		m_opsReceived(0),
+		m_opsSent(0),
+		m_corked(false),
+		m_corkMaxLatency(std::chrono::steady_clock::duration::zero()),
+		m_flushScheduled(false),
+		m_flushTimer(io_service),
+		m_congestionPolicy(CongestionPolicy::QUEUE_ALL),
+		m_opsReplaced(0),
+		m_backgroundDecoding(false),
+		m_replayPacing(ReplayStreamSocket::Pacing::ORIGINAL),
+		m_autoReconnect(false),
+		m_reconnectDelay(std::chrono::seconds(2)),
+		m_reconnecting(false),
+		m_disconnectRequested(false),
+		m_reconnectTimer(io_service),
+		m_dispatchResume(DispatchResume::EVENT_SERVICE),
+		m_dispatchScheduled(false),
+		m_maxQueueDepth(0),
+		m_dispatchDeferrals(0),
+		m_responseExpiryTimer(io_service),
+		m_outgoingMessages(new WaitFreeQueue<Atlas::Message::MapType>()),
+		m_outgoingScheduled(false) {
+	setDispatchLanes({DispatchLane{"all", 1}}, nullptr);
 	_bridge = m_decoder.get();
 	_host = host;
 	_port = port;
+	_transport = transport;
 }
 
 Connection::Connection(boost::asio::io_service& io_service,
 					   EventService& eventService,
 					   std::string clientName,
-					   std::string socket) :
+					   std::string socket,
+					   Transport transport) :
 		BaseConnection(io_service, std::move(clientName), "game_"),
 		m_decoder(new ConnectionDecoder(*this, *_factories)),
 		_eventService(eventService),
 		_localSocket(std::move(socket)),
+		m_currentLane(0),
+		m_laneCredit(0),
+		m_queuedOps(0),
 		m_typeService(new TypeService(*this)),
 		m_defaultRouter(nullptr),
 		m_lock(0),
 		m_info{_host},
-		m_responder(new ResponseTracker) {
+		m_responder(new ResponseTracker),
+		m_opsReceived(0),
+		m_opsSent(0),
+		m_corked(false),
+		m_corkMaxLatency(std::chrono::steady_clock::duration::zero()),
+		m_flushScheduled(false),
+		m_flushTimer(io_service),
+		m_congestionPolicy(CongestionPolicy::QUEUE_ALL),
+		m_opsReplaced(0),
+		m_backgroundDecoding(false),
+		m_replayPacing(ReplayStreamSocket::Pacing::ORIGINAL),
+		m_autoReconnect(false),
+		m_reconnectDelay(std::chrono::seconds(2)),
+		m_reconnecting(false),
+		m_disconnectRequested(false),
+		m_reconnectTimer(io_service),
+		m_dispatchResume(DispatchResume::EVENT_SERVICE),
+		m_dispatchScheduled(false),
+		m_maxQueueDepth(0),
+		m_dispatchDeferrals(0),
+		m_responseExpiryTimer(io_service),
+		m_outgoingMessages(new WaitFreeQueue<Atlas::Message::MapType>()),
+		m_outgoingScheduled(false) {
+	setDispatchLanes({DispatchLane{"all", 1}}, nullptr);
 	_bridge = m_decoder.get();
 	_host = "local";
 	_port = 0;
+	_transport = transport;
 }
 
 
@@ -86,7 +146,16 @@ Connection::~Connection() {
 	// ensure we emit this before our vtable goes down, since we are the
 	// Bridge on the underlying Atlas codec, and otherwise we might get
 	// a pure virtual method call
+	m_autoReconnect = false;
+	m_disconnectRequested = true;
 	hardDisconnect(true);
+
+	auto node = m_outgoingMessages->pop_all_reverse();
+	while (node) {
+		auto next = node->next;
+		delete node;
+		node = next;
+	}
 }
 
 EventService& Connection::getEventService() {
@@ -94,6 +163,19 @@ EventService& Connection::getEventService() {
 }
 
 int Connection::connect() {
+	m_reconnectTimer.cancel();
+	m_disconnectRequested = false;
+	m_opsReceived = 0;
+	m_opsSent = 0;
+	m_opsReplaced = 0;
+	m_heldOps.clear();
+	m_heldOpIndex.clear();
+	//Ops left from an earlier connection are of no use anymore.
+	clearQueuedOps();
+	if (m_replay) {
+		m_replay->rewind();
+		return BaseConnection::connectReplay(m_replay, m_replayPacing);
+	}
 	if (!_localSocket.empty()) {
 		return BaseConnection::connectLocal(_localSocket);
 	}
@@ -103,6 +185,15 @@ int Connection::connect() {
 }
 
 int Connection::disconnect() {
+	m_disconnectRequested = true;
+	if (m_reconnecting) {
+		m_reconnecting = false;
+		m_reconnectTimer.cancel();
+		if (_status == DISCONNECTED) {
+			return 0;
+		}
+	}
+
 	if (_status == DISCONNECTING) {
 		warning() << "duplicate disconnect on Connection that's already disconnecting";
 		return -1;
@@ -145,16 +236,210 @@ int Connection::disconnect() {
 }
 
 void Connection::dispatch() {
+	dispatchQueued(m_dispatchBudget);
+	if (m_queuedOps != 0 && m_dispatchResume == DispatchResume::EVENT_SERVICE && !m_dispatchScheduled) {
+		m_dispatchScheduled = true;
+		_eventService.runOnMainThread([this]() {
+			m_dispatchScheduled = false;
+			dispatch();
+		}, m_activeMarker);
+	}
+}
+
+std::size_t Connection::pump(DispatchBudget budget) {
+	return dispatchQueued(budget);
+}
+
+std::size_t Connection::dispatchQueued(const DispatchBudget& budget) {
+	auto hasTimeLimit = budget.time != std::chrono::steady_clock::duration::zero();
+	auto deadline = hasTimeLimit ? std::chrono::steady_clock::now() + budget.time : std::chrono::steady_clock::time_point();
+	std::size_t count = 0;
 
 	// now dispatch received ops
-	while (!m_opDeque.empty()) {
-		RootOperation op = std::move(m_opDeque.front());
-		m_opDeque.pop_front();
-		dispatchOp(op);
+	while (m_queuedOps != 0) {
+		if (count > 0 && ((budget.ops != 0 && count >= budget.ops) || (hasTimeLimit && std::chrono::steady_clock::now() >= deadline))) {
+			m_dispatchDeferrals++;
+			break;
+		}
+		auto queued = takeOp();
+		dispatchOp(queued.op, queued.from, queued.to);
+		++count;
 	}
 
 	// finally, clean up any redispatches that fired (aka 'deleteLater')
 	m_finishedRedispatches.clear();
+	return count;
+}
+
+void Connection::queueOp(RootOperation op) {
+	auto from = op->isDefaultFrom() ? IdInterner::INVALID_HANDLE : m_idInterner.find(op->getFrom());
+	auto to = op->isDefaultTo() ? IdInterner::INVALID_HANDLE : m_idInterner.find(op->getTo());
+	queueOp(QueuedOp{std::move(op), std::chrono::steady_clock::now(), from, to, std::string()});
+}
+
+void Connection::queueOp(QueuedOp queued) {
+	auto classify = [&](const RootOperation& op) -> std::size_t {
+		if (!m_classifier) {
+			return 0;
+		}
+		return std::min(m_classifier(op), m_lanes.size() - 1);
+	};
+
+	std::size_t lane = 0;
+	if (m_lanes.size() > 1) {
+		auto& op = queued.op;
+		const std::string* entity = nullptr;
+		if (!op->isDefaultFrom()) {
+			entity = &op->getFrom();
+		} else if (!op->getArgs().empty() && !op->getArgs().front()->isDefaultId()) {
+			entity = &op->getArgs().front()->getId();
+		}
+		if (entity && !entity->empty()) {
+			//Keep the ops of an entity in one lane while any are queued, so they can't overtake each other.
+			auto I = m_entityLanes.find(*entity);
+			if (I != m_entityLanes.end()) {
+				lane = I->second.lane;
+				I->second.queued++;
+			} else {
+				lane = classify(op);
+				m_entityLanes.emplace(*entity, EntityLane{lane, 1});
+			}
+			queued.entity = *entity;
+		} else {
+			lane = classify(op);
+		}
+	}
+	m_lanes[lane].ops.push_back(std::move(queued));
+	m_queuedOps++;
+	m_maxQueueDepth = std::max(m_maxQueueDepth, m_queuedOps);
+}
+
+Connection::QueuedOp Connection::takeOp() {
+	//Each lane dispatches as many ops as its weight, before it's the turn of the next lane which has any.
+	while (m_laneCredit == 0 || m_lanes[m_currentLane].ops.empty()) {
+		m_currentLane = (m_currentLane + 1) % m_lanes.size();
+		m_laneCredit = m_lanes[m_currentLane].config.weight;
+	}
+	m_laneCredit--;
+
+	auto& lane = m_lanes[m_currentLane];
+	QueuedOp queued = std::move(lane.ops.front());
+	lane.ops.pop_front();
+	m_queuedOps--;
+	if (!queued.entity.empty()) {
+		auto I = m_entityLanes.find(queued.entity);
+		if (I != m_entityLanes.end() && --I->second.queued == 0) {
+			m_entityLanes.erase(I);
+		}
+	}
+
+	auto latency = std::chrono::steady_clock::now() - queued.arrived;
+	lane.statistics.dispatched++;
+	lane.statistics.totalLatency += latency;
+	lane.statistics.maxLatency = std::max(lane.statistics.maxLatency, latency);
+	return queued;
+}
+
+void Connection::clearQueuedOps() {
+	for (auto& lane : m_lanes) {
+		lane.ops.clear();
+	}
+	m_entityLanes.clear();
+	m_queuedOps = 0;
+}
+
+void Connection::setDispatchLanes(std::vector<DispatchLane> lanes, OpClassifier classifier) {
+	if (lanes.empty()) {
+		throw InvalidOperation("At least one dispatch lane is needed");
+	}
+
+	//Sort the queued ops into the new lanes, in the order they arrived.
+	std::vector<QueuedOp> queued;
+	queued.reserve(m_queuedOps);
+	for (auto& lane : m_lanes) {
+		std::move(lane.ops.begin(), lane.ops.end(), std::back_inserter(queued));
+	}
+	std::stable_sort(queued.begin(), queued.end(), [](const QueuedOp& lhs, const QueuedOp& rhs) {
+		return lhs.arrived < rhs.arrived;
+	});
+
+	m_lanes.clear();
+	for (auto& config : lanes) {
+		Lane lane{std::move(config), OpDeque(), LaneStatistics()};
+		lane.config.weight = std::max(lane.config.weight, 1U);
+		lane.statistics.name = lane.config.name;
+		m_lanes.push_back(std::move(lane));
+	}
+	m_classifier = std::move(classifier);
+	m_entityLanes.clear();
+	m_queuedOps = 0;
+	m_currentLane = 0;
+	m_laneCredit = m_lanes.front().config.weight;
+
+	for (auto& op : queued) {
+		op.entity.clear();
+		queueOp(std::move(op));
+	}
+}
+
+void Connection::useDefaultDispatchLanes() {
+	setDispatchLanes({DispatchLane{"responses", 8},
+					  DispatchLane{"avatar", 4},
+					  DispatchLane{"movement", 2},
+					  DispatchLane{"other", 1}},
+					 [this](const RootOperation& op) { return classifyOp(op); });
+}
+
+std::size_t Connection::classifyOp(const RootOperation& op) const {
+	if (!op->isDefaultRefno() && m_responder->isAwaiting(op->getRefno())) {
+		return LANE_RESPONSES;
+	}
+	if (!op->isDefaultFrom() && m_toRouters.count(m_idInterner.find(op->getFrom())) != 0) {
+		return LANE_AVATAR;
+	}
+	if (op->getClassNo() == SIGHT_NO && !op->getArgs().empty()) {
+		auto argClassNo = op->getArgs().front()->getClassNo();
+		if (argClassNo == SET_NO || argClassNo == MOVE_NO) {
+			return LANE_MOVEMENT;
+		}
+	}
+	return LANE_OTHER;
+}
+
+std::vector<Connection::LaneStatistics> Connection::getLaneStatistics() const {
+	std::vector<LaneStatistics> statistics;
+	statistics.reserve(m_lanes.size());
+	for (auto& lane : m_lanes) {
+		statistics.push_back(lane.statistics);
+		statistics.back().depth = lane.ops.size();
+	}
+	return statistics;
+}
+
+std::chrono::steady_clock::duration Connection::LaneStatistics::getAverageLatency() const {
+	if (dispatched == 0) {
+		return std::chrono::steady_clock::duration::zero();
+	}
+	return totalLatency / static_cast<std::chrono::steady_clock::duration::rep>(dispatched);
+}
+
+void Connection::setDispatchBudget(DispatchBudget budget, DispatchResume resume) {
+	m_dispatchBudget = budget;
+	m_dispatchResume = resume;
+}
+
+Connection::DispatchQueueStatistics Connection::getDispatchQueueStatistics() const {
+	DispatchQueueStatistics statistics;
+	statistics.depth = m_queuedOps;
+	statistics.maxDepth = m_maxQueueDepth;
+	auto now = std::chrono::steady_clock::now();
+	for (auto& lane : m_lanes) {
+		if (!lane.ops.empty()) {
+			statistics.oldestAge = std::max(statistics.oldestAge, now - lane.ops.front().arrived);
+		}
+	}
+	statistics.deferrals = m_dispatchDeferrals;
+	return statistics;
 }
 
 void Connection::send(const Atlas::Objects::Root& obj) {
@@ -180,25 +465,200 @@ void Connection::send(const Atlas::Objects::Root& obj) {
 	debug() << "sending:" << debugStream.str();
 #endif
 
+	if (m_congestionPolicy == CongestionPolicy::REPLACE_SUPERSEDED && _socket->isCongested()) {
+		holdOp(obj);
+		return;
+	}
+
+	encodeOp(obj);
+	if (m_corked) {
+		_socket->updateCongestion();
+		scheduleFlush();
+	} else {
+		_socket->write();
+	}
+}
+
+void Connection::sendFromAnyThread(Atlas::Message::MapType op) {
+	m_outgoingMessages->push(std::move(op));
+	if (!m_outgoingScheduled.exchange(true)) {
+		std::shared_ptr<bool> marker = m_activeMarker;
+		_io_service.post([this, marker]() {
+			if (*marker) {
+				sendOutgoingMessages();
+			}
+		});
+	}
+}
+
+void Connection::sendOutgoingMessages() {
+	//Clear the flag first, so that any op pushed after the queue has been taken schedules another round.
+	m_outgoingScheduled = false;
+	auto node = m_outgoingMessages->pop_all();
+	while (node) {
+		send(_factories->createObject(std::move(node->data)));
+		auto next = node->next;
+		delete node;
+		node = next;
+	}
+}
+
+void Connection::encodeOp(const Root& obj) {
 	_socket->getEncoder().streamObjectsMessage(obj);
-	_socket->write();
+	m_opsSent++;
+}
+
+void Connection::holdOp(const Root& obj) {
+	auto op = smart_dynamic_cast<RootOperation>(obj);
+	if (op.isValid() && op->isDefaultSerialno() && !op->getArgs().empty()) {
+		auto& arg = op->getArgs().front();
+		if (!arg->isDefaultId()) {
+			//Build a key from the kind of op, the entity and the attributes it touches.
+			std::string key = op->getParent() + '|' + op->getFrom() + '|' + op->getTo() + '|' + arg->getId();
+			for (auto& entry : arg->asMessage()) {
+				key += '|';
+				key += entry.first;
+			}
+			auto position = m_heldOps.insert(m_heldOps.end(), obj);
+			auto result = m_heldOpIndex.emplace(std::move(key), position);
+			if (!result.second) {
+				//The newer op goes last, so that it isn't sent ahead of ops which were held after the one it replaces.
+				m_heldOps.erase(result.first->second);
+				result.first->second = position;
+				m_opsReplaced++;
+			}
+			return;
+		}
+	}
+	m_heldOps.push_back(obj);
+}
+
+void Connection::sendHeldOps() {
+	if (m_heldOps.empty()) {
+		return;
+	}
+	auto heldOps = std::move(m_heldOps);
+	m_heldOps.clear();
+	m_heldOpIndex.clear();
+	if (_socket && isConnected()) {
+		for (auto& op : heldOps) {
+			encodeOp(op);
+		}
+		flush();
+	}
+}
+
+void Connection::onCongestionChanged(bool congested) {
+	SendCongested.emit(congested);
+	if (!congested) {
+		sendHeldOps();
+	}
+}
+
+void Connection::setCongestionPolicy(CongestionPolicy policy) {
+	m_congestionPolicy = policy;
+	if (m_congestionPolicy == CongestionPolicy::QUEUE_ALL) {
+		sendHeldOps();
+	}
+}
+
+bool Connection::isSendCongested() const {
+	return _socket && _socket->isCongested();
+}
+
+void Connection::setCorked(bool corked, std::chrono::steady_clock::duration maxLatency) {
+	m_corked = corked;
+	m_corkMaxLatency = maxLatency;
+	if (!m_corked) {
+		flush();
+	}
+}
+
+void Connection::flush() {
+	if (m_flushScheduled) {
+		m_flushScheduled = false;
+		m_flushTimer.cancel();
+	}
+	if (_socket) {
+		_socket->write();
+	}
+}
+
+void Connection::scheduleFlush() {
+	if (m_flushScheduled) {
+		return;
+	}
+	m_flushScheduled = true;
+	if (m_corkMaxLatency == std::chrono::steady_clock::duration::zero()) {
+		//Any handlers already queued will run before this, so all ops sent during this turn of the loop get included.
+		std::shared_ptr<bool> marker = m_activeMarker;
+		_io_service.post([this, marker]() {
+			if (*marker && m_flushScheduled) {
+				flush();
+			}
+		});
+	} else {
+		m_flushTimer.expires_from_now(m_corkMaxLatency);
+		m_flushTimer.async_wait([this](const boost::system::error_code& ec) {
+			if (!ec) {
+				flush();
+			}
+		});
+	}
 }
 
 void Connection::registerRouterForTo(Router* router, const std::string& toId) {
-	m_toRouters[toId] = router;
+	auto handle = m_idInterner.intern(toId);
+	registerRouterForTo(router, handle);
+	m_idInterner.release(handle);
 }
 
 void Connection::unregisterRouterForTo(Router* router, const std::string& toId) {
-	assert(m_toRouters[toId] == router);
-	m_toRouters.erase(toId);
+	unregisterRouterForTo(router, m_idInterner.find(toId));
 }
 
 void Connection::registerRouterForFrom(Router* router, const std::string& fromId) {
-	m_fromRouters[fromId] = router;
+	auto handle = m_idInterner.intern(fromId);
+	registerRouterForFrom(router, handle);
+	m_idInterner.release(handle);
 }
 
 void Connection::unregisterRouterForFrom(const std::string& fromId) {
-	m_fromRouters.erase(fromId);
+	unregisterRouterForFrom(m_idInterner.find(fromId));
+}
+
+//Each registered router holds a reference to its interned id, so that ids are released once nothing is
+//registered for them anymore.
+
+void Connection::registerRouterForTo(Router* router, IdInterner::Handle toId) {
+	if (m_toRouters.emplace(toId, router).second) {
+		m_idInterner.retain(toId);
+	} else {
+		m_toRouters[toId] = router;
+	}
+}
+
+void Connection::unregisterRouterForTo(Router* router, IdInterner::Handle toId) {
+	auto I = m_toRouters.find(toId);
+	if (I != m_toRouters.end()) {
+		assert(I->second == router);
+		m_toRouters.erase(I);
+		m_idInterner.release(toId);
+	}
+}
+
+void Connection::registerRouterForFrom(Router* router, IdInterner::Handle fromId) {
+	if (m_fromRouters.emplace(fromId, router).second) {
+		m_idInterner.retain(fromId);
+	} else {
+		m_fromRouters[fromId] = router;
+	}
+}
+
+void Connection::unregisterRouterForFrom(IdInterner::Handle fromId) {
+	if (m_fromRouters.erase(fromId) != 0) {
+		m_idInterner.release(fromId);
+	}
 }
 
 void Connection::setDefaultRouter(Router* router) {
@@ -227,8 +687,8 @@ void Connection::unlock() {
 		switch (_status) {
 			case DISCONNECTING:
 				debug() << "Connection unlocked in DISCONNECTING, closing socket";
-				debug() << "have " << m_opDeque.size() << " ops waiting";
-				m_opDeque.clear();
+				debug() << "have " << m_queuedOps << " ops waiting";
+				clearQueuedOps();
 				hardDisconnect(true);
 				break;
 
@@ -239,6 +699,38 @@ void Connection::unlock() {
 	}
 }
 
+Connection::IoStatistics Connection::getIoStatistics() const {
+	IoStatistics statistics;
+	if (_socket) {
+		statistics.socket = _socket->getStatistics();
+	}
+	statistics.opsReceived = m_opsReceived;
+	statistics.opsSent = m_opsSent;
+	statistics.opsReplaced = m_opsReplaced;
+	return statistics;
+}
+
+double Connection::IoStatistics::getReadSyscallsPerOp() const {
+	if (opsReceived == 0) {
+		return 0;
+	}
+	return static_cast<double>(socket.readSyscalls) / static_cast<double>(opsReceived);
+}
+
+std::uint64_t Connection::IoStatistics::getWriteSyscallsSaved() const {
+	if (opsSent < socket.writes) {
+		return 0;
+	}
+	return opsSent - socket.writes;
+}
+
+double Connection::IoStatistics::getOpsPerWrite() const {
+	if (socket.writes == 0) {
+		return 0;
+	}
+	return static_cast<double>(opsSent) / static_cast<double>(socket.writes);
+}
+
 void Connection::getServerInfo(ServerInfo& si) const {
 	si = m_info;
 }
@@ -265,17 +757,30 @@ void Connection::objectArrived(Root obj) {
 
 	debug() << "received:" << debugStream.str();
 #else
-	debug() << "received op:" << obj->getParent();
+	ERIS_DEBUG() << "received op:" << obj->getParent();
 #endif
 	auto op = smart_dynamic_cast<RootOperation>(obj);
 	if (op.isValid()) {
-		m_opDeque.push_back(std::move(op));
+		m_opsReceived++;
+		queueOp(std::move(op));
 	} else {
 		error() << "Con::objectArrived got non-op";
 	}
 }
 
 void Connection::dispatchOp(const RootOperation& op) {
+	dispatchOp(op, IdInterner::INVALID_HANDLE, IdInterner::INVALID_HANDLE);
+}
+
+void Connection::dispatchOp(const RootOperation& op, IdInterner::Handle from, IdInterner::Handle to) {
+	//Since the op was queued an earlier op might have caused the ids to be interned, or released, in which case
+	//the handles might have been handed out for other ids. Comparing the strings is cheaper than hashing them.
+	if (!op->isDefaultFrom() && (from == IdInterner::INVALID_HANDLE || m_idInterner.getId(from) != op->getFrom())) {
+		from = m_idInterner.find(op->getFrom());
+	}
+	if (!op->isDefaultTo() && (to == IdInterner::INVALID_HANDLE || m_idInterner.getId(to) != op->getTo())) {
+		to = m_idInterner.find(op->getTo());
+	}
 	try {
 		bool anonymous = op->isDefaultTo();
 
@@ -285,10 +790,10 @@ void Connection::dispatchOp(const RootOperation& op) {
 		}
 
 		// locate a router based on from
-		if (!op->isDefaultFrom()) {
-			auto R = m_fromRouters.find(op->getFrom());
+		if (from != IdInterner::INVALID_HANDLE) {
+			auto R = m_fromRouters.find(from);
 			if (R != m_fromRouters.end()) {
-				rr = R->second->handleOperation(op);
+				rr = R->second->routeOperation(op, from, to);
 				if (rr == Router::HANDLED) {
 					return;
 				}
@@ -297,20 +802,19 @@ void Connection::dispatchOp(const RootOperation& op) {
 
 		// locate a router based on the op's TO value
 		if (!anonymous) {
-			auto R = m_toRouters.find(op->getTo());
+			auto R = m_toRouters.find(to);
 			if (R != m_toRouters.end()) {
-				rr = R->second->handleOperation(op);
+				rr = R->second->routeOperation(op, from, to);
 				if (rr == Router::HANDLED) {
 					return;
 				}
 			} else if (!m_toRouters.empty()) {
-				warning() << "received op with TO=" << op->getTo() << ", but no router is registered for that id";
+				ERIS_WARNING_LIMITED() << "received op with TO=" << op->getTo() << ", but no router is registered for that id";
 			}
 		}
 
-		// special-case, server info refreshes are handled here directly
-		if (op->getClassNo() == INFO_NO && anonymous) {
-			handleServerInfo(op);
+		// special-case, anonymous ops such as server info refreshes are handled here directly
+		if (anonymous && getAnonymousOpHandlers().dispatch(*this, op) == Router::HANDLED) {
 			return;
 		}
 
@@ -319,7 +823,7 @@ void Connection::dispatchOp(const RootOperation& op) {
 			rr = m_defaultRouter->handleOperation(op);
 		}
 		if (rr != Router::HANDLED) {
-			warning() << "no-one handled op:" << op;
+			ERIS_WARNING_LIMITED() << "no-one handled op:" << op;
 		}
 	} catch (const Atlas::Exception& ae) {
 		error() << "caught Atlas exception: '" << ae.getDescription() <<
@@ -329,8 +833,40 @@ void Connection::dispatchOp(const RootOperation& op) {
 
 
 void Connection::setStatus(Status ns) {
+	//A connection which fails while established was lost; one which fails while being set up again was a failed attempt.
+	bool lost = false;
+	if (ns == DISCONNECTED) {
+		retireBackgroundDecoder();
+		//A failed attempt can pass through DISCONNECTING too (e.g. when negotiation times out), so only a
+		//disconnect asked for by the client stops reconnecting.
+		if (m_autoReconnect && !m_disconnectRequested && _status != DISCONNECTED) {
+			if (_status == CONNECTED) {
+				lost = !m_reconnecting;
+				m_reconnecting = true;
+			}
+			if (m_reconnecting) {
+				scheduleReconnect();
+			}
+		}
+	}
 	if (_status != ns) StatusChanged.emit(ns);
 	_status = ns;
+	if (lost) {
+		Reconnecting.emit();
+	}
+}
+
+void Connection::scheduleReconnect() {
+	debug() << "Trying to reconnect to " << _host << " shortly.";
+	m_reconnectTimer.expires_after(m_reconnectDelay);
+	m_reconnectTimer.async_wait([this](const boost::system::error_code& ec) {
+		if (ec || !m_reconnecting || _status != DISCONNECTED) {
+			return;
+		}
+		if (connect() != 0) {
+			scheduleReconnect();
+		}
+	});
 }
 
 void Connection::handleFailure(const std::string& msg) {
@@ -343,23 +879,100 @@ void Connection::handleTimeout(const std::string& msg) {
 	handleFailure(msg); // all the same in the end
 }
 
-void Connection::handleServerInfo(const RootOperation& op) {
+const OpDispatchTable<Connection>& Connection::getAnonymousOpHandlers() {
+	static const OpDispatchTable<Connection> handlers{
+			{INFO_NO, &Connection::handleServerInfo}
+	};
+	return handlers;
+}
+
+Router::RouterResult Connection::handleServerInfo(const RootOperation& op) {
 	if (!op->getArgs().empty()) {
 		auto svr = smart_dynamic_cast<RootEntity>(op->getArgs().front());
 		if (!svr.isValid()) {
 			error() << "server INFO argument object is broken";
-			return;
+			return Router::HANDLED;
 		}
 
 		m_info.processServer(svr);
 		GotServerInfo.emit();
 	}
+	return Router::HANDLED;
 }
 
 void Connection::onConnect() {
+	m_reconnecting = false;
+	retireBackgroundDecoder();
+	if (m_backgroundDecoding && _socket) {
+		auto codecFactory = BackgroundDecoder::getFactoryFor(_socket->getCodec());
+		if (codecFactory) {
+			m_backgroundDecoder = std::make_unique<BackgroundDecoder>(_eventService, std::move(codecFactory),
+																	  [this](std::vector<Atlas::Message::MapType> messages) {
+																		  messagesDecoded(std::move(messages));
+																	  });
+			auto decoder = m_backgroundDecoder.get();
+			_socket->setReceivedDataHandler([decoder](std::string data) { decoder->push(std::move(data)); });
+		} else {
+			warning() << "Could not decode in the background, since the codec is of an unknown type.";
+		}
+	}
 	BaseConnection::onConnect();
 	m_typeService->init();
 	m_info = ServerInfo{_host};
+	scheduleResponseExpiry();
+}
+
+void Connection::scheduleResponseExpiry() {
+	m_responseExpiryTimer.expires_from_now(m_responder->getTick());
+	m_responseExpiryTimer.async_wait([this](const boost::system::error_code& ec) {
+		if (ec) {
+			return;
+		}
+		m_responder->expire(std::chrono::steady_clock::now());
+		if (_status == CONNECTED) {
+			scheduleResponseExpiry();
+		}
+	});
+}
+
+void Connection::setBackgroundDecoding(bool enabled) {
+	m_backgroundDecoding = enabled;
+}
+
+void Connection::setReplay(std::shared_ptr<CaptureReader> capture, ReplayStreamSocket::Pacing pacing) {
+	m_replay = std::move(capture);
+	m_replayPacing = pacing;
+}
+
+void Connection::setAutoReconnect(bool enabled, std::chrono::steady_clock::duration delay) {
+	m_autoReconnect = enabled;
+	m_reconnectDelay = delay;
+	if (!enabled) {
+		m_reconnecting = false;
+		m_reconnectTimer.cancel();
+	}
+}
+
+void Connection::retireBackgroundDecoder() {
+	if (!m_backgroundDecoder) {
+		return;
+	}
+	//We might be called from within the handler of the decoder (e.g. when an op dispatched from it disconnects),
+	//so it's stopped now but destroyed once that has returned.
+	m_backgroundDecoder->stop();
+	std::shared_ptr<BackgroundDecoder> decoder(std::move(m_backgroundDecoder));
+	_eventService.runOnMainThread([decoder]() {});
+}
+
+void Connection::messagesDecoded(std::vector<Atlas::Message::MapType> messages) {
+	for (auto& message : messages) {
+		//Any op might disconnect us, after which the rest of the messages are of no use.
+		if (!isConnected()) {
+			return;
+		}
+		objectArrived(_factories->createObject(std::move(message)));
+	}
+	dispatch();
 }
 
 void Connection::onDisconnectTimeout() {
@@ -370,7 +983,7 @@ void Connection::onDisconnectTimeout() {
 void Connection::postForDispatch(const Root& obj) {
 	auto op = smart_dynamic_cast<RootOperation>(obj);
 	assert(op.isValid());
-	m_opDeque.push_back(op);
+	queueOp(op);
 
 #if ATLAS_LOG == 1
 	std::stringstream debugStream;
@@ -388,7 +1001,7 @@ void Connection::cleanupRedispatch(Redispatch* r) {
 }
 
 std::int64_t getNewSerialno() {
-	static std::int64_t _nextSerial = 1001;
+	static std::atomic<std::int64_t> _nextSerial(1001);
 	// note this will eventually loop (in theory), but that's okay
 	// FIXME - using the same intial starting offset is problematic
 	// if the client dies, and quickly reconnects
@@ -3,15 +3,25 @@
 
 #include "BaseConnection.h"
 #include "ServerInfo.h"
+#include "ActiveMarker.h"
+#include "IdInterner.h"
+#include "Router.h"
 
+#include <Atlas/Message/Element.h>
 #include <Atlas/Objects/Decoder.h>
 #include <Atlas/Objects/ObjectsFwd.h>
 #include <Atlas/Objects/RootOperation.h>
 
+#include <atomic>
 #include <deque>
+#include <functional>
+#include <list>
 #include <map>
 #include <unordered_map>
 #include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
 
 /** Every Eris class and type lives inside the Eris namespace; certain utility functions live in the
 Util namespace, since they may be moved to a generic WorldForge foundation library in the future.*/
@@ -25,7 +35,8 @@ class PollData;
 
 class TypeService;
 
-class Router;
+template<class T, class... Args>
+class OpDispatchTable;
 
 class Redispatch;
 
@@ -35,6 +46,11 @@ class TestInjector;
 
 class EventService;
 
+class BackgroundDecoder;
+
+template<typename T>
+class WaitFreeQueue;
+
 /// Underlying Atlas connection, providing a send interface, and receive (dispatch) system
 /** Connection tracks the life-time of a client-server session; note this may extend beyond
 a single TCP connection, if re-connections occur. */
@@ -49,21 +65,25 @@ public:
 	/** Create a new connection, with the client-name  string specified. The client-name
 	is sent during Atlas negotiation of the connection.
 	@param debug Perform extra (slower) validation on the connection
+	@param transport The mechanism used for socket I/O.
 	*/
 	Connection(boost::asio::io_service& io_service,
 			   EventService& eventService,
 			   std::string clientName,
 			   const std::string& host,
-			   short port);
+			   short port,
+			   Transport transport = Transport::ASIO);
 
 	/** Create a new connection, with the client-name  string specified. The client-name
 	is sent during Atlas negotiation of the connection.
 	@param debug Perform extra (slower) validation on the connection
+	@param transport The mechanism used for socket I/O.
 	*/
 	Connection(boost::asio::io_service& io_service,
 			   EventService& eventService,
 			   std::string clientName,
-			   std::string socket);
+			   std::string socket,
+			   Transport transport = Transport::ASIO);
 
 	~Connection() override;
 
@@ -87,6 +107,230 @@ public:
 	therefore validate the connection using IsConnected first */
 	virtual void send(const Atlas::Objects::Root& obj);
 
+	/**
+	 * @brief Sends an op from any thread.
+	 *
+	 * The op is handed to the thread running the io_service, which sends it with send() on its next turn.
+	 * Ops passed in by one thread are sent in the order they were passed in, though ops from different
+	 * threads may be interleaved. Ops which arrive while not connected are dropped, as with send().
+	 *
+	 * The op is passed as a message, since other threads can't safely create Atlas::Objects instances;
+	 * it's turned into an object on the io_service thread. getNewSerialno() can be called from any thread.
+	 * @param op The op, as a message.
+	 */
+	void sendFromAnyThread(Atlas::Message::MapType op);
+
+	/**
+	 * @brief Enables or disables "corked" sending.
+	 *
+	 * When corked, ops passed to send() are only encoded into the outgoing buffer, and are then all sent
+	 * in one write. That happens either when flush() is called, or at the latest when the max latency has passed.
+	 * With a max latency of zero the ops are sent once the current turn of the event loop has completed.
+	 * This allows ops sent from different parts of the client during a frame to be sent in a single segment.
+	 *
+	 * Disabling corked sending will flush any held ops.
+	 * @param corked True if ops should be held.
+	 * @param maxLatency The longest time an op will be held before being sent.
+	 */
+	void setCorked(bool corked, std::chrono::steady_clock::duration maxLatency = std::chrono::steady_clock::duration::zero());
+
+	/**
+	 * @brief Sends all ops held because of corked sending.
+	 */
+	void flush();
+
+	/**
+	 * @brief Enables or disables decoding of incoming data in a background thread.
+	 *
+	 * When enabled the Atlas parsing of incoming data is done in a separate thread, and the decoded messages
+	 * are handed back to the main thread through the EventService. Only the creation of the Atlas objects and
+	 * the dispatching of ops are then done on the main thread, which needs to call EventService::processAllHandlers()
+	 * (or processOneHandler()) for the ops to be dispatched.
+	 *
+	 * Takes effect the next time a connection is established.
+	 */
+	void setBackgroundDecoding(bool enabled);
+
+	/**
+	 * @brief Makes connect() replay a captured session, instead of connecting to the server.
+	 * @param capture A capture, made through setCapture(), or null to connect to the server again.
+	 * @param pacing Whether the data should be fed at its original timing, or as fast as possible.
+	 */
+	void setReplay(std::shared_ptr<CaptureReader> capture, ReplayStreamSocket::Pacing pacing);
+
+	/**
+	 * @brief Enables or disables reconnecting automatically when the connection to the server is lost.
+	 *
+	 * When enabled, an unexpected loss of the connection emits Reconnecting, after which a new connection
+	 * is attempted every time the delay has passed, until one succeeds. Accounts and Avatars are kept
+	 * meanwhile, and resume the session once logged in again. Calling disconnect() stops the attempts.
+	 * @param enabled True if lost connections should be re-established.
+	 * @param delay The time to wait before each attempt.
+	 */
+	void setAutoReconnect(bool enabled, std::chrono::steady_clock::duration delay = std::chrono::seconds(2));
+
+	/**
+	 * @brief Limits the work done each time received ops are dispatched.
+	 *
+	 * A value of zero means no limit. At least one op is always dispatched.
+	 */
+	struct DispatchBudget
+	{
+		std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero(); ///< the longest time to spend dispatching
+		std::size_t ops = 0; ///< the most ops to dispatch
+	};
+
+	/**
+	 * @brief Determines how dispatching continues when ops are left over after the budget has run out.
+	 */
+	enum class DispatchResume
+	{
+		/**
+		 * Dispatching continues on the next turn of the EventService, again within the budget.
+		 */
+		EVENT_SERVICE,
+
+		/**
+		 * The ops are kept until the client calls pump().
+		 */
+		MANUAL
+	};
+
+	/**
+	 * @brief Sets a budget for dispatching received ops.
+	 *
+	 * Without a budget all received ops are dispatched as soon as they have been decoded, which can take
+	 * a long time for large bursts, such as the sights received after moving to a new area. With a budget,
+	 * ops left when it runs out stay queued until dispatching resumes. Ops are always dispatched in the
+	 * order they arrived, so ops concerning the same entity are never reordered.
+	 *
+	 * When resuming through the EventService each handler run by EventService::processOneHandler() dispatches
+	 * one budget's worth of ops, so a client calling it once per frame spreads a burst over several frames.
+	 * EventService::processAllHandlers() keeps running the handlers until all ops have been dispatched.
+	 * @param budget The budget, or a default constructed one to dispatch everything at once.
+	 * @param resume How to continue with the ops left over.
+	 */
+	void setDispatchBudget(DispatchBudget budget, DispatchResume resume = DispatchResume::EVENT_SERVICE);
+
+	/**
+	 * @brief Dispatches queued ops, within the budget.
+	 * @return The number of ops dispatched.
+	 */
+	std::size_t pump(DispatchBudget budget);
+
+	/**
+	 * @brief Describes the ops waiting to be dispatched.
+	 */
+	struct DispatchQueueStatistics
+	{
+		std::size_t depth = 0; ///< number of ops waiting to be dispatched
+		std::size_t maxDepth = 0; ///< the highest number of ops which have been waiting at once
+		std::chrono::steady_clock::duration oldestAge = std::chrono::steady_clock::duration::zero(); ///< how long the oldest op has been waiting
+		std::uint64_t deferrals = 0; ///< number of times the budget ran out with ops left
+	};
+
+	DispatchQueueStatistics getDispatchQueueStatistics() const;
+
+	/**
+	 * @brief A queue which received ops are sorted into, to be dispatched before or after the ops of other lanes.
+	 */
+	struct DispatchLane
+	{
+		std::string name;
+
+		/**
+		 * The number of ops dispatched from the lane in each round, while it has any.
+		 */
+		unsigned int weight;
+	};
+
+	/**
+	 * @brief Picks the lane for a received op, as an index into the lanes.
+	 */
+	typedef std::function<std::size_t(const Atlas::Objects::Operation::RootOperation&)> OpClassifier;
+
+	/**
+	 * @brief The lanes set up by useDefaultDispatchLanes(), in order.
+	 */
+	enum DefaultDispatchLane
+	{
+		LANE_RESPONSES, ///< responses to awaited serial numbers
+		LANE_AVATAR, ///< ops from our own avatars
+		LANE_MOVEMENT, ///< sights of Set and Move ops
+		LANE_OTHER ///< everything else
+	};
+
+	/**
+	 * @brief Sorts received ops into lanes, which are dispatched in weighted round-robin.
+	 *
+	 * This lets urgent ops, such as the movement of nearby entities, overtake less urgent ones, such as chat
+	 * or type information. While ops from or concerning an entity are queued, all new ops for that entity
+	 * are put in the same lane, so that the ops of each entity are still dispatched in the order they arrived.
+	 *
+	 * By default all ops share one lane. Ops already queued are sorted into the new lanes.
+	 * @param lanes The lanes, which must not be empty.
+	 * @param classifier Picks the lane of each op. Indices beyond the last lane are treated as the last lane.
+	 */
+	void setDispatchLanes(std::vector<DispatchLane> lanes, OpClassifier classifier);
+
+	/**
+	 * @brief Sets up the lanes described by DefaultDispatchLane, classified by classifyOp().
+	 */
+	void useDefaultDispatchLanes();
+
+	/**
+	 * @brief Classifies an op into one of the DefaultDispatchLane lanes.
+	 */
+	std::size_t classifyOp(const Atlas::Objects::Operation::RootOperation& op) const;
+
+	/**
+	 * @brief Describes the ops which have passed through a dispatch lane.
+	 */
+	struct LaneStatistics
+	{
+		std::string name;
+		std::size_t depth = 0; ///< number of ops waiting in the lane
+		std::uint64_t dispatched = 0; ///< number of ops dispatched from the lane
+		std::chrono::steady_clock::duration totalLatency = std::chrono::steady_clock::duration::zero(); ///< the sum of the time the dispatched ops waited
+		std::chrono::steady_clock::duration maxLatency = std::chrono::steady_clock::duration::zero(); ///< the longest time a dispatched op waited
+
+		/**
+		 * @brief Gets the average time a dispatched op waited in the lane.
+		 */
+		std::chrono::steady_clock::duration getAverageLatency() const;
+	};
+
+	/**
+	 * @brief Gets statistics for each dispatch lane, in the order the lanes were set up.
+	 */
+	std::vector<LaneStatistics> getLaneStatistics() const;
+
+	/**
+	 * @brief Determines what happens to ops sent while the connection is congested.
+	 * @see BaseConnection::setSendWatermarks
+	 */
+	enum class CongestionPolicy
+	{
+		/**
+		 * Ops are queued for sending as usual.
+		 */
+		QUEUE_ALL,
+
+		/**
+		 * Ops are held back until the congestion clears. An op which supersedes one already held,
+		 * i.e. has the same type, sender and receiver and concerns the same attributes of the same entity,
+		 * replaces the held one. Ops with a serial number are never replaced, since a response is expected for them.
+		 */
+		REPLACE_SUPERSEDED
+	};
+
+	void setCongestionPolicy(CongestionPolicy policy);
+
+	/**
+	 * @brief Returns true if too much outgoing data is queued.
+	 */
+	bool isSendCongested() const;
+
 	void setDefaultRouter(Router* router);
 
 	void clearDefaultRouter();
@@ -99,6 +343,23 @@ public:
 
 	void unregisterRouterForFrom(const std::string& fromId);
 
+	/**
+	 * Registers a router for an id interned in getIdInterner(). Each registration holds a reference to
+	 * the id, which it releases when unregistered, so the caller can release its own reference.
+	 */
+	void registerRouterForTo(Router* router, IdInterner::Handle toId);
+
+	void unregisterRouterForTo(Router* router, IdInterner::Handle toId);
+
+	void registerRouterForFrom(Router* router, IdInterner::Handle fromId);
+
+	void unregisterRouterForFrom(IdInterner::Handle fromId);
+
+	/**
+	 * @brief Gets the table of interned ids, shared by everything using the connection.
+	 */
+	IdInterner& getIdInterner() { return m_idInterner; }
+
 	/** Lock then connection's state. This prevents the connection changing status
 	until a corresponding unlock() call is issued. The only use at present is to hold
 	the connection in the 'DISCONNECTING' state while other objects clean up
@@ -124,6 +385,39 @@ public:
 	*/
 	void getServerInfo(ServerInfo&) const;
 
+	/**
+	 * @brief Counters for the network traffic of the connection.
+	 *
+	 * These cover the current socket only, and are reset when connecting again.
+	 */
+	struct IoStatistics
+	{
+		StreamSocket::Statistics socket;
+		std::uint64_t opsReceived = 0; ///< number of ops received from the server
+		std::uint64_t opsSent = 0; ///< number of ops sent to the server
+		std::uint64_t opsReplaced = 0; ///< number of ops which were replaced by newer ones while congested
+
+		/**
+		 * @brief Gets the average number of socket reads which were needed for each op received.
+		 */
+		double getReadSyscallsPerOp() const;
+
+		/**
+		 * @brief Gets the number of writes which were avoided by sending multiple ops in one go, compared to one write per op.
+		 */
+		std::uint64_t getWriteSyscallsSaved() const;
+
+		/**
+		 * @brief Gets the average number of ops sent in each write.
+		 */
+		double getOpsPerWrite() const;
+	};
+
+	/**
+	 * @brief Gets counters for the network traffic of the connection.
+	 */
+	IoStatistics getIoStatistics() const;
+
 	sigc::signal<void()> GotServerInfo;
 
 ///////////////////////
@@ -141,12 +435,24 @@ public:
 	during the callback */
 	sigc::signal<void(const std::string&)> Failure;
 
+	/**
+	 * Emitted when the connection has been lost unexpectedly, and will be re-established automatically.
+	 * @see setAutoReconnect
+	 */
+	sigc::signal<void()> Reconnecting;
+
 	/// indicates a status change on the connection
 	/** emitted when the connection status changes; This will often
 	correspond to the emission of a more specific signal (such as Connected),
 	which should be used where available. */
 	sigc::signal<void(Status)> StatusChanged;
 
+	/**
+	 * Emitted with "true" when the amount of queued outgoing data reaches the high watermark, and with
+	 * "false" once it has fallen back to the low watermark.
+	 */
+	sigc::signal<void(bool)> SendCongested;
+
 protected:
 	/// update the connection status (and emit the appropriate signal)
 	/// @param sc The new status of the connection
@@ -159,6 +465,8 @@ protected:
 
 	void onConnect() override;
 
+	void onCongestionChanged(bool congested) override;
+
 	virtual void objectArrived(Atlas::Objects::Root obj);
 
 	std::unique_ptr<ConnectionDecoder> m_decoder;
@@ -169,6 +477,8 @@ protected:
 
 	friend class Redispatch;
 
+	friend class TypeService;
+
 	friend class TestInjector;
 
 	/** Inject a local operation into the dispatch queue. Used by the
@@ -181,17 +491,71 @@ protected:
 
 	void dispatchOp(const Atlas::Objects::Operation::RootOperation& op);
 
-	void handleServerInfo(const Atlas::Objects::Operation::RootOperation& op);
+	/**
+	 * Dispatches an op, with the handles of its FROM and TO ids already looked up.
+	 */
+	void dispatchOp(const Atlas::Objects::Operation::RootOperation& op, IdInterner::Handle from, IdInterner::Handle to);
+
+	/**
+	 * The handlers of the anonymous ops which the connection handles itself, by class number.
+	 */
+	static const OpDispatchTable<Connection>& getAnonymousOpHandlers();
+
+	Router::RouterResult handleServerInfo(const Atlas::Objects::Operation::RootOperation& op);
 
 	void onDisconnectTimeout();
 
-	typedef std::deque<Atlas::Objects::Operation::RootOperation> OpDeque;
-	OpDeque m_opDeque; ///< store of all the received ops waiting to be dispatched
+	struct QueuedOp
+	{
+		Atlas::Objects::Operation::RootOperation op;
+		std::chrono::steady_clock::time_point arrived;
+
+		IdInterner::Handle from; ///< the interned FROM id, looked up when the op was queued
+		IdInterner::Handle to; ///< the interned TO id, looked up when the op was queued
+
+		/**
+		 * The entity the op concerns, if its lane has been pinned for the entity.
+		 */
+		std::string entity;
+	};
+
+	typedef std::deque<QueuedOp> OpDeque;
+
+	struct Lane
+	{
+		DispatchLane config;
+		OpDeque ops; ///< store of the received ops in the lane waiting to be dispatched
+		LaneStatistics statistics;
+	};
+
+	std::vector<Lane> m_lanes;
+	OpClassifier m_classifier;
+
+	/**
+	 * The lane currently being dispatched from, and the number of ops it may still dispatch in this round.
+	 */
+	std::size_t m_currentLane;
+	unsigned int m_laneCredit;
+
+	std::size_t m_queuedOps; ///< number of ops in all lanes
+
+	struct EntityLane
+	{
+		std::size_t lane;
+		std::size_t queued;
+	};
+
+	/**
+	 * The lanes which entities with queued ops are pinned to, keyed by entity id.
+	 */
+	std::unordered_map<std::string, EntityLane> m_entityLanes;
 
 	std::unique_ptr<TypeService> m_typeService;
 	Router* m_defaultRouter; // need several of these?
 
-	typedef std::unordered_map<std::string, Router*> IdRouterMap;
+	IdInterner m_idInterner;
+
+	typedef std::unordered_map<IdInterner::Handle, Router*> IdRouterMap;
 	IdRouterMap m_toRouters;
 	IdRouterMap m_fromRouters;
 
@@ -201,9 +565,131 @@ protected:
 	ServerInfo m_info;
 
 	std::unique_ptr<ResponseTracker> m_responder;
+
+	std::uint64_t m_opsReceived; ///< number of ops received through the current socket
+	std::uint64_t m_opsSent; ///< number of ops sent through the current socket
+
+	/**
+	 * True if ops should be held until flushed.
+	 */
+	bool m_corked;
+
+	/**
+	 * The longest time ops are held when corked. If zero they are held until the end of the event loop turn.
+	 */
+	std::chrono::steady_clock::duration m_corkMaxLatency;
+
+	/**
+	 * True if a flush has been scheduled for held ops.
+	 */
+	bool m_flushScheduled;
+
+	boost::asio::steady_timer m_flushTimer;
+
+	ActiveMarker m_activeMarker;
+
+	void scheduleFlush();
+
+	CongestionPolicy m_congestionPolicy;
+
+	/**
+	 * Ops held back while congested, when using CongestionPolicy::REPLACE_SUPERSEDED.
+	 */
+	std::list<Atlas::Objects::Root> m_heldOps;
+
+	/**
+	 * The ops in m_heldOps which can be superseded, keyed by what they concern.
+	 */
+	std::unordered_map<std::string, std::list<Atlas::Objects::Root>::iterator> m_heldOpIndex;
+
+	std::uint64_t m_opsReplaced;
+
+	void encodeOp(const Atlas::Objects::Root& obj);
+
+	void holdOp(const Atlas::Objects::Root& obj);
+
+	void sendHeldOps();
+
+	/**
+	 * True if incoming data should be decoded in a background thread.
+	 */
+	bool m_backgroundDecoding;
+
+	std::unique_ptr<BackgroundDecoder> m_backgroundDecoder;
+
+	std::shared_ptr<CaptureReader> m_replay; ///< see setReplay()
+	ReplayStreamSocket::Pacing m_replayPacing;
+
+	bool m_autoReconnect;
+	std::chrono::steady_clock::duration m_reconnectDelay;
+
+	/**
+	 * True from when the connection was lost until a new one has been established.
+	 */
+	bool m_reconnecting;
+
+	/**
+	 * True from when disconnect() is called until the next connect(), so that the disconnection isn't taken as
+	 * a lost connection.
+	 */
+	bool m_disconnectRequested;
+
+	boost::asio::steady_timer m_reconnectTimer;
+
+	void scheduleReconnect();
+
+	DispatchBudget m_dispatchBudget;
+	DispatchResume m_dispatchResume;
+
+	/**
+	 * True if dispatching of left over ops has been scheduled on the EventService.
+	 */
+	bool m_dispatchScheduled;
+
+	std::size_t m_maxQueueDepth;
+	std::uint64_t m_dispatchDeferrals;
+
+	std::size_t dispatchQueued(const DispatchBudget& budget);
+
+	void queueOp(Atlas::Objects::Operation::RootOperation op);
+
+	void queueOp(QueuedOp queued);
+
+	/**
+	 * Takes the next op to dispatch from the lanes.
+	 */
+	QueuedOp takeOp();
+
+	void clearQueuedOps();
+
+	/**
+	 * Periodically gives up on responses which haven't arrived in time.
+	 */
+	boost::asio::steady_timer m_responseExpiryTimer;
+
+	void scheduleResponseExpiry();
+
+	void messagesDecoded(std::vector<Atlas::Message::MapType> messages);
+
+	/**
+	 * Stops the background decoder, if any, and destroys it once control is back on the main loop.
+	 */
+	void retireBackgroundDecoder();
+
+	/**
+	 * Ops passed to sendFromAnyThread() which haven't been sent yet.
+	 */
+	std::unique_ptr<WaitFreeQueue<Atlas::Message::MapType>> m_outgoingMessages;
+
+	/**
+	 * True if sending of the outgoing messages has been posted to the io_service.
+	 */
+	std::atomic<bool> m_outgoingScheduled;
+
+	void sendOutgoingMessages();
 };
 
-/// operation serial number sequencing
+/// operation serial number sequencing; can be called from any thread
 std::int64_t getNewSerialno();
 
 } // of Eris namespace
@@ -7,6 +7,7 @@
 #include "Entity.h"
 #include "Connection.h"
 #include "TypeInfo.h"
+#include "TypeService.h"
 #include "LogStream.h"
 #include "Exceptions.h"
 #include "Avatar.h"
@@ -16,6 +17,7 @@
 #include <Atlas/Objects/Entity.h>
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/BaseObject.h>
+#include <Atlas/Bridge.h>
 
 #include <algorithm>
 #include <set> 
@@ -35,7 +37,200 @@ using WFMath::TimeDiff;
 
 namespace Eris {
 
+namespace {
+IdInterner& getPropertyNames(TypeInfo* type)
+{
+    if (type) {
+        return type->getTypeService().getPropertyNames();
+    }
+    //Entities without a type share names of their own.
+    static IdInterner names;
+    return names;
+}
+
+/**
+ * Builds each attribute sent by BaseObjectData::sendContents() into an Element, and moves it into a handler
+ * taking the name and an Element&&.
+ *
+ * Only the attributes which are set are sent, without them first being collected into a MapType, as
+ * addToMessage() does. The "id" and "contains" attributes are skipped, without building their values.
+ */
+template<typename Handler>
+class AttributeBridge : public Atlas::Bridge
+{
+public:
+    explicit AttributeBridge(Handler handler) :
+            m_handler(std::move(handler)),
+            m_skippedDepth(0)
+    {
+    }
+
+    void streamBegin() override {}
+
+    void streamMessage() override {}
+
+    void streamEnd() override {}
+
+    void mapMapItem(std::string name) override
+    {
+        begin(std::move(name), MapType());
+    }
+
+    void mapListItem(std::string name) override
+    {
+        begin(std::move(name), ListType());
+    }
+
+    void mapIntItem(std::string name, Atlas::Message::IntType value) override
+    {
+        add(std::move(name), value);
+    }
+
+    void mapFloatItem(std::string name, Atlas::Message::FloatType value) override
+    {
+        add(std::move(name), value);
+    }
+
+    void mapStringItem(std::string name, std::string value) override
+    {
+        add(std::move(name), std::move(value));
+    }
+
+    void mapNoneItem(std::string name) override
+    {
+        add(std::move(name), Element());
+    }
+
+    void mapEnd() override
+    {
+        end();
+    }
+
+    void listMapItem() override
+    {
+        begin(std::string(), MapType());
+    }
+
+    void listListItem() override
+    {
+        begin(std::string(), ListType());
+    }
+
+    void listIntItem(Atlas::Message::IntType value) override
+    {
+        add(std::string(), value);
+    }
+
+    void listFloatItem(Atlas::Message::FloatType value) override
+    {
+        add(std::string(), value);
+    }
+
+    void listStringItem(std::string value) override
+    {
+        add(std::string(), std::move(value));
+    }
+
+    void listNoneItem() override
+    {
+        add(std::string(), Element());
+    }
+
+    void listEnd() override
+    {
+        end();
+    }
+
+private:
+    Handler m_handler;
+
+    /**
+     * The name and value of the attribute being built, if it's a map or a list.
+     */
+    std::string m_name;
+    Element m_value;
+
+    /**
+     * The maps and lists being built, innermost last.
+     */
+    std::vector<Element*> m_containers;
+
+    /**
+     * The nesting level within a skipped attribute, or zero if none is being skipped.
+     */
+    std::size_t m_skippedDepth;
+
+    static bool isSkipped(const std::string& name)
+    {
+        //Id can't be changed once it's initially set, which it's at Entity creation time.
+        //Contains are handled by the setContentsFromAtlas method which should be called separately.
+        return name == "id" || name == "contains";
+    }
+
+    /**
+     * Inserts a value into the innermost map or list, and returns it.
+     */
+    Element& insert(std::string name, Element value)
+    {
+        auto& container = *m_containers.back();
+        if (container.isMap()) {
+            return container.asMap()[std::move(name)] = std::move(value);
+        }
+        auto& list = container.asList();
+        list.push_back(std::move(value));
+        return list.back();
+    }
+
+    void add(std::string name, Element value)
+    {
+        if (m_skippedDepth != 0) {
+            return;
+        }
+        if (m_containers.empty()) {
+            if (!isSkipped(name)) {
+                m_handler(name, std::move(value));
+            }
+            return;
+        }
+        insert(std::move(name), std::move(value));
+    }
+
+    void begin(std::string name, Element container)
+    {
+        if (m_skippedDepth != 0) {
+            ++m_skippedDepth;
+            return;
+        }
+        if (m_containers.empty()) {
+            if (isSkipped(name)) {
+                m_skippedDepth = 1;
+                return;
+            }
+            m_name = std::move(name);
+            m_value = std::move(container);
+            m_containers.push_back(&m_value);
+            return;
+        }
+        //Nothing else is added to the parent until the child is done, so the pointer stays valid.
+        m_containers.push_back(&insert(std::move(name), std::move(container)));
+    }
+
+    void end()
+    {
+        if (m_skippedDepth != 0) {
+            --m_skippedDepth;
+            return;
+        }
+        m_containers.pop_back();
+        if (m_containers.empty()) {
+            m_handler(m_name, std::move(m_value));
+        }
+    }
+};
+}
+
 Entity::Entity(std::string id, TypeInfo* ty) :
+		m_properties(getPropertyNames(ty)),
 		m_type(ty),
 		m_location(nullptr),
 		m_id(std::move(id)),
@@ -44,6 +239,8 @@ Entity::Entity(std::string id, TypeInfo* ty) :
 		m_waitingForParentBind(false),
 		m_angularMag(0),
 		m_updateLevel(0),
+		m_modifiedProperties(m_properties.getNames()),
+		m_modifiedNativeProperties(0),
 		m_hasBBox(false),
 		m_moving(false),
 		m_recentlyCreated(false)
@@ -170,7 +367,9 @@ Entity::PropertyMap Entity::getProperties() const
 {
     ///Merge both the local properties and the type default properties.
     PropertyMap properties;
-    properties.insert(m_properties.begin(), m_properties.end());
+    for (auto& entry : m_properties) {
+        properties.emplace(entry.first, entry.second);
+    }
     if (m_type) {
 		fillPropertiesFromType(properties, *m_type);
     }
@@ -178,14 +377,27 @@ Entity::PropertyMap Entity::getProperties() const
 }
 
 const Entity::PropertyMap& Entity::getInstanceProperties() const
+{
+    if (!m_instancePropertiesMap) {
+        m_instancePropertiesMap.emplace();
+        for (auto& entry : m_properties) {
+            m_instancePropertiesMap->emplace(entry.first, entry.second);
+        }
+    }
+    return *m_instancePropertiesMap;
+}
+
+const PropertyTable& Entity::getInstancePropertyTable() const
 {
     return m_properties;
 }
 
 void Entity::fillPropertiesFromType(Entity::PropertyMap& properties, const TypeInfo& typeInfo) const
 {
-    properties.insert(typeInfo.getProperties().begin(), typeInfo.getProperties().end());
-    ///Make sure to fill from the closest properties first, as insert won't replace an existing value
+    for (auto& entry : typeInfo.getPropertyTable()) {
+        properties.emplace(entry.first, entry.second);
+    }
+    ///Make sure to fill from the closest properties first, as emplace won't replace an existing value
 
 	if (typeInfo.getParent()) {
 		fillPropertiesFromType(properties, *typeInfo.getParent());
@@ -267,25 +479,22 @@ void Entity::firstSight(const RootEntity &gent)
 void Entity::setFromRoot(const Root& obj, bool includeTypeInfoProperties)
 {	
     beginUpdate();
-    
-    Atlas::Message::MapType properties;
-    obj->addToMessage(properties);
-
-    properties.erase("id"); //Id can't be changed once it's initially set, which it's at Entity creation time.
-    properties.erase("contains"); //Contains are handled by the setContentsFromAtlas method which should be called separately.
 
-    for (auto& entry : properties) {
+    //Visit the attributes in place, rather than copying them all into a MapType first.
+    auto handler = [this](const std::string& name, Element&& value) {
         // see if the value in the sight matches the existing value
-        auto I = m_properties.find(entry.first);
-        if ((I != m_properties.end()) && (I->second == entry.second)) {
-			continue;
-		}
+        auto I = m_properties.find(name);
+        if ((I != m_properties.end()) && (I->second == value)) {
+            return;
+        }
         try {
-            setProperty(entry.first, entry.second);
+            setProperty(name, std::move(value));
         } catch (const std::exception& ex) {
-            warning() << "Error when setting property '" << entry.first << "'. Message: " << ex.what();
+            warning() << "Error when setting property '" << name << "'. Message: " << ex.what();
         }
-    }
+    };
+    AttributeBridge<decltype(handler)> bridge(std::move(handler));
+    obj->sendContents(bridge);
 
     //Add any values found in the type, if they aren't defined in the entity already.
     if (includeTypeInfoProperties && m_type) {
@@ -381,9 +590,31 @@ void Entity::setProperty(const std::string &p, const Element &v)
 {
     beginUpdate();
 
-	m_properties[p] = v;
+	auto name = m_properties.getNames().intern(p);
+	m_properties[name] = v;
+	propertySet(name, p, v);
+
+    endUpdate();
+}
+
+void Entity::setProperty(const std::string &p, Element &&v)
+{
+    beginUpdate();
+
+	auto name = m_properties.getNames().intern(p);
+	auto& value = m_properties[name];
+	value = std::move(v);
+	propertySet(name, p, value);
+
+    endUpdate();
+}
 
-	nativePropertyChanged(p, v);
+void Entity::propertySet(IdInterner::Handle name, const std::string &p, const Element &v)
+{
+	m_instancePropertiesMap = boost::none;
+
+	auto property = NativeProperties::lookup(p);
+	nativePropertyChanged(property, v);
 	onPropertyChanged(p, v);
 
     // fire observers
@@ -393,39 +624,40 @@ void Entity::setProperty(const std::string &p, const Element &v)
         obs->second.emit(v);
     }
 
-    addToUpdate(p);
-    endUpdate();
+    addToUpdate(name, property);
 }
 
 bool Entity::nativePropertyChanged(const std::string& p, const Element& v)
 {
-    // in the future, hash these names to a compile-time integer index, and
-    // make this a switch statement. The same index could also be used
-    // in endUpdate
-    
-    if (p == "name") {
+    return nativePropertyChanged(NativeProperties::lookup(p), v);
+}
+
+bool Entity::nativePropertyChanged(NativeProperty property, const Element& v)
+{
+    switch (property) {
+    case NativeProperty::NAME:
         m_name = v.asString();
         return true;
-    } else if (p == "stamp") {
+    case NativeProperty::STAMP:
         m_stamp = v.asFloat();
         return true;
-    } else if (p == "pos") {
+    case NativeProperty::POS:
         m_position.fromAtlas(v);
         return true;
-    } else if (p == "velocity") {
+    case NativeProperty::VELOCITY:
         m_velocity.fromAtlas(v);
         return true;
-    } else if (p == "angular") {
+    case NativeProperty::ANGULAR:
         m_angularVelocity.fromAtlas(v);
         m_angularMag = m_angularVelocity.mag();
         return true;
-    } else if (p == "accel") {
+    case NativeProperty::ACCEL:
         m_acc.fromAtlas(v);
         return true;
-    } else if (p == "orientation") {
+    case NativeProperty::ORIENTATION:
         m_orientation.fromAtlas(v);
 		return true;
-    } else if (p == "bbox") {
+    case NativeProperty::BBOX:
         m_bboxUnscaled.fromAtlas(v);
         m_bbox = m_bboxUnscaled;
         if (m_scale.isValid() && m_bbox.isValid()) {
@@ -438,15 +670,15 @@ bool Entity::nativePropertyChanged(const std::string& p, const Element& v)
         }
         m_hasBBox = m_bbox.isValid();
         return true;
-    } else if (p == "loc") {
+    case NativeProperty::LOC:
         setLocationFromAtlas(v.asString());
         return true;
-    } else if (p == "contains") {
+    case NativeProperty::CONTAINS:
         throw InvalidOperation("tried to set contains via setProperty");
-    } else if (p == "tasks") {
+    case NativeProperty::TASKS:
         updateTasks(v);
         return true;
-    } else if (p == "scale") {
+    case NativeProperty::SCALE:
         if (v.isList()) {
             if (v.List().size() == 1) {
                 if (v.List().front().isNum()) {
@@ -469,6 +701,8 @@ bool Entity::nativePropertyChanged(const std::string& p, const Element& v)
             m_bbox.highCorner().z() *= m_scale.z();
         }
         return true;
+    case NativeProperty::NONE:
+        break;
     }
 
     return false; // not a native property
@@ -488,9 +722,11 @@ void Entity::typeInfo_PropertyChanges(const std::string& propertyName, const Atl
 void Entity::propertyChangedFromTypeInfo(const std::string& propertyName, const Atlas::Message::Element& element)
 {
     ///Only fire the events if there's no property already defined for this entity
-    if (m_properties.find(propertyName) == m_properties.end()) {
+    auto name = m_properties.getNames().intern(propertyName);
+    if (m_properties.find(name) == m_properties.end()) {
         beginUpdate();
-		nativePropertyChanged(propertyName, element);
+        auto property = NativeProperties::lookup(propertyName);
+		nativePropertyChanged(property, element);
 		onPropertyChanged(propertyName, element);
     
         // fire observers
@@ -500,7 +736,7 @@ void Entity::propertyChangedFromTypeInfo(const std::string& propertyName, const
             obs->second.emit(element);
         }
     
-        addToUpdate(propertyName);
+        addToUpdate(name, property);
         endUpdate();
     }
 }
@@ -512,9 +748,20 @@ void Entity::beginUpdate()
 }
 
 void Entity::addToUpdate(const std::string& propertyName)
+{
+    addToUpdate(propertyName, NativeProperties::lookup(propertyName));
+}
+
+void Entity::addToUpdate(const std::string& propertyName, NativeProperty property)
+{
+    addToUpdate(m_modifiedProperties.getNames().intern(propertyName), property);
+}
+
+void Entity::addToUpdate(IdInterner::Handle propertyName, NativeProperty property)
 {
     assert(m_updateLevel > 0);
     m_modifiedProperties.insert(propertyName);
+    m_modifiedNativeProperties |= NativeProperties::bit(property);
 }
 
 void Entity::endUpdate()
@@ -527,18 +774,23 @@ void Entity::endUpdate()
         
     if (--m_updateLevel == 0) // unlocking updates
     {
-        Changed.emit(m_modifiedProperties);
+        PropertiesChanged.emit(m_modifiedProperties);
+        //Only build the set of names if anyone is interested in them.
+        if (!Changed.empty()) {
+            Changed.emit(m_modifiedProperties.toStringSet());
+        }
         
-        if (m_modifiedProperties.find("pos") != m_modifiedProperties.end() ||
-			m_modifiedProperties.find("velocity") != m_modifiedProperties.end() ||
-			m_modifiedProperties.find("orientation") != m_modifiedProperties.end() ||
-			m_modifiedProperties.find("angular") != m_modifiedProperties.end())
+        constexpr std::uint32_t movementProperties = NativeProperties::bit(NativeProperty::POS)
+                | NativeProperties::bit(NativeProperty::VELOCITY)
+                | NativeProperties::bit(NativeProperty::ORIENTATION)
+                | NativeProperties::bit(NativeProperty::ANGULAR);
+        if (m_modifiedNativeProperties & movementProperties)
         {
         	auto now = TimeStamp::now();
-			if (m_modifiedProperties.find("pos") != m_modifiedProperties.end()) {
+			if (m_modifiedNativeProperties & NativeProperties::bit(NativeProperty::POS)) {
 				m_lastPosTime = now;
 			}
-			if (m_modifiedProperties.find("orientation") != m_modifiedProperties.end()) {
+			if (m_modifiedNativeProperties & NativeProperties::bit(NativeProperty::ORIENTATION)) {
 				m_lastOrientationTime = now;
 			}
 
@@ -552,6 +804,7 @@ void Entity::endUpdate()
         }
         
         m_modifiedProperties.clear();
+        m_modifiedNativeProperties = 0;
     }
 }
 
@@ -2,6 +2,9 @@
 #define ERIS_ENTITY_H
 
 #include "Types.h"
+#include "NativeProperties.h"
+#include "PropertyIdSet.h"
+#include "PropertyTable.h"
 
 #include <Atlas/Objects/ObjectsFwd.h>
 
@@ -97,6 +100,8 @@ public:
      * If no property by the specified name can be found an InvalidOperation exception will be thrown. Therefore always first call hasProperty to make sure that the property exists.
      * @param name The property name.
      * @return A reference to the property by the specified name.
+     * @note The properties are kept in a flat table, which moves its values when properties are added or removed.
+     * The reference is thus only valid until the properties of the entity or its type next change.
      * @throws InvalidOperation If no property by the specified name can be found.
      */
     const Atlas::Message::Element& valueOfProperty(const std::string& name) const;
@@ -191,10 +196,21 @@ public:
      * @note This will only return a subset of all properties.
      * If you need to iterate over all properties you should instead use the getProperties() method.
      * If you only want the value of a specific property you should use the valueOfProperty method.
+     * @note The properties are kept in a PropertyTable, from which the map is built the first time it's
+     * asked for after the properties have changed. The reference is valid until the properties next change.
+     * Use getInstancePropertyTable() to look at them without building the map.
      * @see getProperties
      * @return The locally defined properties for the entity.
      */
     const PropertyMap& getInstanceProperties() const;
+
+    /**
+     * @brief Gets the table holding the locally defined properties.
+     * Unlike getInstanceProperties() this doesn't copy the properties. The table isn't in name order,
+     * and adding or removing properties invalidates iterators and references into it.
+     * @return The locally defined properties for the entity.
+     */
+    const PropertyTable& getInstancePropertyTable() const;
     
     /**
      * @brief Test if this entity has a non-zero velocity vector.
@@ -300,9 +316,16 @@ public:
     sigc::signal<void(Entity*)> LocationChanged;
 
     /** Emitted when one or more properties change. The arguments is a set
-    of property IDs which were modified. */
+    of property IDs which were modified.
+    The set is only built if something is connected to this signal, so
+    PropertiesChanged should be preferred. */
     sigc::signal<void(const std::set<std::string>&)> Changed;
 
+    /** Emitted when one or more properties change, before Changed. The
+    argument holds the interned names of the properties which were modified,
+    and is only valid during the emission. */
+    sigc::signal<void(const PropertyIdSet&)> PropertiesChanged;
+
     /** Emitted when then entity's position, orientation or velocity change.*/
     sigc::signal<void()> Moved;
 
@@ -478,12 +501,26 @@ protected:
     void setVisible(bool vis);
     
     void setProperty(const std::string &p, const Atlas::Message::Element &v);
+
+    /**
+    Sets a property, moving the value into the instance properties. Observers are handed the stored value,
+    so they mustn't set other properties of this entity while handling it, as that can move the entries.
+    */
+    void setProperty(const std::string &p, Atlas::Message::Element &&v);
+
+    /**
+    Notifies of a property just stored by setProperty, under the interned name.
+    */
+    void propertySet(IdInterner::Handle name, const std::string &p, const Atlas::Message::Element &v);
         
     /** 
-    Map Atlas properties to natively stored properties. Should be changed to
-    use an integer hash in the future, since this called frequently.
+    Map Atlas properties to natively stored properties. The name is looked up
+    through NativeProperties; callers which already have the id should use the
+    overload taking it.
     */
     bool nativePropertyChanged(const std::string &p, const Atlas::Message::Element &v);
+
+    bool nativePropertyChanged(NativeProperty property, const Atlas::Message::Element &v);
     
     /**
      * @brief Connected to the TypeInfo::PropertyeChanges event.
@@ -513,6 +550,12 @@ protected:
     
     void beginUpdate();
     void addToUpdate(const std::string& propertyName);
+    void addToUpdate(const std::string& propertyName, NativeProperty property);
+
+    /**
+    Adds a property to the update, by its name interned in the property table.
+    */
+    void addToUpdate(IdInterner::Handle propertyName, NativeProperty property);
     void endUpdate();
 
     /** update the entity's location based on Atlas data. This is used by
@@ -560,7 +603,16 @@ protected:
     virtual Entity* getEntity(const std::string& id) = 0;
 
 
-    PropertyMap m_properties;
+    /**
+     * The names are interned in the TypeService of the type, so that entities of the same
+     * types don't each keep copies of them.
+     */
+    PropertyTable m_properties;
+
+    /**
+     * The map returned by getInstanceProperties(), built from m_properties when asked for.
+     */
+    mutable boost::optional<PropertyMap> m_instancePropertiesMap;
     
     TypeInfo* m_type;
     
@@ -600,10 +652,14 @@ protected:
     int m_updateLevel;
 
     /** When a batched property update is in progress, the set tracks the names
-    of each modified property. This set is passed as a parameter of the Changed
-    callback when endUpdate is called, to allow clients to determine what
-    was changed. */
-	std::set<std::string> m_modifiedProperties;
+    of each modified property. This set is passed as a parameter of the
+    PropertiesChanged callback when endUpdate is called, to allow clients to
+    determine what was changed. */
+    PropertyIdSet m_modifiedProperties;
+
+    /** The native properties among m_modifiedProperties, as a mask of
+    NativeProperties::bit(), so that endUpdate can check them cheaply. */
+    std::uint32_t m_modifiedNativeProperties;
         
     typedef sigc::signal<void(const Atlas::Message::Element&)> PropertyChangedSignal;
         
@@ -10,7 +10,7 @@
 #include "TypeInfo.h"
 #include "View.h"
 #include "Connection.h"
-#include "TypeBoundRedispatch.h"
+#include "OpDispatchTable.h"
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Entity.h>
@@ -32,51 +32,60 @@ EntityRouter::~EntityRouter() {
 	m_view.getConnection().unregisterRouterForFrom(m_entity.getId());
 }
 
+const OpDispatchTable<EntityRouter>& EntityRouter::getOpHandlers()
+{
+    // note it's important we match exactly on sight here, and not derived ops
+    // like appearance and disappearance
+    static const OpDispatchTable<EntityRouter> handlers{
+            {SIGHT_NO, &EntityRouter::handleSight},
+            {SOUND_NO, &EntityRouter::handleSound}
+    };
+    return handlers;
+}
+
 Router::RouterResult EntityRouter::handleOperation(const RootOperation& op)
 {
     assert(op->getFrom() == m_entity.getId());
-    const std::vector<Root>& args = op->getArgs();
+    return getOpHandlers().dispatch(*this, op);
+}
 
-    // note it's important we match exactly on sight here, and not derived ops
-    // like appearance and disappearance
-    if (op->getClassNo() == SIGHT_NO) {
-    	for (const auto& arg : args) {
-			auto sop = smart_dynamic_cast<RootOperation>(arg);
-			if (sop.isValid()) {
-				return handleSightOp(sop);
-			}
-    	}
-    }
+Router::RouterResult EntityRouter::handleSight(const RootOperation& op)
+{
+	for (const auto& arg : op->getArgs()) {
+		auto sop = smart_dynamic_cast<RootOperation>(arg);
+		if (sop.isValid()) {
+			return handleSightOp(sop);
+		}
+	}
+	return IGNORED;
+}
 
-    if (op->getClassNo() == SOUND_NO) {
-		for (const auto& arg : args) {
-			if (arg->getClassNo() == TALK_NO)
-			{
-				auto talk = smart_dynamic_cast<RootOperation>(arg);
-				m_entity.onTalk(talk);
-			} else {
-				if (!arg->isDefaultParent()) {
-					auto ty = m_view.getTypeService().getTypeForAtlas(arg);
-					if (!ty->isBound()) {
-						new TypeBoundRedispatch(m_view.getConnection(), op, ty);
-					} else if (ty->isA(m_view.getTypeService().getTypeByName("action"))) {
-						// sound of action
-						auto act = smart_dynamic_cast<RootOperation>(arg);
-						m_entity.onSoundAction(act, *ty);
-					} else {
-						warning() << "entity " << m_entity.getId() << " emitted sound with strange argument: " << op;
-					}
+Router::RouterResult EntityRouter::handleSound(const RootOperation& op)
+{
+	for (const auto& arg : op->getArgs()) {
+		if (arg->getClassNo() == TALK_NO)
+		{
+			auto talk = smart_dynamic_cast<RootOperation>(arg);
+			m_entity.onTalk(talk);
+		} else {
+			if (!arg->isDefaultParent()) {
+				auto ty = m_view.getTypeService().getTypeForAtlas(arg);
+				if (!ty->isBound()) {
+					m_view.getTypeService().redispatchWhenBound(ty, op);
+				} else if (ty->isA(m_view.getTypeService().getTypeByName("action"))) {
+					// sound of action
+					auto act = smart_dynamic_cast<RootOperation>(arg);
+					m_entity.onSoundAction(act, *ty);
 				} else {
 					warning() << "entity " << m_entity.getId() << " emitted sound with strange argument: " << op;
 				}
+			} else {
+				warning() << "entity " << m_entity.getId() << " emitted sound with strange argument: " << op;
 			}
 		}
+	}
 
-		return HANDLED;
-        // other sounds !
-    }
-
-    return IGNORED;
+	return HANDLED;
 }
 
 Router::RouterResult EntityRouter::handleSightOp(const RootOperation& op)
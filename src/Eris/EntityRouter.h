@@ -5,6 +5,8 @@ namespace Eris
 
 class Entity;
 class View;
+template<class T, class... Args>
+class OpDispatchTable;
 
 class EntityRouter : public Router
 {
@@ -17,6 +19,12 @@ protected:
 	RouterResult handleOperation(const Atlas::Objects::Operation::RootOperation&) override;
     
 private:
+    static const OpDispatchTable<EntityRouter>& getOpHandlers();
+
+    RouterResult handleSight(const Atlas::Objects::Operation::RootOperation&);
+
+    RouterResult handleSound(const Atlas::Objects::Operation::RootOperation&);
+
     RouterResult handleSightOp(const Atlas::Objects::Operation::RootOperation&);
 
     Entity& m_entity;
@@ -9,9 +9,9 @@
 #include "Entity.h"
 #include "LogStream.h"
 #include "TypeInfo.h"
-#include "TypeBoundRedispatch.h"
 #include "TransferInfo.h"
 #include "TypeService.h"
+#include "OpDispatchTable.h"
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Entity.h>
@@ -24,19 +24,53 @@ using Atlas::Message::Element;
 
 namespace Eris {
 
+namespace {
+/**
+ * Class numbers are assigned in sequence as classes are registered, so they should stay well below this.
+ */
+const std::size_t maxCachedClassNo = 1024;
+}
+
 IGRouter::IGRouter(Avatar& av, View& view) :
     m_avatar(av),
-    m_view(view)
+    m_view(view),
+    m_routedFrom(IdInterner::INVALID_HANDLE)
 {
     m_avatar.getConnection().registerRouterForTo(this, m_avatar.getEntityId());
     m_actionType = m_avatar.getConnection().getTypeService().getTypeByName("action");
+    m_badTypeConnection = m_avatar.getConnection().getTypeService().BadType.connect([this](TypeInfo*) {
+        m_sightOpTypes.clear();
+    });
 }
 
 IGRouter::~IGRouter()
 {
+    m_badTypeConnection.disconnect();
     m_avatar.getConnection().unregisterRouterForTo(this, m_avatar.getEntityId());
 }
 
+const OpDispatchTable<IGRouter>& IGRouter::getOpHandlers()
+{
+    static const OpDispatchTable<IGRouter> handlers{
+            {SIGHT_NO, &IGRouter::handleSight},
+            {APPEARANCE_NO, &IGRouter::handleAppearance},
+            {DISAPPEARANCE_NO, &IGRouter::handleDisappearance},
+            {UNSEEN_NO, &IGRouter::handleUnseen},
+            {LOGOUT_NO, &IGRouter::handleLogout}
+    };
+    return handlers;
+}
+
+const OpDispatchTable<IGRouter, const RootOperation&>& IGRouter::getSightOpHandlers()
+{
+    // because a SET op can potentially (legally) update multiple entities,
+    // we decode it here, not in the entity router
+    static const OpDispatchTable<IGRouter, const RootOperation&> handlers{
+            {SET_NO, &IGRouter::handleSightSet}
+    };
+    return handlers;
+}
+
 Router::RouterResult IGRouter::handleOperation(const RootOperation& op)
 {
     if (!op->isDefaultSeconds()) {
@@ -44,189 +78,192 @@ Router::RouterResult IGRouter::handleOperation(const RootOperation& op)
         m_avatar.updateWorldTime(op->getSeconds());
     }
 
+    return getOpHandlers().dispatch(*this, op);
+}
+
+Router::RouterResult IGRouter::routeOperation(const RootOperation& op, IdInterner::Handle from, IdInterner::Handle)
+{
+    m_routedFrom = from;
+    auto result = handleOperation(op);
+    m_routedFrom = IdInterner::INVALID_HANDLE;
+    return result;
+}
+
+Entity* IGRouter::getEntity(const RootOperation& sightOp, const std::string& id) const
+{
+    if (m_routedFrom != IdInterner::INVALID_HANDLE && id == sightOp->getFrom()) {
+        return m_view.getEntity(m_routedFrom);
+    }
+    return m_view.getEntity(id);
+}
+
+Router::RouterResult IGRouter::handleSight(const RootOperation& op)
+{
     const std::vector<Root>& args = op->getArgs();
 
-    if (op->getClassNo() == SIGHT_NO) {
-        if (args.empty()) {
-            warning() << "Avatar received sight with empty args";
-            return IGNORED;
-        }
+    if (args.empty()) {
+        warning() << "Avatar received sight with empty args";
+        return IGNORED;
+    }
 
-		for (const auto& arg : args) {
-			if (arg->instanceOf(ROOT_OPERATION_NO)) {
-				handleSightOp(op, smart_dynamic_cast<RootOperation>(arg));
-			} else {
-				// initial sight of entities
-				auto gent = smart_dynamic_cast<RootEntity>(arg);
-				if (gent.isValid()) {
-					// View needs a bound TypeInfo for the entity
-					if (!gent->isDefaultId() && !gent->isDefaultParent()) {
-						TypeInfo* ty = m_avatar.getConnection().getTypeService().getTypeForAtlas(gent);
-						if (!ty->isBound()) {
-							auto opCopy = op.copy();
-							opCopy->setArgs1(arg);
-							new TypeBoundRedispatch(m_avatar.getConnection(), opCopy, ty);
+	for (const auto& arg : args) {
+		if (arg->instanceOf(ROOT_OPERATION_NO)) {
+			handleSightOp(op, smart_dynamic_cast<RootOperation>(arg));
+		} else {
+			// initial sight of entities
+			auto gent = smart_dynamic_cast<RootEntity>(arg);
+			if (gent.isValid()) {
+				// View needs a bound TypeInfo for the entity
+				if (!gent->isDefaultId() && !gent->isDefaultParent()) {
+					TypeInfo* ty = m_avatar.getConnection().getTypeService().getTypeForAtlas(gent);
+					if (!ty->isBound()) {
+						if (args.size() == 1) {
+							m_avatar.getConnection().getTypeService().redispatchWhenBound(ty, op);
 						} else {
-							m_view.sight(gent);
+							//Only this entity needs to wait for the type, so wrap it in a sight of its own.
+							Sight sight;
+							sight->setFrom(op->getFrom());
+							sight->setTo(op->getTo());
+							if (!op->isDefaultSeconds()) {
+								sight->setSeconds(op->getSeconds());
+							}
+							sight->setArgs1(arg);
+							m_avatar.getConnection().getTypeService().redispatchWhenBound(ty, sight);
 						}
+					} else {
+						m_view.sight(gent);
 					}
 				}
 			}
 		}
+	}
+
+	return HANDLED;
+}
 
-		return HANDLED;
+Router::RouterResult IGRouter::handleAppearance(const RootOperation& op)
+{
+    const std::vector<Root>& args = op->getArgs();
 
+    for (const auto& arg : args) {
+        double stamp = -1;
+        if (!arg->isDefaultStamp()) {
+            stamp = arg->getStamp();
+        }
 
+		if (!arg->isDefaultId()) {
+			m_view.appear(arg->getId(), stamp);
+		}
     }
 
-    if (op->getClassNo() == APPEARANCE_NO) {
-        for (const auto& arg : args) {
-            double stamp = -1;
-            if (!arg->isDefaultStamp()) {
-                stamp = arg->getStamp();
-            }
+    return HANDLED;
+}
 
-			if (!arg->isDefaultId()) {
-				m_view.appear(arg->getId(), stamp);
-			}
-        }
+Router::RouterResult IGRouter::handleDisappearance(const RootOperation& op)
+{
+    const std::vector<Root>& args = op->getArgs();
 
-        return HANDLED;
+    for (const auto& arg : args) {
+		if (!arg->isDefaultId()) {
+			m_view.disappear(arg->getId());
+		}
     }
 
-    if (op->getClassNo() == DISAPPEARANCE_NO) {
-        for (const auto& arg : args) {
-        	if (!arg->isDefaultId()) {
-				m_view.disappear(arg->getId());
-			}
-        }
+    return HANDLED;
+}
 
-        return HANDLED;
-    }
+Router::RouterResult IGRouter::handleUnseen(const RootOperation& op)
+{
+    const std::vector<Root>& args = op->getArgs();
 
-    if (op->getClassNo() == UNSEEN_NO)
-    {
-        if (args.empty()) {
-            warning() << "Avatar received unseen with empty args";
-            return IGNORED;
-        }
-		for (const auto& arg : args) {
-			if (!arg->isDefaultId()) {
-				m_view.unseen(arg->getId());
-			}
-		}
-        return HANDLED;
+    if (args.empty()) {
+        warning() << "Avatar received unseen with empty args";
+        return IGNORED;
     }
+	for (const auto& arg : args) {
+		if (!arg->isDefaultId()) {
+			m_view.unseen(arg->getId());
+		}
+	}
+    return HANDLED;
+}
 
-    // logout
-    if (op->getClassNo() == LOGOUT_NO) {
-        debug() << "Avatar received forced logout from server";
-
-        if(args.size() >= 2) {
-            bool gotArgs = true;
-            // Teleport logout op. The second attribute is the payload for the teleport host data.
-            const Root & arg = args[1];
-            Element tp_host_attr;
-            Element tp_port_attr;
-            Element pkey_attr;
-            Element pentity_id_attr;
-            if(arg->copyAttr("teleport_host", tp_host_attr) != 0
-                    || !tp_host_attr.isString()) {
-                debug() << "No teleport host specified. Doing normal logout."
-                        << std::endl << std::flush;
-                gotArgs = false;
-            } else if (arg->copyAttr("teleport_port", tp_port_attr) != 0
-                    || !tp_port_attr.isInt()) {
-                debug() << "No teleport port specified. Doing normal logout."
-                        << std::endl << std::flush;
-                gotArgs = false;
-            } else if (arg->copyAttr("possess_key", pkey_attr) != 0
-                    || !pkey_attr.isString()) {
-                debug() << "No possess key specified. Doing normal logout."
-                        << std::endl << std::flush;
-                gotArgs = false;
-            } else if (arg->copyAttr("possess_entity_id", pentity_id_attr) != 0
-                    || !pentity_id_attr.isString()) {
-                debug() << "No entity ID specified. Doing normal logout."
-                        << std::endl << std::flush;
-                gotArgs = false;
-            }
+Router::RouterResult IGRouter::handleLogout(const RootOperation& op)
+{
+    const std::vector<Root>& args = op->getArgs();
 
-            // Extract argument data and request transfer only if we
-            // succeed in extracting them all
-            if (gotArgs) {
-                std::string teleport_host = tp_host_attr.String();
-                int teleport_port = static_cast<int>(tp_port_attr.Int());
-                std::string possess_key = pkey_attr.String();
-                std::string possess_entity_id = pentity_id_attr.String();
-                debug() << "Server transfer data: Host: " << teleport_host
-                    << ", Port: " << teleport_port << ", "
-                    << "Key: " << possess_key << ", "
-                    << "ID: " << possess_entity_id << std::endl << std::flush;
-                // Now do a transfer request
-                TransferInfo transfer(teleport_host, teleport_port, possess_key
-                        , possess_entity_id);
-                m_avatar.logoutRequested(transfer);
-            } else {
-                m_avatar.logoutRequested();
-            }
+    debug() << "Avatar received forced logout from server";
+
+    if(args.size() >= 2) {
+        bool gotArgs = true;
+        // Teleport logout op. The second attribute is the payload for the teleport host data.
+        const Root & arg = args[1];
+        Element tp_host_attr;
+        Element tp_port_attr;
+        Element pkey_attr;
+        Element pentity_id_attr;
+        if(arg->copyAttr("teleport_host", tp_host_attr) != 0
+                || !tp_host_attr.isString()) {
+            debug() << "No teleport host specified. Doing normal logout."
+                    << std::endl << std::flush;
+            gotArgs = false;
+        } else if (arg->copyAttr("teleport_port", tp_port_attr) != 0
+                || !tp_port_attr.isInt()) {
+            debug() << "No teleport port specified. Doing normal logout."
+                    << std::endl << std::flush;
+            gotArgs = false;
+        } else if (arg->copyAttr("possess_key", pkey_attr) != 0
+                || !pkey_attr.isString()) {
+            debug() << "No possess key specified. Doing normal logout."
+                    << std::endl << std::flush;
+            gotArgs = false;
+        } else if (arg->copyAttr("possess_entity_id", pentity_id_attr) != 0
+                || !pentity_id_attr.isString()) {
+            debug() << "No entity ID specified. Doing normal logout."
+                    << std::endl << std::flush;
+            gotArgs = false;
+        }
 
+        // Extract argument data and request transfer only if we
+        // succeed in extracting them all
+        if (gotArgs) {
+            std::string teleport_host = tp_host_attr.String();
+            int teleport_port = static_cast<int>(tp_port_attr.Int());
+            std::string possess_key = pkey_attr.String();
+            std::string possess_entity_id = pentity_id_attr.String();
+            debug() << "Server transfer data: Host: " << teleport_host
+                << ", Port: " << teleport_port << ", "
+                << "Key: " << possess_key << ", "
+                << "ID: " << possess_entity_id << std::endl << std::flush;
+            // Now do a transfer request
+            TransferInfo transfer(teleport_host, teleport_port, possess_key
+                    , possess_entity_id);
+            m_avatar.logoutRequested(transfer);
         } else {
-            // Regular force logout op
             m_avatar.logoutRequested();
         }
 
-        return HANDLED;
+    } else {
+        // Regular force logout op
+        m_avatar.logoutRequested();
     }
 
-    return IGNORED;
+    return HANDLED;
 }
 
 Router::RouterResult IGRouter::handleSightOp(const RootOperation& sightOp, const RootOperation& op)
 {
-    const auto& args = op->getArgs();
-
-    // because a SET op can potentially (legally) update multiple entities,
-    // we decode it here, not in the entity router
-    if (op->getClassNo() == SET_NO) {
-        for (const auto& arg : args) {
-        	if (!arg->isDefaultId()) {
-				auto ent = m_view.getEntity(arg->getId());
-				if (!ent) {
-					if (m_view.isPending(arg->getId())) {
-						/* no-op, we'll get the state later */
-					} else {
-						m_view.sendLookAt(arg->getId());
-					}
-
-					continue; // we don't have it, ignore
-				}
-
-				//If we get a SET op for an entity that's not visible, it means that the entity has moved
-				//within our field of vision without sending an Appear op first. We should treat this as a
-				//regular Appear op and issue a Look op back, to get more info.
-				if (!ent->isVisible()) {
-//					float stamp = -1;
-//					if (!arg->isDefaultStamp()) {
-//						stamp = static_cast<float>(arg->getStamp());
-//					}
-//
-//					m_view.appear(arg->getId(), stamp);
-					m_view.getEntityFromServer(arg->getId());
-				} else {
-					ent->setFromRoot(arg, false);
-				}
-			}
-        }
+    if (getSightOpHandlers().dispatch(*this, op, sightOp) == HANDLED) {
         return HANDLED;
     }
 
     if (!op->isDefaultParent()) {
 		// we have to handle generic 'actions' late, to avoid trapping interesting
 		// such as create or divide
-		TypeInfo* ty = m_avatar.getConnection().getTypeService().getTypeForAtlas(op);
+		auto opType = getSightOpType(op);
+		TypeInfo* ty = opType.type;
 		if (!ty->isBound()) {
-			new TypeBoundRedispatch(m_avatar.getConnection(), sightOp, ty);
+			m_avatar.getConnection().getTypeService().redispatchWhenBound(ty, sightOp);
 			return HANDLED;
 		}
 
@@ -245,13 +282,13 @@ Router::RouterResult IGRouter::handleSightOp(const RootOperation& sightOp, const
 		}
 
 
-		if (ty->isA(m_actionType)) {
+		if (opType.isAction) {
 			if (op->isDefaultFrom()) {
 				warning() << "received op " << ty->getName() << " with FROM unset";
 				return HANDLED;
 			}
 
-			Entity* ent = m_view.getEntity(op->getFrom());
+			Entity* ent = getEntity(sightOp, op->getFrom());
 			if (ent) {
 				ent->onAction(op, *ty);
 			}
@@ -263,4 +300,63 @@ Router::RouterResult IGRouter::handleSightOp(const RootOperation& sightOp, const
     return IGNORED;
 }
 
+Router::RouterResult IGRouter::handleSightSet(const RootOperation& op, const RootOperation& sightOp)
+{
+    for (const auto& arg : op->getArgs()) {
+    	if (!arg->isDefaultId()) {
+			auto ent = getEntity(sightOp, arg->getId());
+			if (!ent) {
+				if (m_view.isPending(arg->getId())) {
+					/* no-op, we'll get the state later */
+				} else {
+					m_view.sendLookAt(arg->getId());
+				}
+
+				continue; // we don't have it, ignore
+			}
+
+			//If we get a SET op for an entity that's not visible, it means that the entity has moved
+			//within our field of vision without sending an Appear op first. We should treat this as a
+			//regular Appear op and issue a Look op back, to get more info.
+			if (!ent->isVisible()) {
+//				float stamp = -1;
+//				if (!arg->isDefaultStamp()) {
+//					stamp = static_cast<float>(arg->getStamp());
+//				}
+//
+//				m_view.appear(arg->getId(), stamp);
+				m_view.getEntityFromServer(arg->getId());
+			} else {
+				ent->setFromRoot(arg, false);
+			}
+		}
+    }
+    return HANDLED;
+}
+
+IGRouter::SightOpType IGRouter::getSightOpType(const RootOperation& op)
+{
+    auto classNo = op->getClassNo();
+    std::size_t index = classNo >= 0 ? static_cast<std::size_t>(classNo) : maxCachedClassNo;
+    if (index < m_sightOpTypes.size()) {
+        auto& entry = m_sightOpTypes[index];
+        if (entry.type && entry.type->getName() == op->getParent()) {
+            return entry;
+        }
+    }
+
+    SightOpType opType{m_avatar.getConnection().getTypeService().getTypeForAtlas(op), false};
+    // only bound types are cached, since they can't gain any more ancestors
+    if (opType.type->isBound()) {
+        opType.isAction = opType.type->isA(m_actionType);
+        if (index < maxCachedClassNo) {
+            if (index >= m_sightOpTypes.size()) {
+                m_sightOpTypes.resize(index + 1, SightOpType{nullptr, false});
+            }
+            m_sightOpTypes[index] = opType;
+        }
+    }
+    return opType;
+}
+
 } // of namespace Eris
@@ -3,12 +3,19 @@
 
 #include "Router.h"
 
+#include <sigc++/connection.h>
+
+#include <vector>
+
 namespace Eris {
 
 // forward decls
 class Avatar;
+class Entity;
 class View;
 class TypeInfo;
+template<class T, class... Args>
+class OpDispatchTable;
 
 class IGRouter : public Router
 {
@@ -20,12 +27,64 @@ public:
 protected:
 	RouterResult handleOperation(const Atlas::Objects::Operation::RootOperation& op) override;
 
+	RouterResult routeOperation(const Atlas::Objects::Operation::RootOperation& op,
+								IdInterner::Handle from, IdInterner::Handle to) override;
+
 private:
+    static const OpDispatchTable<IGRouter>& getOpHandlers();
+
+    RouterResult handleSight(const Atlas::Objects::Operation::RootOperation& op);
+
+    RouterResult handleAppearance(const Atlas::Objects::Operation::RootOperation& op);
+
+    RouterResult handleDisappearance(const Atlas::Objects::Operation::RootOperation& op);
+
+    RouterResult handleUnseen(const Atlas::Objects::Operation::RootOperation& op);
+
+    RouterResult handleLogout(const Atlas::Objects::Operation::RootOperation& op);
+
     RouterResult handleSightOp(const Atlas::Objects::Operation::RootOperation& sightOp, const Atlas::Objects::Operation::RootOperation& op);
 
+    static const OpDispatchTable<IGRouter, const Atlas::Objects::Operation::RootOperation&>& getSightOpHandlers();
+
+    RouterResult handleSightSet(const Atlas::Objects::Operation::RootOperation& op, const Atlas::Objects::Operation::RootOperation& sightOp);
+
+    struct SightOpType
+    {
+        TypeInfo* type;
+        bool isAction;
+    };
+
+    /**
+     * Gets the type of an op seen, and whether it's an action. Bound types are cached by class number.
+     */
+    SightOpType getSightOpType(const Atlas::Objects::Operation::RootOperation& op);
+
+    /**
+     * Gets an entity of the view. Most ops seen concern the entity which the sight is from, which is then
+     * found through the handle of its id instead of hashing the id again.
+     */
+    Entity* getEntity(const Atlas::Objects::Operation::RootOperation& sightOp, const std::string& id) const;
+
     Avatar& m_avatar;
     View& m_view;
     TypeInfo* m_actionType;
+
+    /**
+     * The interned FROM id of the op being routed, if routed through routeOperation().
+     */
+    IdInterner::Handle m_routedFrom;
+
+    /**
+     * The bound types of the ops seen, indexed by class number. Ops of a generic class can have any parent,
+     * so the name of an entry is checked before it's used.
+     */
+    std::vector<SightOpType> m_sightOpTypes;
+
+    /**
+     * Clears m_sightOpTypes when a type is removed.
+     */
+    sigc::connection m_badTypeConnection;
 };
 
 } // of namespace Eris
@@ -0,0 +1,93 @@
+#include "IdInterner.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace Eris
+{
+
+namespace {
+const std::string emptyId;
+
+/**
+ * Ids which are interned but never released, such as property names, would otherwise overflow the count
+ * eventually. Once it reaches this the id is kept for good.
+ */
+const std::uint32_t maxReferences = UINT32_MAX;
+
+void addReference(std::uint32_t& references)
+{
+	if (references != maxReferences) {
+		references++;
+	}
+}
+}
+
+IdInterner::IdInterner() :
+		m_ids(1, Entry{&emptyId, 0})
+{
+}
+
+IdInterner::Handle IdInterner::intern(const std::string& id)
+{
+	auto I = m_handles.find(id);
+	if (I != m_handles.end()) {
+		addReference(m_ids[I->second].references);
+		return I->second;
+	}
+	Handle handle;
+	if (!m_freeHandles.empty()) {
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	} else {
+		handle = static_cast<Handle>(m_ids.size());
+		m_ids.push_back(Entry{nullptr, 0});
+	}
+	auto result = m_handles.emplace(id, handle);
+	m_ids[handle] = Entry{&result.first->first, 1};
+	return handle;
+}
+
+void IdInterner::retain(Handle handle)
+{
+	assert(handle != INVALID_HANDLE && handle < m_ids.size() && m_ids[handle].id);
+	addReference(m_ids[handle].references);
+}
+
+void IdInterner::release(Handle handle)
+{
+	if (handle == INVALID_HANDLE || handle >= m_ids.size() || !m_ids[handle].id) {
+		return;
+	}
+	auto& entry = m_ids[handle];
+	if (entry.references != maxReferences && --entry.references == 0) {
+		//Copy the id, since the key it points to is what's erased.
+		m_handles.erase(std::string(*entry.id));
+		entry.id = nullptr;
+		m_freeHandles.push_back(handle);
+	}
+}
+
+IdInterner::Handle IdInterner::find(const std::string& id) const
+{
+	auto I = m_handles.find(id);
+	if (I == m_handles.end()) {
+		return INVALID_HANDLE;
+	}
+	return I->second;
+}
+
+const std::string& IdInterner::getId(Handle handle) const
+{
+	if (handle >= m_ids.size() || !m_ids[handle].id) {
+		return emptyId;
+	}
+	return *m_ids[handle].id;
+}
+
+std::size_t IdInterner::size() const
+{
+	return m_handles.size();
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef ERIS_IDINTERNER_H
+#define ERIS_IDINTERNER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Eris
+{
+
+/**
+ * @brief Hands out compact integer handles for ids, such as those of entities and accounts.
+ *
+ * Each Connection has one of these. Received ops have their ids looked up once, when they are queued, after
+ * which the routers and entities they concern can be found through the handles, without hashing and comparing
+ * the strings again.
+ *
+ * Interned ids are reference counted. Each intern() or retain() needs to be matched by a release(), after
+ * which the id is removed and its handle may be handed out for another id. The table thus only holds the ids
+ * which something is currently registered for; ids which are only looked up aren't added.
+ */
+class IdInterner
+{
+public:
+	typedef std::uint32_t Handle;
+
+	/**
+	 * The handle of ids which haven't been interned.
+	 */
+	static const Handle INVALID_HANDLE = 0;
+
+	IdInterner();
+
+	/**
+	 * @brief Gets the handle for the id, adding it if needed, and adds a reference to it.
+	 */
+	Handle intern(const std::string& id);
+
+	/**
+	 * @brief Adds a reference to an interned id.
+	 */
+	void retain(Handle handle);
+
+	/**
+	 * @brief Removes a reference to an interned id, removing the id once there are none left.
+	 *
+	 * Does nothing for INVALID_HANDLE.
+	 */
+	void release(Handle handle);
+
+	/**
+	 * @brief Gets the handle for the id, or INVALID_HANDLE if it hasn't been interned.
+	 */
+	Handle find(const std::string& id) const;
+
+	/**
+	 * @brief Gets the id of a handle, or an empty string for INVALID_HANDLE and released handles.
+	 */
+	const std::string& getId(Handle handle) const;
+
+	/**
+	 * @brief Gets the number of interned ids.
+	 */
+	std::size_t size() const;
+
+private:
+	std::unordered_map<std::string, Handle> m_handles;
+
+	struct Entry
+	{
+		/**
+		 * Points to the key in m_handles, which doesn't move. Null if the handle is free.
+		 */
+		const std::string* id;
+		std::uint32_t references;
+	};
+
+	/**
+	 * The ids, indexed by handle.
+	 */
+	std::vector<Entry> m_ids;
+
+	/**
+	 * Handles which have been released, and can be handed out again.
+	 */
+	std::vector<Handle> m_freeHandles;
+};
+
+}
+
+#endif //ERIS_IDINTERNER_H
@@ -0,0 +1,225 @@
+#include "IoUringService.h"
+#include "Exceptions.h"
+#include "Log.h"
+
+#include <sys/eventfd.h>
+
+#include <cstring>
+
+namespace Eris
+{
+
+namespace
+{
+/**
+ * Number of entries in the submission queue. The completion queue is twice as large.
+ */
+const unsigned queueDepth = 256;
+
+/**
+ * Number and size of the registered buffers used for reading.
+ */
+const int registeredBufferCount = 16;
+const std::size_t registeredBufferSize = 64 * 1024;
+}
+
+boost::asio::io_service::id IoUringService::id;
+
+IoUringService::IoUringService(boost::asio::io_service& io_service) :
+		boost::asio::io_service::service(io_service),
+		mRing{},
+		mRingInitialized(false),
+		mEventDescriptor(io_service),
+		mEventValue(0),
+		mBufferSize(registeredBufferSize),
+		mSubmitScheduled(false),
+		mWaiting(false),
+		mSubmitCalls(0),
+		mSubmittedOperations(0)
+{
+	auto result = io_uring_queue_init(queueDepth, &mRing, 0);
+	if (result < 0) {
+		throw NetworkFailure(std::string("Could not create io_uring instance: ") + std::strerror(-result));
+	}
+	mRingInitialized = true;
+
+	int eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (eventFd < 0) {
+		io_uring_queue_exit(&mRing);
+		throw NetworkFailure(std::string("Could not create eventfd: ") + std::strerror(errno));
+	}
+	mEventDescriptor.assign(eventFd);
+	result = io_uring_register_eventfd(&mRing, eventFd);
+	if (result < 0) {
+		io_uring_queue_exit(&mRing);
+		throw NetworkFailure(std::string("Could not register eventfd with io_uring: ") + std::strerror(-result));
+	}
+
+	mBufferMemory.reset(new char[registeredBufferCount * mBufferSize]);
+	std::vector<iovec> iovecs;
+	for (int i = 0; i < registeredBufferCount; ++i) {
+		iovecs.push_back(iovec{mBufferMemory.get() + i * mBufferSize, mBufferSize});
+	}
+	result = io_uring_register_buffers(&mRing, iovecs.data(), static_cast<unsigned>(iovecs.size()));
+	if (result < 0) {
+		//Usually happens if the limit on locked memory is too low. Everything still works, just with plain reads.
+		warning() << "Could not register buffers with io_uring, will use plain reads: " << std::strerror(-result);
+		mBufferMemory.reset();
+	} else {
+		for (int i = registeredBufferCount - 1; i >= 0; --i) {
+			mFreeBuffers.push_back(i);
+		}
+	}
+}
+
+IoUringService::~IoUringService()
+{
+	shutdown();
+}
+
+void IoUringService::shutdown()
+{
+	if (mRingInitialized) {
+		boost::system::error_code ec;
+		mEventDescriptor.close(ec);
+		//Any operations still in flight are cancelled when the ring is torn down.
+		io_uring_queue_exit(&mRing);
+		mRingInitialized = false;
+		//The handlers might hold references to sockets, so make sure these are released.
+		mOperations.clear();
+	}
+}
+
+void IoUringService::asyncRead(int fd, boost::asio::mutable_buffer fallback, ReadHandler handler)
+{
+	std::unique_ptr<Operation> operation(new Operation());
+	operation->fd = fd;
+	operation->readHandler = std::move(handler);
+
+	auto sqe = getSqe();
+	if (!mFreeBuffers.empty()) {
+		operation->bufferIndex = mFreeBuffers.back();
+		mFreeBuffers.pop_back();
+		io_uring_prep_read_fixed(sqe, fd, mBufferMemory.get() + operation->bufferIndex * mBufferSize,
+								 static_cast<unsigned>(mBufferSize), 0, operation->bufferIndex);
+	} else {
+		operation->fallback = static_cast<const char*>(fallback.data());
+		io_uring_prep_read(sqe, fd, fallback.data(), static_cast<unsigned>(fallback.size()), 0);
+	}
+	io_uring_sqe_set_data(sqe, operation.get());
+	mOperations.emplace(operation.get(), std::move(operation));
+	scheduleSubmit();
+}
+
+void IoUringService::prepareWrite(int fd, std::unique_ptr<Operation> operation)
+{
+	auto sqe = getSqe();
+	io_uring_prep_writev(sqe, fd, operation->iovecs.data(), static_cast<unsigned>(operation->iovecs.size()), 0);
+	io_uring_sqe_set_data(sqe, operation.get());
+	mOperations.emplace(operation.get(), std::move(operation));
+	scheduleSubmit();
+}
+
+void IoUringService::cancel(int fd)
+{
+	bool cancelled = false;
+	for (auto& entry : mOperations) {
+		if (entry.second->fd == fd) {
+			auto sqe = getSqe();
+			io_uring_prep_cancel(sqe, entry.first, 0);
+			//The completion of the cancellation itself isn't of interest, so it isn't tied to any operation.
+			io_uring_sqe_set_data(sqe, nullptr);
+			cancelled = true;
+		}
+	}
+	if (cancelled) {
+		scheduleSubmit();
+	}
+}
+
+io_uring_sqe* IoUringService::getSqe()
+{
+	auto sqe = io_uring_get_sqe(&mRing);
+	if (!sqe) {
+		//The submission queue is full, so we need to submit what we have right away.
+		submit();
+		sqe = io_uring_get_sqe(&mRing);
+	}
+	return sqe;
+}
+
+void IoUringService::scheduleSubmit()
+{
+	//All operations queued by the current handler, and any other handler which runs before the posted one,
+	//are submitted in one go.
+	if (!mSubmitScheduled) {
+		mSubmitScheduled = true;
+		get_io_context().post([this]() {
+			mSubmitScheduled = false;
+			submit();
+		});
+	}
+	if (!mWaiting) {
+		waitForCompletions();
+	}
+}
+
+void IoUringService::submit()
+{
+	if (!mRingInitialized) {
+		return;
+	}
+	auto result = io_uring_submit(&mRing);
+	mSubmitCalls++;
+	if (result < 0) {
+		error() << "Could not submit operations to io_uring: " << std::strerror(-result);
+	} else {
+		mSubmittedOperations += static_cast<std::uint64_t>(result);
+	}
+}
+
+void IoUringService::waitForCompletions()
+{
+	//We only wait while there are operations in flight, so that io_service::run() can return once everything is done.
+	mWaiting = true;
+	mEventDescriptor.async_read_some(boost::asio::buffer(&mEventValue, sizeof(mEventValue)),
+									 [this](boost::system::error_code ec, std::size_t) {
+										 mWaiting = false;
+										 if (ec == boost::asio::error::operation_aborted) {
+											 return;
+										 }
+										 reapCompletions();
+										 if (!mWaiting && !mOperations.empty()) {
+											 waitForCompletions();
+										 }
+									 });
+}
+
+void IoUringService::reapCompletions()
+{
+	io_uring_cqe* cqe;
+	while (mRingInitialized && io_uring_peek_cqe(&mRing, &cqe) == 0) {
+		auto I = mOperations.find(static_cast<Operation*>(io_uring_cqe_get_data(cqe)));
+		auto result = cqe->res;
+		io_uring_cqe_seen(&mRing, cqe);
+		if (I == mOperations.end()) {
+			continue;
+		}
+		//Take ownership of the operation, since the handler might queue new operations.
+		auto operation = std::move(I->second);
+		mOperations.erase(I);
+
+		if (operation->readHandler) {
+			if (operation->bufferIndex != -1) {
+				operation->readHandler(result, mBufferMemory.get() + operation->bufferIndex * mBufferSize);
+				mFreeBuffers.push_back(operation->bufferIndex);
+			} else {
+				operation->readHandler(result, operation->fallback);
+			}
+		} else if (operation->writeHandler) {
+			operation->writeHandler(result);
+		}
+	}
+}
+
+}
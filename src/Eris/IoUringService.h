@@ -0,0 +1,182 @@
+#ifndef ERIS_IOURINGSERVICE_H
+#define ERIS_IOURINGSERVICE_H
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <liburing.h>
+
+#include <sys/uio.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <climits>
+
+namespace Eris
+{
+
+/**
+ * @brief Performs socket I/O through an io_uring instance which is shared by all sockets using the same io_service.
+ *
+ * Operations are queued into the submission ring and submitted in one batch once the current handler of the
+ * io_service has finished, so that a client with many connections only needs one system call per turn of the
+ * event loop to start all its reads and writes. Completions are signalled through an eventfd which is
+ * watched by the io_service, so all handlers are called from the thread running the io_service.
+ *
+ * A pool of buffers is registered with the kernel and used for reads, which saves the kernel from having to
+ * map the pages for every read. If all registered buffers are in use, reads fall back to a caller supplied buffer.
+ *
+ * Obtain the instance for an io_service through boost::asio::use_service<IoUringService>(io_service).
+ */
+class IoUringService : public boost::asio::io_service::service
+{
+public:
+
+	/**
+	 * @brief Called when a read has completed.
+	 *
+	 * The first parameter is the number of bytes read, or a negated errno value. The second parameter
+	 * points to the data read, which is either the fallback buffer or a registered buffer. A registered buffer
+	 * is only valid during the call.
+	 */
+	typedef std::function<void(int, const char*)> ReadHandler;
+
+	/**
+	 * @brief Called when a write has completed, with the number of bytes written or a negated errno value.
+	 */
+	typedef std::function<void(int)> WriteHandler;
+
+	static boost::asio::io_service::id id;
+
+	explicit IoUringService(boost::asio::io_service& io_service);
+
+	~IoUringService() override;
+
+	/**
+	 * @brief Starts reading from a file descriptor.
+	 * @param fd A socket in blocking mode.
+	 * @param fallback A buffer to read into if no registered buffer is available.
+	 * @param handler Called on completion.
+	 */
+	void asyncRead(int fd, boost::asio::mutable_buffer fallback, ReadHandler handler);
+
+	/**
+	 * @brief Starts a gathered write to a file descriptor. The memory of the buffers must stay valid until the write completes.
+	 * @param fd A socket in blocking mode.
+	 * @param buffers The buffers to write. At most IOV_MAX buffers are written.
+	 * @param handler Called on completion. Like with any write, not all data might have been written.
+	 * @return The number of bytes submitted for writing.
+	 */
+	template<typename ConstBufferSequence>
+	std::size_t asyncWrite(int fd, const ConstBufferSequence& buffers, WriteHandler handler);
+
+	/**
+	 * @brief Cancels all operations in flight on a file descriptor.
+	 *
+	 * The handlers of the operations are called with -ECANCELED, unless they completed before the cancellation
+	 * took effect.
+	 */
+	void cancel(int fd);
+
+	/**
+	 * @brief Gets the number of io_uring_enter system calls made to submit operations.
+	 */
+	std::uint64_t getSubmitCalls() const;
+
+	/**
+	 * @brief Gets the number of operations submitted.
+	 */
+	std::uint64_t getSubmittedOperations() const;
+
+private:
+
+	struct Operation
+	{
+		int fd = -1;
+		ReadHandler readHandler;
+		WriteHandler writeHandler;
+		std::vector<iovec> iovecs;
+		/**
+		 * Index of the registered buffer used for reading, or -1.
+		 */
+		int bufferIndex = -1;
+		const char* fallback = nullptr;
+	};
+
+	io_uring mRing;
+	bool mRingInitialized;
+
+	/**
+	 * Signalled by the kernel whenever completions are posted.
+	 */
+	boost::asio::posix::stream_descriptor mEventDescriptor;
+	std::uint64_t mEventValue;
+
+	std::unique_ptr<char[]> mBufferMemory;
+	std::vector<int> mFreeBuffers;
+	std::size_t mBufferSize;
+
+	bool mSubmitScheduled;
+
+	/**
+	 * True while waiting for the eventfd to be signalled.
+	 */
+	bool mWaiting;
+
+	/**
+	 * Operations queued but not yet completed, keyed by the pointer passed to the kernel as user data.
+	 */
+	std::unordered_map<Operation*, std::unique_ptr<Operation>> mOperations;
+
+	std::uint64_t mSubmitCalls;
+	std::uint64_t mSubmittedOperations;
+
+	void shutdown() override;
+
+	io_uring_sqe* getSqe();
+
+	void scheduleSubmit();
+
+	void submit();
+
+	void waitForCompletions();
+
+	void reapCompletions();
+
+	void prepareWrite(int fd, std::unique_ptr<Operation> operation);
+};
+
+template<typename ConstBufferSequence>
+std::size_t IoUringService::asyncWrite(int fd, const ConstBufferSequence& buffers, WriteHandler handler)
+{
+	std::unique_ptr<Operation> operation(new Operation());
+	operation->fd = fd;
+	operation->writeHandler = std::move(handler);
+	std::size_t size = 0;
+	for (auto I = boost::asio::buffer_sequence_begin(buffers); I != boost::asio::buffer_sequence_end(buffers)
+															   && operation->iovecs.size() < IOV_MAX; ++I) {
+		boost::asio::const_buffer buffer(*I);
+		operation->iovecs.push_back(iovec{const_cast<void*>(buffer.data()), buffer.size()});
+		size += buffer.size();
+	}
+	prepareWrite(fd, std::move(operation));
+	return size;
+}
+
+inline std::uint64_t IoUringService::getSubmitCalls() const
+{
+	return mSubmitCalls;
+}
+
+inline std::uint64_t IoUringService::getSubmittedOperations() const
+{
+	return mSubmittedOperations;
+}
+
+}
+
+#endif //ERIS_IOURINGSERVICE_H
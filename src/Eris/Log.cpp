@@ -3,6 +3,7 @@
 #endif
 
 #include "Log.h"
+#include "AsyncLogSink.h"
 
 #include <Atlas/Message/MEncoder.h>
 #include <Atlas/Objects/Operation.h>
@@ -13,23 +14,69 @@
 namespace Eris
 {
 
-static LogLevel _logLevel = DEFAULT_LOG;    
+std::atomic<LogLevel> detail::logLevel(DEFAULT_LOG);
+
+static std::atomic<AsyncLogSink*> asyncLogSink(nullptr);
+
 sigc::signal<void(LogLevel, const std::string&)> Logged;
     
 void setLogLevel(LogLevel lvl)
 {
-    _logLevel = lvl;
+    detail::logLevel = lvl;
 }    
     
 LogLevel getLogLevel()
 {
-    return _logLevel;
+    return detail::logLevel;
 }
 
 void doLog(LogLevel lvl, const std::string& msg)
 {
-    if (lvl <= _logLevel)
-        Logged.emit(lvl, msg);
+    if (isLogging(lvl)) {
+        auto sink = asyncLogSink.load(std::memory_order_acquire);
+        if (sink) {
+            sink->push(lvl, msg);
+        } else {
+            Logged.emit(lvl, msg);
+        }
+    }
+}
+
+void setAsyncLogSink(AsyncLogSink* sink)
+{
+    asyncLogSink.store(sink, std::memory_order_release);
+}
+
+LogRateLimiter::LogRateLimiter(unsigned int burst, std::chrono::steady_clock::duration interval) :
+    m_burst(burst),
+    m_interval(interval),
+    m_intervalStart(std::chrono::steady_clock::now().time_since_epoch().count()),
+    m_count(0),
+    m_suppressed(0)
+{
+}
+
+bool LogRateLimiter::allow()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto start = m_intervalStart.load(std::memory_order_relaxed);
+    if (now - start >= m_interval.count() && m_intervalStart.compare_exchange_strong(start, now)) {
+        m_count = 0;
+    }
+    if (m_count.fetch_add(1) < m_burst) {
+        return true;
+    }
+    m_suppressed++;
+    return false;
+}
+
+std::string LogRateLimiter::takeSuppressedNote()
+{
+    auto suppressed = m_suppressed.exchange(0);
+    if (suppressed == 0) {
+        return "";
+    }
+    return "(" + std::to_string(suppressed) + " similar messages suppressed) ";
 }
 
 std::ostream& operator<<(std::ostream& os, const Atlas::Objects::Root& obj)
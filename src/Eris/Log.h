@@ -3,6 +3,9 @@
 
 #include <sigc++/signal.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 namespace Eris {
@@ -31,6 +34,59 @@ void setLogLevel(LogLevel lvl);
 
 LogLevel getLogLevel();
 
+namespace detail {
+extern std::atomic<LogLevel> logLevel;
+}
+
+/**
+ * @brief Returns true if messages of the level are currently logged.
+ *
+ * This is cheap enough to be called before formatting any message; the ERIS_DEBUG() family of macros does so.
+ */
+inline bool isLogging(LogLevel lvl)
+{
+	return lvl <= detail::logLevel.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Limits how many messages are logged from one place, to keep storms of the same warning in check.
+ *
+ * Up to a number of messages are allowed in each interval. The number of messages suppressed is added
+ * to the next one logged. Used by the ERIS_WARNING_LIMITED() family of macros, with one limiter per call site.
+ */
+class LogRateLimiter
+{
+public:
+	explicit LogRateLimiter(unsigned int burst = 10, std::chrono::steady_clock::duration interval = std::chrono::seconds(1));
+
+	/**
+	 * @brief Returns true if a message may be logged now.
+	 */
+	bool allow();
+
+	/**
+	 * @brief Gets a note about the messages suppressed since the last one allowed, or an empty string if there were none.
+	 */
+	std::string takeSuppressedNote();
+
+private:
+	const unsigned int m_burst;
+	const std::chrono::steady_clock::duration m_interval;
+	std::atomic<std::chrono::steady_clock::rep> m_intervalStart;
+	std::atomic<unsigned int> m_count;
+	std::atomic<std::uint64_t> m_suppressed;
+};
+
+class AsyncLogSink;
+
+/**
+ * @brief Passes all logged messages to the sink, instead of emitting them through Logged.
+ *
+ * The sink calls its handler on its own thread, so handling the messages never holds up the caller.
+ * @param sink A sink, or null to emit messages through Logged again. Must be kept alive while set.
+ */
+void setAsyncLogSink(AsyncLogSink* sink);
+
 }
 
 #include "LogStream.h"
@@ -75,4 +75,25 @@ std::ostream& operator<<(std::ostream& s, const Atlas::Message::Element& msg);
 
 } // of namespace Eris
 
+/**
+ * Logging macros, used like the stream classes, e.g. ERIS_DEBUG() << "received op:" << parent;
+ * Nothing is formatted if the level isn't logged.
+ */
+#define ERIS_LOG_AT(level, stream) if (!::Eris::isLogging(level)) {} else ::Eris::stream()
+
+#define ERIS_ERROR() ERIS_LOG_AT(::Eris::LOG_ERROR, error)
+#define ERIS_WARNING() ERIS_LOG_AT(::Eris::LOG_WARNING, warning)
+#define ERIS_NOTICE() ERIS_LOG_AT(::Eris::LOG_NOTICE, notice)
+#define ERIS_DEBUG() ERIS_LOG_AT(::Eris::LOG_DEBUG, debug)
+
+/**
+ * Like ERIS_LOG_AT, but with the messages from the call site limited by a LogRateLimiter.
+ */
+#define ERIS_LOG_LIMITED_AT(level, stream) \
+	if (static ::Eris::LogRateLimiter erisLogRateLimiter; !::Eris::isLogging(level) || !erisLogRateLimiter.allow()) {} \
+	else ::Eris::stream() << erisLogRateLimiter.takeSuppressedNote()
+
+#define ERIS_ERROR_LIMITED() ERIS_LOG_LIMITED_AT(::Eris::LOG_ERROR, error)
+#define ERIS_WARNING_LIMITED() ERIS_LOG_LIMITED_AT(::Eris::LOG_WARNING, warning)
+
 #endif
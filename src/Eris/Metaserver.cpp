@@ -10,6 +10,7 @@
 #include "Log.h"
 #include "EventService.h"
 #include "Exceptions.h"
+#include "ResolverCache.h"
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/RootEntity.h>
@@ -80,7 +81,6 @@ Meta::Meta(boost::asio::io_service& io_service,
 		m_metaHost(std::move(metaServer)),
 		m_maxActiveQueries(maxQueries),
 		m_nextQuery(0),
-		m_resolver(io_service),
 		m_socket(io_service),
 		m_metaTimer(io_service),
 		m_receive_stream(&m_receive_buffer),
@@ -187,11 +187,14 @@ size_t Meta::getGameServerCount() const {
 }
 
 void Meta::connect() {
-	boost::asio::ip::udp::resolver::query query(m_metaHost, META_SERVER_PORT);
-	m_resolver.async_resolve(query,
-							 [&](const boost::system::error_code& ec, boost::asio::ip::udp::resolver::iterator iterator) {
-								 if (!ec && iterator != boost::asio::ip::udp::resolver::iterator()) {
-									 this->connect(*iterator);
+	std::shared_ptr<bool> marker = m_activeMarker;
+	boost::asio::use_service<ResolverCache>(m_io_service).resolve<boost::asio::ip::udp>(m_metaHost, META_SERVER_PORT,
+							 [this, marker](const boost::system::error_code& ec, const std::vector<boost::asio::ip::udp::endpoint>& endpoints) {
+								 if (!*marker) {
+									 return;
+								 }
+								 if (!ec && !endpoints.empty()) {
+									 this->connect(endpoints.front());
 								 } else {
 									 this->disconnect();
 								 }
@@ -5,6 +5,7 @@
 
 #include "Types.h"
 #include "ServerInfo.h"
+#include "ActiveMarker.h"
 
 #include <Atlas/Objects/Decoder.h>
 
@@ -192,7 +193,8 @@ private:
 	ServerInfoArray m_gameServers,
 			m_lastValidList;
 
-	boost::asio::ip::udp::resolver m_resolver;
+	/// prevents lookup results from arriving after destruction
+	ActiveMarker m_activeMarker;
 
 	// storage for the Metaserver protocol
 	boost::asio::ip::udp::socket m_socket;
@@ -0,0 +1,117 @@
+#ifndef ERIS_NATIVEPROPERTIES_H
+#define ERIS_NATIVEPROPERTIES_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace Eris
+{
+
+/**
+ * @brief The properties which Entity keeps in members of its own, in addition to the property map.
+ */
+enum class NativeProperty : std::uint8_t
+{
+	NAME,
+	STAMP,
+	POS,
+	VELOCITY,
+	ANGULAR,
+	ACCEL,
+	ORIENTATION,
+	BBOX,
+	LOC,
+	CONTAINS,
+	TASKS,
+	SCALE,
+	NONE ///< not a native property
+};
+
+/**
+ * @brief Maps property names to native property ids, using a perfect hash which is checked at compile time.
+ */
+namespace NativeProperties
+{
+
+/**
+ * The names of the native properties, in the order of NativeProperty.
+ */
+constexpr std::array<std::string_view, static_cast<std::size_t>(NativeProperty::NONE)> names{
+		"name", "stamp", "pos", "velocity", "angular", "accel", "orientation", "bbox", "loc", "contains", "tasks", "scale"
+};
+
+constexpr std::size_t tableSize = 32;
+
+/**
+ * Hashes the length and the first and last characters of the name, which is enough to tell the native properties apart.
+ */
+constexpr std::size_t hash(std::string_view name)
+{
+	if (name.empty()) {
+		return 0;
+	}
+	return (static_cast<std::size_t>(static_cast<unsigned char>(name.front()))
+			+ (static_cast<std::size_t>(static_cast<unsigned char>(name.back())) << 1u)
+			+ (name.size() << 3u)) % tableSize;
+}
+
+constexpr bool isPerfectHash()
+{
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		for (std::size_t j = i + 1; j < names.size(); ++j) {
+			if (hash(names[i]) == hash(names[j])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static_assert(isPerfectHash(), "Two native property names hash to the same slot; the hash function needs to be changed.");
+
+constexpr std::array<NativeProperty, tableSize> buildTable()
+{
+	std::array<NativeProperty, tableSize> table{};
+	for (std::size_t i = 0; i < tableSize; ++i) {
+		table[i] = NativeProperty::NONE;
+	}
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		table[hash(names[i])] = static_cast<NativeProperty>(i);
+	}
+	return table;
+}
+
+constexpr std::array<NativeProperty, tableSize> table = buildTable();
+
+/**
+ * @brief Gets the native property with the name, or NativeProperty::NONE if there is none.
+ *
+ * Only one string comparison is made, against the name in the slot the name hashes to.
+ */
+constexpr NativeProperty lookup(std::string_view name)
+{
+	auto property = table[hash(name)];
+	if (property != NativeProperty::NONE && names[static_cast<std::size_t>(property)] == name) {
+		return property;
+	}
+	return NativeProperty::NONE;
+}
+
+/**
+ * @brief Gets the bit representing the property in a mask of native properties.
+ */
+constexpr std::uint32_t bit(NativeProperty property)
+{
+	return property == NativeProperty::NONE ? 0u : (1u << static_cast<unsigned int>(property));
+}
+
+static_assert(lookup("pos") == NativeProperty::POS, "The lookup table is broken.");
+static_assert(lookup("scale") == NativeProperty::SCALE, "The lookup table is broken.");
+static_assert(lookup("mode") == NativeProperty::NONE, "The lookup table is broken.");
+
+}
+
+}
+
+#endif //ERIS_NATIVEPROPERTIES_H
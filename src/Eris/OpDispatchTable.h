@@ -0,0 +1,74 @@
+#ifndef ERIS_OPDISPATCHTABLE_H
+#define ERIS_OPDISPATCHTABLE_H
+
+#include "Router.h"
+
+#include <Atlas/Objects/RootOperation.h>
+
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace Eris
+{
+
+/**
+ * @brief Maps the class numbers of ops straight to the member functions handling them.
+ *
+ * Routers build one table each, the first time it's needed, instead of comparing the class
+ * number of every op against each kind of op they handle in turn. Only exact class numbers
+ * are matched; ops derived from a handled class aren't.
+ *
+ * Any further arguments the handlers take are passed on by dispatch().
+ */
+template<class T, class... Args>
+class OpDispatchTable
+{
+public:
+	typedef Router::RouterResult (T::*Handler)(const Atlas::Objects::Operation::RootOperation& op, Args... args);
+
+	OpDispatchTable(std::initializer_list<std::pair<int, Handler>> handlers)
+	{
+		for (auto& entry : handlers) {
+			if (entry.first < 0) {
+				continue;
+			}
+			auto index = static_cast<std::size_t>(entry.first);
+			if (index >= m_handlers.size()) {
+				m_handlers.resize(index + 1, nullptr);
+			}
+			m_handlers[index] = entry.second;
+		}
+	}
+
+	/**
+	 * @brief Gets the handler for ops of the class, or null if there is none.
+	 */
+	Handler find(int classNo) const
+	{
+		if (classNo < 0 || static_cast<std::size_t>(classNo) >= m_handlers.size()) {
+			return nullptr;
+		}
+		return m_handlers[static_cast<std::size_t>(classNo)];
+	}
+
+	/**
+	 * @brief Calls the handler for the op on the instance.
+	 * @return The result of the handler, or IGNORED if there is none.
+	 */
+	Router::RouterResult dispatch(T& instance, const Atlas::Objects::Operation::RootOperation& op, Args... args) const
+	{
+		auto handler = find(op->getClassNo());
+		if (!handler) {
+			return Router::IGNORED;
+		}
+		return (instance.*handler)(op, args...);
+	}
+
+private:
+	std::vector<Handler> m_handlers;
+};
+
+}
+
+#endif //ERIS_OPDISPATCHTABLE_H
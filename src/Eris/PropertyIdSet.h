@@ -0,0 +1,229 @@
+#ifndef ERIS_PROPERTYIDSET_H
+#define ERIS_PROPERTYIDSET_H
+
+#include "IdInterner.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Eris
+{
+
+/**
+ * @brief A set of property names, held as a bitset of their handles in an IdInterner.
+ *
+ * Entities use this to track which properties an update has modified. The handles of property names are small,
+ * dense integers, so a few words cover all names in use. Clearing the set keeps the words, so once an entity has
+ * seen the properties it's updated with, tracking them doesn't allocate.
+ *
+ * Iterating over the set yields the handles, in increasing order; getName() gets the names back.
+ */
+class PropertyIdSet
+{
+public:
+	class const_iterator;
+
+	/**
+	 * @param names Interns the property names. Must outlive the set.
+	 */
+	explicit PropertyIdSet(IdInterner& names) : m_names(&names), m_size(0)
+	{
+	}
+
+	/**
+	 * @brief Adds the handle of a property name.
+	 * @return True if it wasn't already in the set.
+	 */
+	bool insert(IdInterner::Handle name)
+	{
+		auto index = name / bitsPerWord;
+		if (index >= m_words.size()) {
+			m_words.resize(index + 1, 0);
+		}
+		auto bit = std::uint64_t(1) << (name % bitsPerWord);
+		if (m_words[index] & bit) {
+			return false;
+		}
+		m_words[index] |= bit;
+		++m_size;
+		return true;
+	}
+
+	/**
+	 * @brief Adds a property name, interning it if needed.
+	 * @return True if it wasn't already in the set.
+	 */
+	bool insert(const std::string& name)
+	{
+		return insert(m_names->intern(name));
+	}
+
+	bool contains(IdInterner::Handle name) const
+	{
+		auto index = name / bitsPerWord;
+		return index < m_words.size() && (m_words[index] & (std::uint64_t(1) << (name % bitsPerWord)));
+	}
+
+	bool contains(const std::string& name) const
+	{
+		auto handle = m_names->find(name);
+		return handle != IdInterner::INVALID_HANDLE && contains(handle);
+	}
+
+	/**
+	 * @brief Empties the set, keeping the space allocated for it.
+	 */
+	void clear()
+	{
+		if (m_size != 0) {
+			std::fill(m_words.begin(), m_words.end(), 0);
+			m_size = 0;
+		}
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	const std::string& getName(IdInterner::Handle name) const
+	{
+		return m_names->getId(name);
+	}
+
+	IdInterner& getNames() const
+	{
+		return *m_names;
+	}
+
+	/**
+	 * @brief Copies the names in the set into a std::set.
+	 */
+	std::set<std::string> toStringSet() const;
+
+	const_iterator begin() const;
+
+	const_iterator end() const;
+
+private:
+	static constexpr IdInterner::Handle bitsPerWord = 64;
+
+	IdInterner* m_names;
+	std::vector<std::uint64_t> m_words;
+	std::size_t m_size;
+};
+
+class PropertyIdSet::const_iterator
+{
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef IdInterner::Handle value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const IdInterner::Handle* pointer;
+	typedef IdInterner::Handle reference;
+
+	const_iterator(const std::uint64_t* word, const std::uint64_t* end) :
+			m_word(word), m_end(end), m_bits(word != end ? *word : 0), m_first(0)
+	{
+		skipEmpty();
+	}
+
+	IdInterner::Handle operator*() const
+	{
+		return m_first + lowestBit(m_bits);
+	}
+
+	const_iterator& operator++()
+	{
+		//Clear the lowest set bit.
+		m_bits &= m_bits - 1;
+		skipEmpty();
+		return *this;
+	}
+
+	const_iterator operator++(int)
+	{
+		const_iterator result(*this);
+		++*this;
+		return result;
+	}
+
+	bool operator==(const const_iterator& rhs) const
+	{
+		return m_word == rhs.m_word && m_bits == rhs.m_bits;
+	}
+
+	bool operator!=(const const_iterator& rhs) const
+	{
+		return !(*this == rhs);
+	}
+
+private:
+	const std::uint64_t* m_word;
+	const std::uint64_t* m_end;
+	/**
+	 * The bits of the current word which haven't been visited yet.
+	 */
+	std::uint64_t m_bits;
+	/**
+	 * The handle of the first bit of the current word.
+	 */
+	IdInterner::Handle m_first;
+
+	static IdInterner::Handle lowestBit(std::uint64_t bits)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return static_cast<IdInterner::Handle>(index);
+#else
+		return static_cast<IdInterner::Handle>(__builtin_ctzll(bits));
+#endif
+	}
+
+	void skipEmpty()
+	{
+		while (m_bits == 0 && m_word != m_end) {
+			++m_word;
+			m_first += bitsPerWord;
+			m_bits = m_word != m_end ? *m_word : 0;
+		}
+	}
+};
+
+inline PropertyIdSet::const_iterator PropertyIdSet::begin() const
+{
+	return {m_words.data(), m_words.data() + m_words.size()};
+}
+
+inline PropertyIdSet::const_iterator PropertyIdSet::end() const
+{
+	return {m_words.data() + m_words.size(), m_words.data() + m_words.size()};
+}
+
+inline std::set<std::string> PropertyIdSet::toStringSet() const
+{
+	std::set<std::string> names;
+	for (auto handle : *this) {
+		names.insert(getName(handle));
+	}
+	return names;
+}
+
+}
+
+#endif //ERIS_PROPERTYIDSET_H
@@ -0,0 +1,270 @@
+#include "PropertyTable.h"
+
+#include <utility>
+
+namespace Eris
+{
+
+namespace {
+/**
+ * Spreads the handles, which are handed out in sequence, over the slots. Since the multiplier is odd, handles
+ * within a range of the table size never end up in the same slot.
+ */
+const std::uint32_t hashMultiplier = 2654435769u;
+
+const std::uint32_t minimumCapacity = 8;
+}
+
+PropertyTable::PropertyTable(IdInterner& names) :
+		m_names(&names),
+		m_capacity(0),
+		m_size(0)
+{
+}
+
+PropertyTable::PropertyTable(const PropertyTable& rhs) :
+		m_names(rhs.m_names),
+		m_capacity(0),
+		m_size(0)
+{
+	copyFrom(rhs);
+}
+
+PropertyTable::PropertyTable(PropertyTable&& rhs) noexcept :
+		m_names(rhs.m_names),
+		m_slots(std::move(rhs.m_slots)),
+		m_capacity(rhs.m_capacity),
+		m_size(rhs.m_size)
+{
+	rhs.m_capacity = 0;
+	rhs.m_size = 0;
+}
+
+PropertyTable::~PropertyTable()
+{
+	destroy();
+}
+
+PropertyTable& PropertyTable::operator=(const PropertyTable& rhs)
+{
+	if (this != &rhs) {
+		destroy();
+		m_names = rhs.m_names;
+		copyFrom(rhs);
+	}
+	return *this;
+}
+
+PropertyTable& PropertyTable::operator=(PropertyTable&& rhs) noexcept
+{
+	if (this != &rhs) {
+		destroy();
+		m_names = rhs.m_names;
+		m_slots = std::move(rhs.m_slots);
+		m_capacity = rhs.m_capacity;
+		m_size = rhs.m_size;
+		rhs.m_capacity = 0;
+		rhs.m_size = 0;
+	}
+	return *this;
+}
+
+PropertyTable& PropertyTable::operator=(const Atlas::Message::MapType& map)
+{
+	clear();
+	for (auto& entry : map) {
+		(*this)[entry.first] = entry.second;
+	}
+	return *this;
+}
+
+Atlas::Message::Element& PropertyTable::operator[](const std::string& name)
+{
+	return (*this)[m_names->intern(name)];
+}
+
+Atlas::Message::Element& PropertyTable::operator[](IdInterner::Handle handle)
+{
+	auto index = indexOf(handle);
+	if (index != m_capacity) {
+		return m_slots[index].entry().second;
+	}
+	//Keep the load below three quarters, so that probe sequences stay short.
+	if ((m_size + 1) * 4 > m_capacity * 3) {
+		rehash(m_capacity == 0 ? minimumCapacity : m_capacity * 2);
+	}
+	return place(handle, Atlas::Message::Element()).second;
+}
+
+PropertyTable::iterator PropertyTable::find(const std::string& name)
+{
+	auto index = indexOf(m_names->find(name));
+	return iterator(m_slots.get() + index, m_slots.get() + m_capacity);
+}
+
+PropertyTable::const_iterator PropertyTable::find(const std::string& name) const
+{
+	return find(m_names->find(name));
+}
+
+PropertyTable::const_iterator PropertyTable::find(IdInterner::Handle name) const
+{
+	auto index = indexOf(name);
+	return const_iterator(m_slots.get() + index, m_slots.get() + m_capacity);
+}
+
+std::size_t PropertyTable::erase(const std::string& name)
+{
+	auto index = indexOf(m_names->find(name));
+	if (index == m_capacity) {
+		return 0;
+	}
+	eraseAt(index);
+	return 1;
+}
+
+void PropertyTable::erase(const_iterator position)
+{
+	eraseAt(static_cast<std::uint32_t>(position.m_slot - m_slots.get()));
+}
+
+void PropertyTable::clear()
+{
+	for (std::uint32_t i = 0; i < m_capacity; ++i) {
+		if (m_slots[i].name != IdInterner::INVALID_HANDLE) {
+			m_slots[i].entry().~Entry();
+			m_slots[i].name = IdInterner::INVALID_HANDLE;
+		}
+	}
+	m_size = 0;
+}
+
+PropertyTable::iterator PropertyTable::begin()
+{
+	return iterator(m_slots.get(), m_slots.get() + m_capacity);
+}
+
+PropertyTable::iterator PropertyTable::end()
+{
+	return iterator(m_slots.get() + m_capacity, m_slots.get() + m_capacity);
+}
+
+PropertyTable::const_iterator PropertyTable::begin() const
+{
+	return const_iterator(m_slots.get(), m_slots.get() + m_capacity);
+}
+
+PropertyTable::const_iterator PropertyTable::end() const
+{
+	return const_iterator(m_slots.get() + m_capacity, m_slots.get() + m_capacity);
+}
+
+std::size_t PropertyTable::getAllocatedSize() const
+{
+	return m_capacity * sizeof(Slot);
+}
+
+std::uint32_t PropertyTable::idealIndex(IdInterner::Handle name) const
+{
+	return (name * hashMultiplier) & (m_capacity - 1);
+}
+
+std::uint32_t PropertyTable::indexOf(IdInterner::Handle name) const
+{
+	if (m_size == 0 || name == IdInterner::INVALID_HANDLE) {
+		return m_capacity;
+	}
+	auto mask = m_capacity - 1;
+	for (auto index = idealIndex(name); ; index = (index + 1) & mask) {
+		auto slotName = m_slots[index].name;
+		if (slotName == name) {
+			return index;
+		}
+		if (slotName == IdInterner::INVALID_HANDLE) {
+			return m_capacity;
+		}
+	}
+}
+
+PropertyTable::Entry& PropertyTable::place(IdInterner::Handle name, Atlas::Message::Element value)
+{
+	auto mask = m_capacity - 1;
+	auto index = idealIndex(name);
+	while (m_slots[index].name != IdInterner::INVALID_HANDLE) {
+		index = (index + 1) & mask;
+	}
+	auto& slot = m_slots[index];
+	new(&slot.storage) Entry{m_names->getId(name), std::move(value)};
+	slot.name = name;
+	m_size++;
+	return slot.entry();
+}
+
+void PropertyTable::rehash(std::uint32_t capacity)
+{
+	auto oldSlots = std::move(m_slots);
+	auto oldCapacity = m_capacity;
+	m_slots.reset(new Slot[capacity]);
+	m_capacity = capacity;
+	m_size = 0;
+	for (std::uint32_t i = 0; i < capacity; ++i) {
+		m_slots[i].name = IdInterner::INVALID_HANDLE;
+	}
+	for (std::uint32_t i = 0; i < oldCapacity; ++i) {
+		auto& slot = oldSlots[i];
+		if (slot.name != IdInterner::INVALID_HANDLE) {
+			place(slot.name, std::move(slot.entry().second));
+			slot.entry().~Entry();
+		}
+	}
+}
+
+void PropertyTable::destroy()
+{
+	clear();
+	m_slots.reset();
+	m_capacity = 0;
+}
+
+void PropertyTable::copyFrom(const PropertyTable& rhs)
+{
+	if (rhs.m_size == 0) {
+		return;
+	}
+	//Both tables use the same names, so the entries can be copied into the same slots.
+	m_slots.reset(new Slot[rhs.m_capacity]);
+	m_capacity = rhs.m_capacity;
+	for (std::uint32_t i = 0; i < m_capacity; ++i) {
+		auto& from = rhs.m_slots[i];
+		m_slots[i].name = from.name;
+		if (from.name != IdInterner::INVALID_HANDLE) {
+			new(&m_slots[i].storage) Entry{from.entry().first, from.entry().second};
+		}
+	}
+	m_size = rhs.m_size;
+}
+
+void PropertyTable::eraseAt(std::uint32_t index)
+{
+	auto mask = m_capacity - 1;
+	m_slots[index].entry().~Entry();
+	m_slots[index].name = IdInterner::INVALID_HANDLE;
+	m_size--;
+	//Move entries later in the probe sequence back into the gap, so that no lookup stops short of them.
+	auto gap = index;
+	for (auto next = (gap + 1) & mask; m_slots[next].name != IdInterner::INVALID_HANDLE; next = (next + 1) & mask) {
+		auto ideal = idealIndex(m_slots[next].name);
+		//The entry can only move back if its ideal slot isn't cyclically between the gap and where it is now.
+		bool between = gap <= next ? (gap < ideal && ideal <= next) : (gap < ideal || ideal <= next);
+		if (!between) {
+			auto& from = m_slots[next];
+			new(&m_slots[gap].storage) Entry{from.entry().first, std::move(from.entry().second)};
+			m_slots[gap].name = from.name;
+			from.entry().~Entry();
+			from.name = IdInterner::INVALID_HANDLE;
+			gap = next;
+		}
+	}
+}
+
+}
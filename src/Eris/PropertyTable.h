@@ -0,0 +1,257 @@
+#ifndef ERIS_PROPERTYTABLE_H
+#define ERIS_PROPERTYTABLE_H
+
+#include "IdInterner.h"
+
+#include <Atlas/Message/Element.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace Eris
+{
+
+/**
+ * @brief A compact map of property names to values, keyed by interned names.
+ *
+ * The names are interned in an IdInterner, which the TypeService shares between all entities and types. Each
+ * table only holds the handle and a reference to the interned name next to each value, in one flat array
+ * searched with linear probing. A std::map instead allocates a node for each property, with a copy of the name.
+ *
+ * The interface follows that of std::map as far as properties use it: entries have "first" and "second"
+ * members, and can be iterated over and looked up with find(). Entries aren't kept in name order though, and
+ * any insertion or erasure invalidates iterators and references to entries.
+ */
+class PropertyTable
+{
+public:
+	struct Entry
+	{
+		const std::string& first;
+		Atlas::Message::Element second;
+	};
+
+	template<typename EntryT>
+	class Iterator;
+
+	typedef Iterator<Entry> iterator;
+	typedef Iterator<const Entry> const_iterator;
+
+	/**
+	 * @param names Interns the property names. Must outlive the table.
+	 */
+	explicit PropertyTable(IdInterner& names);
+
+	PropertyTable(const PropertyTable& rhs);
+
+	PropertyTable(PropertyTable&& rhs) noexcept;
+
+	~PropertyTable();
+
+	PropertyTable& operator=(const PropertyTable& rhs);
+
+	PropertyTable& operator=(PropertyTable&& rhs) noexcept;
+
+	/**
+	 * @brief Replaces the entries with those of the map.
+	 */
+	PropertyTable& operator=(const Atlas::Message::MapType& map);
+
+	/**
+	 * @brief Gets the value of the property, adding an empty one if there is none.
+	 */
+	Atlas::Message::Element& operator[](const std::string& name);
+
+	/**
+	 * @brief Gets the value of the property, adding an empty one if there is none.
+	 * @param name The handle of a name interned in getNames().
+	 */
+	Atlas::Message::Element& operator[](IdInterner::Handle name);
+
+	iterator find(const std::string& name);
+
+	const_iterator find(const std::string& name) const;
+
+	/**
+	 * @brief Finds a property through its handle in the IdInterner, without hashing the name.
+	 */
+	const_iterator find(IdInterner::Handle name) const;
+
+	/**
+	 * @brief Removes the property.
+	 * @return The number of properties removed, which is zero or one.
+	 */
+	std::size_t erase(const std::string& name);
+
+	void erase(const_iterator position);
+
+	void clear();
+
+	std::size_t size() const;
+
+	bool empty() const;
+
+	iterator begin();
+
+	iterator end();
+
+	const_iterator begin() const;
+
+	const_iterator end() const;
+
+	IdInterner& getNames() const;
+
+	/**
+	 * @brief Gets the number of bytes allocated for entries, not counting the values themselves.
+	 */
+	std::size_t getAllocatedSize() const;
+
+private:
+	struct Slot
+	{
+		/**
+		 * The handle of the name, or IdInterner::INVALID_HANDLE if the slot is empty.
+		 */
+		IdInterner::Handle name;
+		typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type storage;
+
+		Entry& entry()
+		{
+			return *std::launder(reinterpret_cast<Entry*>(&storage));
+		}
+
+		const Entry& entry() const
+		{
+			return *std::launder(reinterpret_cast<const Entry*>(&storage));
+		}
+	};
+
+	IdInterner* m_names;
+	std::unique_ptr<Slot[]> m_slots;
+	std::uint32_t m_capacity; ///< always zero or a power of two
+	std::uint32_t m_size;
+
+	std::uint32_t idealIndex(IdInterner::Handle name) const;
+
+	/**
+	 * Returns the index of the slot holding the name, or m_capacity if there is none.
+	 */
+	std::uint32_t indexOf(IdInterner::Handle name) const;
+
+	/**
+	 * Places an entry in a free slot, without checking for space or duplicates.
+	 */
+	Entry& place(IdInterner::Handle name, Atlas::Message::Element value);
+
+	void rehash(std::uint32_t capacity);
+
+	void destroy();
+
+	void copyFrom(const PropertyTable& rhs);
+
+	void eraseAt(std::uint32_t index);
+};
+
+template<typename EntryT>
+class PropertyTable::Iterator
+{
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef EntryT value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef EntryT* pointer;
+	typedef EntryT& reference;
+
+	typedef typename std::conditional<std::is_const<EntryT>::value, const Slot, Slot>::type SlotT;
+
+	Iterator() : m_slot(nullptr), m_end(nullptr)
+	{
+	}
+
+	Iterator(SlotT* slot, SlotT* end) : m_slot(slot), m_end(end)
+	{
+		skipEmpty();
+	}
+
+	/**
+	 * Allows iterators to be converted to const_iterators.
+	 */
+	template<typename OtherT, typename = typename std::enable_if<std::is_const<EntryT>::value && !std::is_const<OtherT>::value>::type>
+	Iterator(const Iterator<OtherT>& rhs) : m_slot(rhs.m_slot), m_end(rhs.m_end)
+	{
+	}
+
+	reference operator*() const
+	{
+		return m_slot->entry();
+	}
+
+	pointer operator->() const
+	{
+		return &m_slot->entry();
+	}
+
+	Iterator& operator++()
+	{
+		++m_slot;
+		skipEmpty();
+		return *this;
+	}
+
+	Iterator operator++(int)
+	{
+		Iterator result(*this);
+		++*this;
+		return result;
+	}
+
+	bool operator==(const Iterator& rhs) const
+	{
+		return m_slot == rhs.m_slot;
+	}
+
+	bool operator!=(const Iterator& rhs) const
+	{
+		return m_slot != rhs.m_slot;
+	}
+
+private:
+	friend class PropertyTable;
+
+	template<typename>
+	friend class Iterator;
+
+	SlotT* m_slot;
+	SlotT* m_end;
+
+	void skipEmpty()
+	{
+		while (m_slot != m_end && m_slot->name == IdInterner::INVALID_HANDLE) {
+			++m_slot;
+		}
+	}
+};
+
+inline std::size_t PropertyTable::size() const
+{
+	return m_size;
+}
+
+inline bool PropertyTable::empty() const
+{
+	return m_size == 0;
+}
+
+inline IdInterner& PropertyTable::getNames() const
+{
+	return *m_names;
+}
+
+}
+
+#endif //ERIS_PROPERTYTABLE_H
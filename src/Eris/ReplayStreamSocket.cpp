@@ -0,0 +1,133 @@
+#include "ReplayStreamSocket.h"
+#include "Exceptions.h"
+#include "Log.h"
+
+namespace Eris
+{
+
+ReplayStreamSocket::ReplayStreamSocket(boost::asio::io_service& io_service,
+									   const std::string& client_name,
+									   Atlas::Bridge& bridge,
+									   StreamSocket::Callbacks callbacks,
+									   std::shared_ptr<CaptureReader> capture,
+									   Pacing pacing) :
+		StreamSocket(io_service, client_name, bridge, std::move(callbacks)),
+		mIoService(io_service),
+		mCapture(std::move(capture)),
+		mPacing(pacing),
+		mFeedTimer(io_service)
+{
+}
+
+ReplayStreamSocket::~ReplayStreamSocket() = default;
+
+void ReplayStreamSocket::connect()
+{
+	auto self(this->shared_from_this());
+	mIoService.post([this, self]() {
+		if (_callbacks.stateChanged) {
+			m_is_connected = true;
+			this->startNegotiation();
+		}
+	});
+}
+
+void ReplayStreamSocket::write()
+{
+	//Make sure that any data held by the compressor is written to the buffer.
+	if (mCompressor) {
+		mOutStream.flush();
+	}
+	//There's no one to send to, so the data is just dropped.
+	auto size = mWriteBuffer.size();
+	if (size != 0) {
+		mStatistics.writes++;
+		mStatistics.bytesWritten += size;
+		mWriteBuffer.consume(size);
+	}
+	this->updateCongestion();
+}
+
+void ReplayStreamSocket::negotiate_read()
+{
+	feedNext([this]() {
+		auto negotiateResult = this->negotiate();
+		if (negotiateResult == Atlas::Negotiate::FAILED) {
+			_callbacks.stateChanged(NEGOTIATE_FAILED);
+			return;
+		}
+
+		this->write();
+		if (_sc == nullptr) {
+			//The record which completed the negotiation might also contain the start of the session.
+			if (mReadBuffer.size() != 0 && _callbacks.stateChanged) {
+				this->decodeReceived();
+				_callbacks.dispatch();
+			}
+			this->do_read();
+		} else {
+			this->negotiate_read();
+		}
+	});
+}
+
+void ReplayStreamSocket::do_read()
+{
+	feedNext([this]() {
+		mStatistics.readBatches++;
+		try {
+			this->decodeReceived();
+		} catch (const NetworkFailure& e) {
+			//Thrown if the data can't be decompressed.
+			error() << "Error when decoding data from capture: " << e.what();
+			_callbacks.stateChanged(CONNECTION_FAILED);
+			return;
+		}
+		_callbacks.dispatch();
+		this->do_read();
+	});
+}
+
+void ReplayStreamSocket::feedNext(std::function<void()> handler)
+{
+	auto self(this->shared_from_this());
+	CaptureReader::Record record{};
+	if (!mCapture->next(record)) {
+		debug() << "Reached the end of the capture after " << mStatistics.bytesRead << " bytes.";
+		mIoService.post([this, self]() {
+			if (_callbacks.stateChanged) {
+				_callbacks.stateChanged(CONNECTION_FAILED);
+			}
+		});
+		return;
+	}
+
+	auto feed = [this, self, record, handler]() {
+		if (!_callbacks.stateChanged) {
+			return;
+		}
+		boost::asio::buffer_copy(mReadBuffer.prepare(record.size), boost::asio::buffer(record.data, record.size));
+		this->commitReceived(record.size);
+		mStatistics.readSyscalls++;
+		mStatistics.bytesRead += record.size;
+		handler();
+	};
+
+	if (mPacing == Pacing::ORIGINAL) {
+		auto recordTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(record.time);
+		//The first record is fed right away, and the rest relative to it.
+		if (mReplayStart == std::chrono::steady_clock::time_point()) {
+			mReplayStart = std::chrono::steady_clock::now() - recordTime;
+		}
+		mFeedTimer.expires_at(mReplayStart + recordTime);
+		mFeedTimer.async_wait([feed](const boost::system::error_code& ec) {
+			if (!ec) {
+				feed();
+			}
+		});
+	} else {
+		mIoService.post(feed);
+	}
+}
+
+}
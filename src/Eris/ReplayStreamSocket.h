@@ -0,0 +1,67 @@
+#ifndef ERIS_REPLAYSTREAMSOCKET_H
+#define ERIS_REPLAYSTREAMSOCKET_H
+
+#include "StreamSocket.h"
+#include "Capture.h"
+
+namespace Eris
+{
+
+/**
+ * @brief A socket which, instead of connecting anywhere, feeds the data from a capture file to the client.
+ *
+ * The captured data goes through the same negotiation, decompression and decoding as it did when it was
+ * captured. Anything sent by the client is discarded. Once all the data has been fed the connection is
+ * reported as failed, just as when a server closes the connection.
+ *
+ * Note that responses are matched to requests by their serial numbers, so for these to be handled the
+ * client has to send the same requests, in the same order, as the one which made the capture.
+ */
+class ReplayStreamSocket : public StreamSocket
+{
+public:
+
+	enum class Pacing
+	{
+		ORIGINAL, ///< data is fed with the same timing as when it was captured
+		FAST ///< data is fed as fast as possible, letting other handlers run in between
+	};
+
+	ReplayStreamSocket(boost::asio::io_service& io_service,
+					   const std::string& client_name,
+					   Atlas::Bridge& bridge,
+					   StreamSocket::Callbacks callbacks,
+					   std::shared_ptr<CaptureReader> capture,
+					   Pacing pacing);
+
+	~ReplayStreamSocket() override;
+
+	/**
+	 * @brief Starts feeding the captured data, beginning with the negotiation.
+	 */
+	void connect();
+
+	void write() override;
+
+protected:
+	boost::asio::io_service& mIoService;
+	std::shared_ptr<CaptureReader> mCapture;
+	Pacing mPacing;
+	boost::asio::steady_timer mFeedTimer;
+	std::chrono::steady_clock::time_point mReplayStart;
+
+	void negotiate_read() override;
+
+	void do_read() override;
+
+	/**
+	 * @brief Feeds the next record into the read buffer when it's due, and then calls the handler.
+	 *
+	 * If there are no more records the connection is reported as failed instead.
+	 */
+	void feedNext(std::function<void()> handler);
+};
+
+}
+
+#endif //ERIS_REPLAYSTREAMSOCKET_H
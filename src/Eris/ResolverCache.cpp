@@ -0,0 +1,142 @@
+#include "ResolverCache.h"
+
+namespace Eris
+{
+
+boost::asio::io_service::id ResolverCache::id;
+
+ResolverCache::ResolverCache(boost::asio::io_service& io_service) :
+		boost::asio::io_service::service(io_service),
+		mClock([]() { return std::chrono::steady_clock::now(); }),
+		mPositiveTimeToLive(std::chrono::minutes(5)),
+		mNegativeTimeToLive(std::chrono::seconds(30)),
+		mResolver(new boost::asio::ip::tcp::resolver(io_service))
+{
+	mBackend = [this](const std::string& host, const std::string& serviceName, ResultHandler handler) {
+		boost::asio::ip::tcp::resolver::query query(host, serviceName);
+		mResolver->async_resolve(query, [handler](const boost::system::error_code& ec, boost::asio::ip::tcp::resolver::iterator iterator) {
+			Endpoints endpoints;
+			if (!ec) {
+				for (; iterator != boost::asio::ip::tcp::resolver::iterator(); ++iterator) {
+					endpoints.push_back(*iterator);
+				}
+			}
+			handler(ec, endpoints);
+		});
+	};
+}
+
+ResolverCache::~ResolverCache() = default;
+
+void ResolverCache::shutdown()
+{
+	//The waiting handlers might hold references to sockets, so make sure these are released.
+	mEntries.clear();
+	mResolver.reset();
+}
+
+void ResolverCache::resolve(const std::string& host, const std::string& serviceName, ResultHandler handler)
+{
+	mStatistics.requests++;
+	Key entryKey(host, serviceName);
+	auto I = mEntries.find(entryKey);
+	if (I != mEntries.end()) {
+		auto& entry = I->second;
+		if (entry.pending) {
+			mStatistics.shared++;
+			entry.waiting.push_back(std::move(handler));
+			return;
+		}
+		if (entry.expiry > mClock()) {
+			mStatistics.hits++;
+			auto error = entry.error;
+			auto endpoints = entry.endpoints;
+			get_io_context().post([handler, error, endpoints]() {
+				handler(error, endpoints);
+			});
+			return;
+		}
+		mEntries.erase(I);
+	}
+
+	removeExpired();
+
+	mEntries[entryKey].waiting.push_back(std::move(handler));
+	mStatistics.lookups++;
+	mBackend(host, serviceName, [this, entryKey](const boost::system::error_code& ec, const Endpoints& endpoints) {
+		lookupCompleted(entryKey, ec, endpoints);
+	});
+}
+
+void ResolverCache::lookupCompleted(const Key& entryKey, const boost::system::error_code& ec, const Endpoints& endpoints)
+{
+	auto I = mEntries.find(entryKey);
+	if (I == mEntries.end() || !I->second.pending) {
+		return;
+	}
+	auto& entry = I->second;
+	auto waiting = std::move(entry.waiting);
+	entry.waiting.clear();
+
+	auto error = ec;
+	if (!error && endpoints.empty()) {
+		error = boost::asio::error::host_not_found;
+	}
+
+	if (error == boost::asio::error::operation_aborted) {
+		//Nothing was learned about the name, so it shouldn't be cached.
+		mEntries.erase(I);
+	} else {
+		entry.pending = false;
+		entry.error = error;
+		entry.endpoints = endpoints;
+		entry.expiry = mClock() + (error ? mNegativeTimeToLive : mPositiveTimeToLive);
+	}
+
+	for (auto& handler : waiting) {
+		get_io_context().post([handler, error, endpoints]() {
+			handler(error, endpoints);
+		});
+	}
+}
+
+void ResolverCache::removeExpired()
+{
+	auto now = mClock();
+	for (auto I = mEntries.begin(); I != mEntries.end();) {
+		if (!I->second.pending && I->second.expiry <= now) {
+			I = mEntries.erase(I);
+		} else {
+			++I;
+		}
+	}
+}
+
+void ResolverCache::setBackend(Backend backend)
+{
+	mBackend = std::move(backend);
+}
+
+void ResolverCache::setClock(Clock clock)
+{
+	mClock = std::move(clock);
+}
+
+void ResolverCache::setTimeToLive(std::chrono::steady_clock::duration positive, std::chrono::steady_clock::duration negative)
+{
+	mPositiveTimeToLive = positive;
+	mNegativeTimeToLive = negative;
+}
+
+void ResolverCache::clear()
+{
+	for (auto I = mEntries.begin(); I != mEntries.end();) {
+		if (!I->second.pending) {
+			I = mEntries.erase(I);
+		} else {
+			++I;
+		}
+	}
+}
+
+}
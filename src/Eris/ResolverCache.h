@@ -0,0 +1,158 @@
+#ifndef ERIS_RESOLVERCACHE_H
+#define ERIS_RESOLVERCACHE_H
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace Eris
+{
+
+/**
+ * @brief Caches the results of host name lookups, shared by all connections using the same io_service.
+ *
+ * Both successful and failed lookups are cached, for a limited time. If a name is requested while a lookup for it
+ * is already in progress, the request waits for that lookup instead of starting a new one. This means that
+ * refreshing a list of servers, or reconnecting repeatedly, doesn't cause a flood of lookups.
+ *
+ * The system resolver doesn't tell us the time to live of the DNS records, so fixed times are used instead.
+ *
+ * Obtain the instance for an io_service through boost::asio::use_service<ResolverCache>(io_service).
+ */
+class ResolverCache : public boost::asio::io_service::service
+{
+public:
+
+	/**
+	 * The results of a lookup. These are TCP endpoints, but can be converted to any IP protocol.
+	 */
+	typedef std::vector<boost::asio::ip::tcp::endpoint> Endpoints;
+
+	typedef std::function<void(const boost::system::error_code&, const Endpoints&)> ResultHandler;
+
+	/**
+	 * @brief Performs the actual lookups. Must call the handler exactly once.
+	 */
+	typedef std::function<void(const std::string& host, const std::string& serviceName, ResultHandler handler)> Backend;
+
+	typedef std::function<std::chrono::steady_clock::time_point()> Clock;
+
+	/**
+	 * @brief Counters for the lookups made through the cache.
+	 */
+	struct Statistics
+	{
+		std::uint64_t requests = 0; ///< number of calls to resolve()
+		std::uint64_t hits = 0; ///< requests answered from the cache, including failed lookups
+		std::uint64_t shared = 0; ///< requests which waited for a lookup already in progress
+		std::uint64_t lookups = 0; ///< lookups made through the backend
+	};
+
+	static boost::asio::io_service::id id;
+
+	explicit ResolverCache(boost::asio::io_service& io_service);
+
+	~ResolverCache() override;
+
+	/**
+	 * @brief Looks up a host name.
+	 *
+	 * The handler is always called through the io_service, even if the result is cached.
+	 * @param host The host name, or an address.
+	 * @param serviceName The service name, or a port number.
+	 * @param handler Called with the results.
+	 */
+	void resolve(const std::string& host, const std::string& serviceName, ResultHandler handler);
+
+	/**
+	 * @brief Looks up a host name, returning endpoints for a specific protocol.
+	 */
+	template<typename ProtocolT>
+	void resolve(const std::string& host, const std::string& serviceName,
+				 std::function<void(const boost::system::error_code&, const std::vector<typename ProtocolT::endpoint>&)> handler);
+
+	/**
+	 * @brief Replaces the backend which performs the lookups. By default the system resolver is used.
+	 */
+	void setBackend(Backend backend);
+
+	/**
+	 * @brief Replaces the clock used for expiring entries.
+	 */
+	void setClock(Clock clock);
+
+	/**
+	 * @brief Sets how long results are kept.
+	 * @param positive How long successful lookups are kept.
+	 * @param negative How long failed lookups are kept.
+	 */
+	void setTimeToLive(std::chrono::steady_clock::duration positive, std::chrono::steady_clock::duration negative);
+
+	/**
+	 * @brief Removes all cached results. Lookups in progress aren't affected.
+	 */
+	void clear();
+
+	const Statistics& getStatistics() const;
+
+private:
+
+	typedef std::pair<std::string, std::string> Key;
+
+	struct Entry
+	{
+		bool pending = true;
+		std::chrono::steady_clock::time_point expiry;
+		boost::system::error_code error;
+		Endpoints endpoints;
+
+		/**
+		 * Handlers waiting for the lookup to complete.
+		 */
+		std::vector<ResultHandler> waiting;
+	};
+
+	std::map<Key, Entry> mEntries;
+	Backend mBackend;
+	Clock mClock;
+	std::chrono::steady_clock::duration mPositiveTimeToLive;
+	std::chrono::steady_clock::duration mNegativeTimeToLive;
+	Statistics mStatistics;
+	std::unique_ptr<boost::asio::ip::tcp::resolver> mResolver;
+
+	void shutdown() override;
+
+	void lookupCompleted(const Key& entryKey, const boost::system::error_code& ec, const Endpoints& endpoints);
+
+	void removeExpired();
+};
+
+template<typename ProtocolT>
+void ResolverCache::resolve(const std::string& host, const std::string& serviceName,
+							std::function<void(const boost::system::error_code&, const std::vector<typename ProtocolT::endpoint>&)> handler)
+{
+	resolve(host, serviceName, [handler](const boost::system::error_code& ec, const Endpoints& endpoints) {
+		std::vector<typename ProtocolT::endpoint> converted;
+		for (auto& endpoint : endpoints) {
+			converted.emplace_back(endpoint.address(), endpoint.port());
+		}
+		handler(ec, converted);
+	});
+}
+
+inline const ResolverCache::Statistics& ResolverCache::getStatistics() const
+{
+	return mStatistics;
+}
+
+}
+
+#endif //ERIS_RESOLVERCACHE_H
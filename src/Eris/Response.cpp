@@ -1,6 +1,9 @@
 #include "Response.h"
 #include <Atlas/Objects/Operation.h>
 #include <memory>
+#include <algorithm>
+#include <cassert>
+#include <limits>
 #include "LogStream.h"
 
 using namespace Atlas::Objects::Operation;
@@ -35,22 +38,37 @@ std::string getErrorMessage(const RootOperation & err)
 
 ResponseBase::~ResponseBase() = default;
 
+ResponseTracker::ResponseTracker(std::chrono::steady_clock::duration tick, std::size_t wheelSize) :
+	m_wheel(std::max<std::size_t>(wheelSize, 1)),
+	m_tick(std::max(tick, std::chrono::steady_clock::duration(1))),
+	m_start(std::chrono::steady_clock::now()),
+	m_currentTick(0),
+	m_defaultTimeout(std::chrono::minutes(1))
+{
+}
+
 ResponseTracker::~ResponseTracker() = default;
 
 void ResponseTracker::await(std::int64_t serial, Callback callback)
 {
-    m_pending.emplace(serial, std::move(callback));
+    await(serial, std::move(callback), m_defaultTimeout);
 }
 
+void ResponseTracker::await(std::int64_t serial, Callback callback, std::chrono::steady_clock::duration timeout, TimeoutCallback onTimeout)
+{
+    if (m_pending.count(serial) != 0) {
+        return;
+    }
+    auto index = allocateSlot(serial, timeout);
+    m_slots[index].callback = std::move(callback);
+    m_slots[index].onTimeout = std::move(onTimeout);
+}
 
 void ResponseTracker::await(std::int64_t serialno, std::unique_ptr<ResponseBase> resp)
 {
     assert(m_pending.count(serialno) == 0);
-    std::shared_ptr<ResponseBase> holder = std::move(resp);
-    await(serialno, [holder](const Atlas::Objects::Operation::RootOperation& op)->Router::RouterResult{
-        auto result = holder->responseReceived(op);
-        return result ? Router::HANDLED : Router::IGNORED;
-    });
+    auto index = allocateSlot(serialno, m_defaultTimeout);
+    m_slots[index].response = std::move(resp);
 }
 
 Router::RouterResult ResponseTracker::handleOp(const RootOperation& op)
@@ -65,12 +83,118 @@ Router::RouterResult ResponseTracker::handleOp(const RootOperation& op)
     }
 
 // order here is important, so the responseReceived can re-await the op
-    auto resp = it->second;
+    auto index = it->second;
+    auto callback = std::move(m_slots[index].callback);
+    auto response = std::move(m_slots[index].response);
     m_pending.erase(it);
+    releaseSlot(index);
+    m_statistics.answered++;
+
+    if (response) {
+        auto result = response->responseReceived(op);
+        return result ? Router::HANDLED : Router::IGNORED;
+    }
+    return callback(op);
+}
+
+void ResponseTracker::setDefaultTimeout(std::chrono::steady_clock::duration timeout)
+{
+	m_defaultTimeout = timeout;
+}
 
-    auto result = resp(op);
+std::size_t ResponseTracker::expire(std::chrono::steady_clock::time_point now)
+{
+	auto target = getTickAt(now);
+	if (target <= m_currentTick) {
+		return 0;
+	}
+
+	//Only the buckets between the last tick and now need to be looked at; if a whole turn of the wheel has
+	//passed, all of them once.
+	std::vector<std::uint32_t> expired;
+	auto span = std::min<std::uint64_t>(target - m_currentTick, m_wheel.size());
+	for (std::uint64_t i = 1; i <= span; ++i) {
+		auto& bucket = m_wheel[(m_currentTick + i) % m_wheel.size()];
+		auto out = bucket.begin();
+		for (auto& entry : bucket) {
+			auto& slot = m_slots[entry.slot];
+			if (slot.generation != entry.generation) {
+				//Answered since.
+				continue;
+			}
+			if (slot.deadlineTick <= target) {
+				expired.push_back(entry.slot);
+				continue;
+			}
+			*out++ = entry;
+		}
+		bucket.erase(out, bucket.end());
+	}
+	m_currentTick = target;
+
+	for (auto index : expired) {
+		auto serial = m_slots[index].serial;
+		auto onTimeout = std::move(m_slots[index].onTimeout);
+		m_pending.erase(serial);
+		releaseSlot(index);
+		m_statistics.expired++;
+		if (onTimeout) {
+			onTimeout(serial);
+		} else {
+			warning() << "no response received for op with serial " << serial;
+		}
+	}
+	return expired.size();
+}
 
-    return result;
+ResponseTracker::Statistics ResponseTracker::getStatistics() const
+{
+	auto statistics = m_statistics;
+	statistics.outstanding = m_pending.size();
+	statistics.slots = m_slots.size();
+	return statistics;
+}
+
+std::uint32_t ResponseTracker::allocateSlot(std::int64_t serial, std::chrono::steady_clock::duration timeout)
+{
+	std::uint32_t index;
+	if (m_freeSlots.empty()) {
+		index = static_cast<std::uint32_t>(m_slots.size());
+		m_slots.push_back(Slot{0, Callback(), nullptr, TimeoutCallback(), 0, 0});
+	} else {
+		index = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	auto& slot = m_slots[index];
+	slot.serial = serial;
+	if (timeout == std::chrono::steady_clock::duration::zero()) {
+		slot.deadlineTick = std::numeric_limits<std::uint64_t>::max();
+	} else {
+		//Round up, so that the request gets at least the full timeout.
+		slot.deadlineTick = std::max(getTickAt(std::chrono::steady_clock::now() + timeout + m_tick - std::chrono::steady_clock::duration(1)), m_currentTick + 1);
+		m_wheel[slot.deadlineTick % m_wheel.size()].push_back(WheelEntry{index, slot.generation});
+	}
+	m_pending.emplace(serial, index);
+	m_statistics.peakOutstanding = std::max(m_statistics.peakOutstanding, m_pending.size());
+	return index;
+}
+
+void ResponseTracker::releaseSlot(std::uint32_t index)
+{
+	auto& slot = m_slots[index];
+	slot.callback = nullptr;
+	slot.response.reset();
+	slot.onTimeout = nullptr;
+	slot.generation++;
+	m_freeSlots.push_back(index);
+}
+
+std::uint64_t ResponseTracker::getTickAt(std::chrono::steady_clock::time_point time) const
+{
+	if (time <= m_start) {
+		return 0;
+	}
+	return static_cast<std::uint64_t>((time - m_start) / m_tick);
 }
 
 Router::RouterResult NullResponse::responseReceived(const Atlas::Objects::Operation::RootOperation&)
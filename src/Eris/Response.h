@@ -8,6 +8,8 @@
 #include <functional>
 #include <memory>
 #include <cstdint>
+#include <chrono>
+#include <vector>
 #include <string>
 #include <sigc++/trackable.h>
 
@@ -69,17 +71,56 @@ private:
     T_method m_func;
 };
 
+/**
+ * @brief Keeps track of the responses awaited for ops sent to the server.
+ *
+ * Each awaited response has a deadline, after which it's given up on, so that requests the server never
+ * answers don't accumulate. The deadlines are kept in a hashed timer wheel, which is advanced by expire().
+ * The Connection calls that periodically while connected.
+ *
+ * The awaited responses are kept in a pool of slots, which are reused once answered or expired.
+ */
 class ResponseTracker
 {
 public:
 
 	typedef std::function<Router::RouterResult(const Atlas::Objects::Operation::RootOperation& op)> Callback;
 
+	/**
+	 * Called with the serial number of a request which wasn't answered in time.
+	 */
+	typedef std::function<void(std::int64_t serial)> TimeoutCallback;
+
+	/**
+	 * @brief Counters for the awaited responses.
+	 */
+	struct Statistics
+	{
+		std::size_t outstanding = 0; ///< number of responses currently awaited
+		std::size_t peakOutstanding = 0; ///< the highest number of responses awaited at once
+		std::size_t slots = 0; ///< number of slots allocated in the pool
+		std::uint64_t answered = 0; ///< number of responses which have arrived
+		std::uint64_t expired = 0; ///< number of requests which weren't answered in time
+	};
+
+	/**
+	 * @param tick The resolution of the deadlines.
+	 * @param wheelSize The number of buckets in the timer wheel.
+	 */
+	explicit ResponseTracker(std::chrono::steady_clock::duration tick = std::chrono::milliseconds(500), std::size_t wheelSize = 256);
+
     ~ResponseTracker();
 
     void await(std::int64_t serialno, std::unique_ptr<ResponseBase>);
 
     void await(std::int64_t serial, Callback callback);
+
+	/**
+	 * @brief Awaits a response, giving up on it after the timeout.
+	 * @param timeout The time to wait, or zero to wait forever.
+	 * @param onTimeout Called if the response doesn't arrive in time.
+	 */
+	void await(std::int64_t serial, Callback callback, std::chrono::steady_clock::duration timeout, TimeoutCallback onTimeout = TimeoutCallback());
     
     template <class T>
     void await(std::int64_t serial, T* ins, void (T::*method)(const Atlas::Objects::Operation::RootOperation& op) )
@@ -94,8 +135,81 @@ public:
     
     Router::RouterResult handleOp(const Atlas::Objects::Operation::RootOperation& op);
 
+    /**
+     * @brief Returns true if a response to the serial is awaited.
+     */
+    bool isAwaiting(std::int64_t serial) const
+    {
+        return m_pending.find(serial) != m_pending.end();
+    }
+
+	/**
+	 * @brief Sets the timeout used by the await() calls which don't specify one.
+	 *
+	 * Defaults to one minute. Zero means waiting forever.
+	 */
+	void setDefaultTimeout(std::chrono::steady_clock::duration timeout);
+
+	/**
+	 * @brief Gives up on all requests whose deadline has passed.
+	 * @return The number of requests given up on.
+	 */
+	std::size_t expire(std::chrono::steady_clock::time_point now);
+
+	std::chrono::steady_clock::duration getTick() const
+	{
+		return m_tick;
+	}
+
+	Statistics getStatistics() const;
+
 private:
-    std::unordered_map<std::int64_t, Callback> m_pending;
+	struct Slot
+	{
+		std::int64_t serial;
+		Callback callback;
+		std::unique_ptr<ResponseBase> response; ///< used instead of the callback, if set
+		TimeoutCallback onTimeout;
+		std::uint64_t deadlineTick;
+
+		/**
+		 * Incremented each time the slot is released, so that stale entries in the wheel can be told apart.
+		 */
+		std::uint32_t generation;
+	};
+
+	struct WheelEntry
+	{
+		std::uint32_t slot;
+		std::uint32_t generation;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<std::uint32_t> m_freeSlots;
+
+	/**
+	 * The slots of the awaited responses, keyed by serial number.
+	 */
+	std::unordered_map<std::int64_t, std::uint32_t> m_pending;
+
+	std::vector<std::vector<WheelEntry>> m_wheel;
+	std::chrono::steady_clock::duration m_tick;
+	std::chrono::steady_clock::time_point m_start;
+
+	/**
+	 * The last tick the wheel has been advanced to.
+	 */
+	std::uint64_t m_currentTick;
+
+	std::chrono::steady_clock::duration m_defaultTimeout;
+
+	Statistics m_statistics;
+
+	std::uint32_t allocateSlot(std::int64_t serial, std::chrono::steady_clock::duration timeout);
+
+	void releaseSlot(std::uint32_t index);
+
+	std::uint64_t getTickAt(std::chrono::steady_clock::time_point time) const;
 };
 
 } // of namespace
@@ -0,0 +1,134 @@
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace Eris
+{
+
+RingBuffer::RingBuffer(std::size_t minCapacity, std::size_t maxCapacity) :
+		mMinCapacity(minCapacity),
+		mMaxCapacity(std::max(minCapacity, maxCapacity)),
+		mStorage(new char[minCapacity]),
+		mCapacity(minCapacity),
+		mStart(0),
+		mSize(0),
+		mAverageBurst(0)
+{
+	assert(mMinCapacity > 0);
+	resetGetArea();
+}
+
+RingBuffer::~RingBuffer() = default;
+
+void RingBuffer::syncGetArea()
+{
+	auto consumed = static_cast<std::size_t>(gptr() - eback());
+	mStart += consumed;
+	mSize -= consumed;
+	//Starting over from the beginning when empty keeps the data contiguous for as long as possible.
+	if (mStart == mCapacity || mSize == 0) {
+		mStart = 0;
+	}
+	resetGetArea();
+}
+
+void RingBuffer::resetGetArea()
+{
+	auto contiguous = std::min(mSize, mCapacity - mStart);
+	auto start = mStorage.get() + mStart;
+	setg(start, start, start + contiguous);
+}
+
+void RingBuffer::reallocate(std::size_t newCapacity)
+{
+	assert(newCapacity >= mSize);
+	std::unique_ptr<char[]> storage(new char[newCapacity]);
+	auto contiguous = std::min(mSize, mCapacity - mStart);
+	std::memcpy(storage.get(), mStorage.get() + mStart, contiguous);
+	std::memcpy(storage.get() + contiguous, mStorage.get(), mSize - contiguous);
+	mStorage = std::move(storage);
+	mCapacity = newCapacity;
+	mStart = 0;
+	resetGetArea();
+}
+
+RingBuffer::MutableBuffers RingBuffer::prepare(std::size_t size)
+{
+	syncGetArea();
+	if (mCapacity - mSize < size) {
+		auto newCapacity = mCapacity;
+		while (newCapacity - mSize < size) {
+			newCapacity *= 2;
+		}
+		reallocate(newCapacity);
+	}
+	auto writeStart = (mStart + mSize) % mCapacity;
+	auto first = std::min(size, mCapacity - writeStart);
+	return {{boost::asio::buffer(mStorage.get() + writeStart, first), boost::asio::buffer(mStorage.get(), size - first)}};
+}
+
+void RingBuffer::commit(std::size_t size)
+{
+	syncGetArea();
+	mSize += std::min(size, mCapacity - mSize);
+	resetGetArea();
+}
+
+std::size_t RingBuffer::size() const
+{
+	return mSize - static_cast<std::size_t>(gptr() - eback());
+}
+
+std::size_t RingBuffer::targetCapacity() const
+{
+	//Leave room for twice the average burst, since bursts vary quite a lot in size.
+	std::size_t target = mMinCapacity;
+	while (target < mAverageBurst * 2 && target < mMaxCapacity) {
+		target *= 2;
+	}
+	return target;
+}
+
+void RingBuffer::recordBurst(std::size_t size)
+{
+	//An exponentially weighted moving average, which lets a few large bursts grow the ring quickly
+	//while it takes a while of smaller bursts to shrink it again.
+	if (size > mAverageBurst) {
+		mAverageBurst = (mAverageBurst + size) / 2;
+	} else {
+		mAverageBurst = (mAverageBurst * 7 + size) / 8;
+	}
+
+	syncGetArea();
+	auto target = targetCapacity();
+	if (mCapacity > target * 2 && mSize <= target / 2) {
+		reallocate(target);
+	}
+}
+
+std::size_t RingBuffer::getReadSize() const
+{
+	//Read into all of the free space, but ask for more if recent bursts indicate that it's needed.
+	//If the buffer is full this will always make it grow.
+	auto unread = size();
+	return std::max(mCapacity - unread, std::max(targetCapacity(), unread * 2) - unread);
+}
+
+RingBuffer::int_type RingBuffer::underflow()
+{
+	syncGetArea();
+	if (mSize == 0) {
+		return traits_type::eof();
+	}
+	return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize RingBuffer::showmanyc()
+{
+	syncGetArea();
+	return static_cast<std::streamsize>(mSize);
+}
+
+}
@@ -0,0 +1,136 @@
+#ifndef ERIS_RINGBUFFER_H
+#define ERIS_RINGBUFFER_H
+
+#include <boost/asio/buffer.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <streambuf>
+#include <array>
+#include <memory>
+#include <cstddef>
+
+namespace Eris
+{
+
+/**
+ * @brief An input stream buffer backed by a reusable ring of memory, which adapts its size to the amount of data received.
+ *
+ * Data is read into the free space through prepare() and commit(), in the same way as with boost::asio::streambuf,
+ * and is consumed through an std::istream attached to the buffer.
+ *
+ * The size of the ring follows the size of the bursts of data received. Call recordBurst() with the number
+ * of bytes received each time the socket has been drained; getReadSize() will then return a suitable amount
+ * to prepare for the next read. The ring grows as needed, and shrinks back once bursts become smaller again.
+ */
+class RingBuffer : public std::streambuf, private boost::noncopyable
+{
+public:
+
+	/**
+	 * @brief Up to two buffers covering free space in the ring.
+	 */
+	typedef std::array<boost::asio::mutable_buffer, 2> MutableBuffers;
+
+	/**
+	 * @brief Ctor.
+	 * @param minCapacity The smallest size the ring will use. Must be a power of two.
+	 * @param maxCapacity The largest size the ring will use when adapting to bursts. Must be a power of two.
+	 * Note that prepare() can grow the ring beyond this if explicitly asked to.
+	 */
+	explicit RingBuffer(std::size_t minCapacity = 2048, std::size_t maxCapacity = 1024 * 1024);
+
+	~RingBuffer() override;
+
+	/**
+	 * @brief Gets space for writing at least the specified number of bytes, growing the ring if needed.
+	 *
+	 * The free space might wrap around the end of the ring, so up to two buffers are returned. The second
+	 * buffer is empty if the space is contiguous.
+	 * @param size The number of bytes to prepare.
+	 * @return Buffers covering exactly "size" bytes.
+	 */
+	MutableBuffers prepare(std::size_t size);
+
+	/**
+	 * @brief Makes bytes written to space returned from prepare() available for reading.
+	 * @param size The number of bytes written.
+	 */
+	void commit(std::size_t size);
+
+	/**
+	 * @brief Gets the number of unread bytes.
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @brief Gets the current size of the ring.
+	 */
+	std::size_t capacity() const;
+
+	/**
+	 * @brief Registers the amount of data which was received in one go, adapting the ring size.
+	 *
+	 * If the ring is empty and much larger than recent bursts require it will be shrunk.
+	 * @param size The number of bytes received.
+	 */
+	void recordBurst(std::size_t size);
+
+	/**
+	 * @brief Gets the number of bytes which should be prepared for the next read, based on recent bursts.
+	 */
+	std::size_t getReadSize() const;
+
+protected:
+
+	int_type underflow() override;
+
+	std::streamsize showmanyc() override;
+
+private:
+	const std::size_t mMinCapacity;
+	const std::size_t mMaxCapacity;
+
+	std::unique_ptr<char[]> mStorage;
+	std::size_t mCapacity;
+
+	/**
+	 * Offset of the first unread byte. Bytes consumed through the get area are accounted for in syncGetArea().
+	 */
+	std::size_t mStart;
+
+	/**
+	 * Number of unread bytes.
+	 */
+	std::size_t mSize;
+
+	/**
+	 * A moving average of the burst sizes, used to determine the size of the ring.
+	 */
+	std::size_t mAverageBurst;
+
+	/**
+	 * @brief Accounts for any bytes read through the get area.
+	 */
+	void syncGetArea();
+
+	/**
+	 * @brief Sets the get area to cover the contiguous readable bytes from mStart.
+	 */
+	void resetGetArea();
+
+	/**
+	 * @brief Moves the unread data into new storage of the specified size.
+	 */
+	void reallocate(std::size_t newCapacity);
+
+	std::size_t targetCapacity() const;
+};
+
+inline std::size_t RingBuffer::capacity() const
+{
+	return mCapacity;
+}
+
+}
+
+#endif //ERIS_RINGBUFFER_H
@@ -36,6 +36,11 @@ Router::RouterResult Router::handleOperation(const RootOperation& )
     return IGNORED;
 }
 
+Router::RouterResult Router::routeOperation(const RootOperation& op, IdInterner::Handle, IdInterner::Handle)
+{
+    return handleOperation(op);
+}
+
 Router::RouterResult Router::handleEntity(const RootEntity& )
 {
     warning() << "doing default routing of entity";
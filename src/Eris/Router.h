@@ -1,6 +1,8 @@
 #ifndef ERIS_ROUTER_H
 #define ERIS_ROUTER_H
 
+#include "IdInterner.h"
+
 #include <Atlas/Objects/ObjectsFwd.h>
 
 namespace Eris
@@ -19,6 +21,15 @@ public:
     virtual RouterResult handleObject(const Atlas::Objects::Root& obj);
 
     virtual RouterResult handleOperation(const Atlas::Objects::Operation::RootOperation& op);
+
+    /**
+     * @brief Called by the Connection with the handles of the FROM and TO ids of the op, as interned when it was queued.
+     *
+     * Either handle is IdInterner::INVALID_HANDLE if the id isn't interned. Routers which look up
+     * entities by these ids can override this to use the handles; by default it calls handleOperation().
+     */
+    virtual RouterResult routeOperation(const Atlas::Objects::Operation::RootOperation& op,
+                                        IdInterner::Handle from, IdInterner::Handle to);
     virtual RouterResult handleEntity(const Atlas::Objects::Entity::RootEntity& ent);
 };
 
@@ -0,0 +1,135 @@
+#include "SegmentBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace Eris
+{
+
+SegmentBuffer::SegmentBuffer(std::size_t blockSize, std::size_t maxPooledBlocks) :
+		mBlockSize(blockSize),
+		mMaxPooledBlocks(maxPooledBlocks),
+		mBlockAllocations(0)
+{
+	assert(mBlockSize > 0);
+	setp(nullptr, nullptr);
+}
+
+SegmentBuffer::~SegmentBuffer() = default;
+
+void SegmentBuffer::commit()
+{
+	if (pbase() != nullptr) {
+		assert(!mBlocks.empty());
+		auto& last = mBlocks.back();
+		last.end += static_cast<std::size_t>(pptr() - pbase());
+		setp(last.data.get() + last.end, last.data.get() + mBlockSize);
+	}
+}
+
+void SegmentBuffer::resetPutArea()
+{
+	if (mBlocks.empty()) {
+		setp(nullptr, nullptr);
+	} else {
+		auto& last = mBlocks.back();
+		setp(last.data.get() + last.end, last.data.get() + mBlockSize);
+	}
+}
+
+void SegmentBuffer::appendBlock()
+{
+	std::unique_ptr<char[]> data;
+	if (!mPool.empty()) {
+		data = std::move(mPool.back());
+		mPool.pop_back();
+	} else {
+		data.reset(new char[mBlockSize]);
+		mBlockAllocations++;
+	}
+	mBlocks.push_back(Block{std::move(data), 0, 0});
+	resetPutArea();
+}
+
+std::size_t SegmentBuffer::size() const
+{
+	std::size_t total = 0;
+	for (auto& block : mBlocks) {
+		total += block.end - block.begin;
+	}
+	//Bytes in the put area haven't been moved into the last block yet.
+	if (pbase() != nullptr) {
+		total += static_cast<std::size_t>(pptr() - pbase());
+	}
+	return total;
+}
+
+SegmentBuffer::ConstBuffers SegmentBuffer::data()
+{
+	commit();
+	mGatherBuffers.clear();
+	for (auto& block : mBlocks) {
+		if (block.end != block.begin) {
+			mGatherBuffers.emplace_back(block.data.get() + block.begin, block.end - block.begin);
+		}
+	}
+	return {mGatherBuffers.data(), mGatherBuffers.data() + mGatherBuffers.size()};
+}
+
+void SegmentBuffer::consume(std::size_t length)
+{
+	commit();
+	while (length > 0 && !mBlocks.empty()) {
+		auto& front = mBlocks.front();
+		auto available = front.end - front.begin;
+		if (length < available) {
+			front.begin += length;
+			return;
+		}
+		length -= available;
+		front.begin = front.end;
+		//Don't recycle the last block if there's still room in it; new data will be appended there.
+		if (mBlocks.size() == 1 && front.end < mBlockSize) {
+			//The block is empty now, so we might as well start over from its start.
+			front.begin = front.end = 0;
+			resetPutArea();
+			return;
+		}
+		if (mPool.size() < mMaxPooledBlocks) {
+			mPool.push_back(std::move(front.data));
+		}
+		mBlocks.pop_front();
+	}
+	resetPutArea();
+}
+
+SegmentBuffer::int_type SegmentBuffer::overflow(int_type ch)
+{
+	commit();
+	appendBlock();
+	if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(ch);
+		pbump(1);
+		return ch;
+	}
+	return traits_type::not_eof(ch);
+}
+
+std::streamsize SegmentBuffer::xsputn(const char* s, std::streamsize count)
+{
+	std::streamsize written = 0;
+	while (written < count) {
+		if (pptr() == epptr()) {
+			commit();
+			appendBlock();
+		}
+		auto chunk = std::min(static_cast<std::streamsize>(epptr() - pptr()), count - written);
+		std::memcpy(pptr(), s + written, static_cast<std::size_t>(chunk));
+		pbump(static_cast<int>(chunk));
+		written += chunk;
+	}
+	return written;
+}
+
+}
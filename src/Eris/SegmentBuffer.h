@@ -0,0 +1,137 @@
+#ifndef ERIS_SEGMENTBUFFER_H
+#define ERIS_SEGMENTBUFFER_H
+
+#include <boost/asio/buffer.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <streambuf>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace Eris
+{
+
+/**
+ * @brief An output stream buffer which stores its data in a chain of fixed-size blocks.
+ *
+ * Data written through an std::ostream attached to this buffer is appended to the last block in the chain,
+ * and new blocks are added as the previous ones fill up. Since blocks never move or grow, a gathered
+ * write can be started over the whole chain (see data()) while more data keeps being appended behind it.
+ * Once bytes have been sent they are released through consume(), and blocks that become empty are
+ * kept in a small free list so that they can be reused without hitting the allocator.
+ */
+class SegmentBuffer : public std::streambuf, private boost::noncopyable
+{
+public:
+
+	/**
+	 * @brief A lightweight view of a sequence of buffers, which can be copied without any allocations.
+	 *
+	 * It fulfills the ConstBufferSequence requirements, so it can be passed directly to the Asio write functions.
+	 */
+	class ConstBuffers
+	{
+	public:
+		typedef boost::asio::const_buffer value_type;
+		typedef const boost::asio::const_buffer* const_iterator;
+
+		ConstBuffers(const_iterator begin, const_iterator end) : mBegin(begin), mEnd(end) {}
+
+		const_iterator begin() const { return mBegin; }
+
+		const_iterator end() const { return mEnd; }
+
+		std::size_t size() const { return static_cast<std::size_t>(mEnd - mBegin); }
+
+		bool empty() const { return mBegin == mEnd; }
+
+	private:
+		const_iterator mBegin;
+		const_iterator mEnd;
+	};
+
+	/**
+	 * @brief Ctor.
+	 * @param blockSize The size in bytes of each block.
+	 * @param maxPooledBlocks The max number of unused blocks kept around for reuse.
+	 */
+	explicit SegmentBuffer(std::size_t blockSize = 4096, std::size_t maxPooledBlocks = 16);
+
+	~SegmentBuffer() override;
+
+	/**
+	 * @brief Gets the number of bytes which have been written but not yet consumed.
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @brief Gets a sequence of buffers covering all unconsumed data, suitable for a gathered write.
+	 *
+	 * The returned sequence refers to storage owned by this instance, and stays valid until the next call to data().
+	 * Appending more data doesn't invalidate the memory the buffers point to.
+	 */
+	ConstBuffers data();
+
+	/**
+	 * @brief Removes bytes from the start of the buffer, recycling any blocks that become empty.
+	 * @param length Number of bytes to remove.
+	 */
+	void consume(std::size_t length);
+
+	/**
+	 * @brief Gets the number of blocks which had to be allocated from the heap since creation.
+	 */
+	std::size_t getBlockAllocations() const;
+
+protected:
+	int_type overflow(int_type ch) override;
+
+	std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+private:
+
+	struct Block
+	{
+		std::unique_ptr<char[]> data;
+		/**
+		 * Offset of the first unconsumed byte.
+		 */
+		std::size_t begin;
+		/**
+		 * Offset after the last committed byte. For the last block in the chain, any bytes
+		 * written through the put area are added to this in commit().
+		 */
+		std::size_t end;
+	};
+
+	const std::size_t mBlockSize;
+	const std::size_t mMaxPooledBlocks;
+
+	std::deque<Block> mBlocks;
+	std::vector<std::unique_ptr<char[]>> mPool;
+	std::vector<boost::asio::const_buffer> mGatherBuffers;
+	std::size_t mBlockAllocations;
+
+	/**
+	 * @brief Moves any data written to the put area into the last block.
+	 */
+	void commit();
+
+	/**
+	 * @brief Appends a new, empty block to the chain and makes it the put area.
+	 */
+	void appendBlock();
+
+	void resetPutArea();
+};
+
+inline std::size_t SegmentBuffer::getBlockAllocations() const
+{
+	return mBlockAllocations;
+}
+
+}
+
+#endif //ERIS_SEGMENTBUFFER_H
@@ -0,0 +1,206 @@
+#include "SharedMemoryChannel.h"
+#include "Exceptions.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace Eris
+{
+
+namespace
+{
+const char handshake_magic[7] = {'E', 'R', 'I', 'S', 'S', 'H', 'M'};
+const char handshake_version = 1;
+const std::size_t handshake_size = 12;
+const std::size_t max_capacity = 1u << 30u;
+
+/**
+ * The second ring starts at the first cache line after the first one.
+ */
+std::size_t ringOffset(std::size_t capacity)
+{
+	return (ShmRing::mappingSize(capacity) + 63) & ~std::size_t(63);
+}
+
+std::string errorString(const std::string& message)
+{
+	return message + ": " + std::strerror(errno);
+}
+
+}
+
+SharedMemoryChannel::SharedMemoryChannel(Side side, int memory, int clientWake, int serverWake, std::size_t capacity) :
+		mSide(side),
+		mMemoryDescriptor(memory),
+		mClientWake(clientWake),
+		mServerWake(serverWake),
+		mCapacity(capacity),
+		mMappingSize(ringOffset(capacity) * 2),
+		mMapping(MAP_FAILED)
+{
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+	mIncoming.reset();
+	mOutgoing.reset();
+	if (mMapping != MAP_FAILED) {
+		::munmap(mMapping, mMappingSize);
+	}
+	for (auto descriptor : {mMemoryDescriptor, mClientWake, mServerWake}) {
+		if (descriptor != -1) {
+			::close(descriptor);
+		}
+	}
+}
+
+std::unique_ptr<SharedMemoryChannel> SharedMemoryChannel::create(std::size_t capacity)
+{
+	if (capacity < 64 || capacity > max_capacity || (capacity & (capacity - 1)) != 0) {
+		throw NetworkFailure("The capacity of a shared memory channel must be a power of two of at least 64 bytes.");
+	}
+	//Make sure that all descriptors are closed if anything fails.
+	std::unique_ptr<SharedMemoryChannel> channel(new SharedMemoryChannel(Side::CLIENT, -1, -1, -1, capacity));
+	channel->mMemoryDescriptor = ::memfd_create("eris-shm", MFD_CLOEXEC);
+	if (channel->mMemoryDescriptor == -1) {
+		throw NetworkFailure(errorString("Could not create shared memory"));
+	}
+	if (::ftruncate(channel->mMemoryDescriptor, static_cast<off_t>(channel->mMappingSize)) != 0) {
+		throw NetworkFailure(errorString("Could not size shared memory"));
+	}
+	channel->mClientWake = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	channel->mServerWake = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (channel->mClientWake == -1 || channel->mServerWake == -1) {
+		throw NetworkFailure(errorString("Could not create eventfd"));
+	}
+	channel->mMapping = ::mmap(nullptr, channel->mMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, channel->mMemoryDescriptor, 0);
+	if (channel->mMapping == MAP_FAILED) {
+		throw NetworkFailure(errorString("Could not map shared memory"));
+	}
+	auto memory = static_cast<char*>(channel->mMapping);
+	ShmRing::initialize(memory, capacity);
+	ShmRing::initialize(memory + ringOffset(capacity), capacity);
+	channel->mOutgoing = std::make_unique<ShmRing>(memory, capacity);
+	channel->mIncoming = std::make_unique<ShmRing>(memory + ringOffset(capacity), capacity);
+	return channel;
+}
+
+std::unique_ptr<SharedMemoryChannel> SharedMemoryChannel::receiveHandshake(int socket)
+{
+	char payload[handshake_size];
+	iovec io{payload, sizeof(payload)};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)];
+	msghdr message{};
+	message.msg_iov = &io;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received;
+	do {
+		received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+	} while (received == -1 && errno == EINTR);
+	if (received == -1) {
+		throw NetworkFailure(errorString("Could not receive shared memory handshake"));
+	}
+
+	int descriptors[3] = {-1, -1, -1};
+	auto cmsg = CMSG_FIRSTHDR(&message);
+	if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(descriptors))) {
+		std::memcpy(descriptors, CMSG_DATA(cmsg), sizeof(descriptors));
+	}
+
+	std::size_t capacity = 0;
+	if (static_cast<std::size_t>(received) == handshake_size) {
+		for (std::size_t i = 0; i < 4; ++i) {
+			capacity |= static_cast<std::size_t>(static_cast<unsigned char>(payload[8 + i])) << (i * 8);
+		}
+	}
+	//The channel takes ownership of any descriptors received, so that they're closed if it's rejected.
+	std::unique_ptr<SharedMemoryChannel> channel(new SharedMemoryChannel(Side::SERVER, descriptors[0], descriptors[1], descriptors[2], capacity));
+
+	if (static_cast<std::size_t>(received) != handshake_size || std::memcmp(payload, handshake_magic, sizeof(handshake_magic)) != 0
+		|| payload[7] != handshake_version || (message.msg_flags & MSG_CTRUNC) != 0 || descriptors[2] == -1) {
+		throw NetworkFailure("Invalid shared memory handshake.");
+	}
+	if (capacity < 64 || capacity > max_capacity) {
+		throw NetworkFailure("Invalid shared memory capacity.");
+	}
+	struct stat status{};
+	if (::fstat(channel->mMemoryDescriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < channel->mMappingSize) {
+		throw NetworkFailure("The shared memory is too small.");
+	}
+	channel->mMapping = ::mmap(nullptr, channel->mMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, channel->mMemoryDescriptor, 0);
+	if (channel->mMapping == MAP_FAILED) {
+		throw NetworkFailure(errorString("Could not map shared memory"));
+	}
+	auto memory = static_cast<char*>(channel->mMapping);
+	try {
+		channel->mIncoming = std::make_unique<ShmRing>(memory, capacity);
+		channel->mOutgoing = std::make_unique<ShmRing>(memory + ringOffset(capacity), capacity);
+	} catch (const std::invalid_argument& e) {
+		throw NetworkFailure(e.what());
+	}
+	return channel;
+}
+
+void SharedMemoryChannel::sendHandshake(int socket)
+{
+	char payload[handshake_size];
+	std::memcpy(payload, handshake_magic, sizeof(handshake_magic));
+	payload[7] = handshake_version;
+	for (std::size_t i = 0; i < 4; ++i) {
+		payload[8 + i] = static_cast<char>((mCapacity >> (i * 8)) & 0xff);
+	}
+	iovec io{payload, sizeof(payload)};
+
+	int descriptors[3] = {mMemoryDescriptor, mClientWake, mServerWake};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(descriptors))] = {};
+	msghdr message{};
+	message.msg_iov = &io;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	auto cmsg = CMSG_FIRSTHDR(&message);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(descriptors));
+	std::memcpy(CMSG_DATA(cmsg), descriptors, sizeof(descriptors));
+
+	ssize_t sent;
+	do {
+		sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+	} while (sent == -1 && errno == EINTR);
+	if (sent != static_cast<ssize_t>(sizeof(payload))) {
+		throw NetworkFailure(errorString("Could not send shared memory handshake"));
+	}
+}
+
+void SharedMemoryChannel::wakePeer()
+{
+	std::uint64_t value = 1;
+	auto descriptor = mSide == Side::CLIENT ? mServerWake : mClientWake;
+	//Can only fail if the counter is about to overflow, in which case the peer has plenty of wakeups pending anyway.
+	ssize_t result;
+	do {
+		result = ::write(descriptor, &value, sizeof(value));
+	} while (result == -1 && errno == EINTR);
+}
+
+void SharedMemoryChannel::wakePeerIfWaiting()
+{
+	bool readerWaiting = mOutgoing->shouldWakeReader();
+	bool writerWaiting = mIncoming->shouldWakeWriter();
+	if (readerWaiting || writerWaiting) {
+		wakePeer();
+	}
+}
+
+}
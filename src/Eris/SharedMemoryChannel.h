@@ -0,0 +1,121 @@
+#ifndef ERIS_SHAREDMEMORYCHANNEL_H
+#define ERIS_SHAREDMEMORYCHANNEL_H
+
+#include "ShmRing.h"
+
+#include <memory>
+
+namespace Eris
+{
+
+/**
+ * @brief A pair of rings in shared memory, for exchanging data with a process on the same machine.
+ *
+ * The client creates the shared memory, along with an eventfd for each side to be woken up through, and
+ * passes them to the server over a Unix domain socket. The handshake message consists of the magic
+ * "ERISSHM" followed by a version byte, and the capacity of each ring as a little endian 32 bit value,
+ * with the memory, the client's eventfd and the server's eventfd attached as SCM_RIGHTS, in that order.
+ * The server replies with a single byte: ACCEPTED if it's going to use the channel.
+ *
+ * The memory holds the ring from the client to the server, followed by the one from the server to the client.
+ * A side signals the eventfd of the other side when the rings tell it to wake it up.
+ *
+ * Only available on Linux.
+ */
+class SharedMemoryChannel
+{
+public:
+	static constexpr char ACCEPTED = 'Y';
+
+	/**
+	 * @brief Creates a channel, for the client side.
+	 * @param capacity The capacity of each ring, which must be a power of two.
+	 * @throws NetworkFailure If the shared memory or the eventfds can't be created.
+	 */
+	static std::unique_ptr<SharedMemoryChannel> create(std::size_t capacity);
+
+	/**
+	 * @brief Receives a channel sent by a client through sendHandshake(), for the server side.
+	 *
+	 * Blocks until the handshake has been received. The reply isn't sent.
+	 * @param socket A connected Unix domain socket.
+	 * @throws NetworkFailure If no valid handshake could be received.
+	 */
+	static std::unique_ptr<SharedMemoryChannel> receiveHandshake(int socket);
+
+	~SharedMemoryChannel();
+
+	SharedMemoryChannel(const SharedMemoryChannel&) = delete;
+
+	SharedMemoryChannel& operator=(const SharedMemoryChannel&) = delete;
+
+	/**
+	 * @brief Sends the channel to the server.
+	 * @param socket A connected Unix domain socket.
+	 * @throws NetworkFailure If the handshake couldn't be sent.
+	 */
+	void sendHandshake(int socket);
+
+	/**
+	 * @brief The ring through which data arrives from the other side.
+	 */
+	ShmRing& incoming();
+
+	/**
+	 * @brief The ring through which data is sent to the other side.
+	 */
+	ShmRing& outgoing();
+
+	/**
+	 * @brief Gets the eventfd which is signalled when this side should check the rings.
+	 */
+	int getWakeDescriptor() const;
+
+	/**
+	 * @brief Wakes up the other side.
+	 */
+	void wakePeer();
+
+	/**
+	 * @brief Wakes up the other side if it's waiting for the data just written, or the space just freed.
+	 */
+	void wakePeerIfWaiting();
+
+private:
+	enum class Side
+	{
+		CLIENT,
+		SERVER
+	};
+
+	SharedMemoryChannel(Side side, int memory, int clientWake, int serverWake, std::size_t capacity);
+
+	Side mSide;
+	int mMemoryDescriptor;
+	int mClientWake;
+	int mServerWake;
+	std::size_t mCapacity;
+	std::size_t mMappingSize;
+	void* mMapping;
+	std::unique_ptr<ShmRing> mIncoming;
+	std::unique_ptr<ShmRing> mOutgoing;
+};
+
+inline ShmRing& SharedMemoryChannel::incoming()
+{
+	return *mIncoming;
+}
+
+inline ShmRing& SharedMemoryChannel::outgoing()
+{
+	return *mOutgoing;
+}
+
+inline int SharedMemoryChannel::getWakeDescriptor() const
+{
+	return mSide == Side::CLIENT ? mClientWake : mServerWake;
+}
+
+}
+
+#endif //ERIS_SHAREDMEMORYCHANNEL_H
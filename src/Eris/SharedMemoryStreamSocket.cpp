@@ -0,0 +1,224 @@
+#include "SharedMemoryStreamSocket.h"
+#include "Exceptions.h"
+#include "Log.h"
+#include "StreamSocket_impl.h"
+
+#include <unistd.h>
+
+namespace Eris
+{
+
+SharedMemoryStreamSocket::SharedMemoryStreamSocket(boost::asio::io_service& io_service,
+												   const std::string& client_name, Atlas::Bridge& bridge,
+												   StreamSocket::Callbacks callbacks,
+												   std::size_t capacity) :
+		AsioStreamSocket(io_service, client_name, bridge, std::move(callbacks)),
+		mCapacity(capacity),
+		mWakeDescriptor(io_service),
+		mWakeCount(0),
+		mIsWaiting(false),
+		mIsEstablished(false),
+		mSocketData(0)
+{
+}
+
+SharedMemoryStreamSocket::~SharedMemoryStreamSocket() = default;
+
+void SharedMemoryStreamSocket::negotiate_read()
+{
+	//This is first called when the socket has connected, and the negotiation is about to start.
+	if (!mChannel) {
+		sendHandshake();
+	}
+}
+
+void SharedMemoryStreamSocket::do_read()
+{
+	//Incoming data is handled by transfer(), which is already waiting for it.
+}
+
+void SharedMemoryStreamSocket::sendHandshake()
+{
+	try {
+		mChannel = SharedMemoryChannel::create(mCapacity);
+		mChannel->sendHandshake(m_socket.native_handle());
+		int wakeDescriptor = ::dup(mChannel->getWakeDescriptor());
+		if (wakeDescriptor == -1) {
+			throw NetworkFailure("Could not duplicate the eventfd.");
+		}
+		mWakeDescriptor.assign(wakeDescriptor);
+	} catch (const NetworkFailure& e) {
+		error() << "Could not set up shared memory: " << e.what();
+		m_socket.close();
+		_callbacks.stateChanged(NEGOTIATE_FAILED);
+		return;
+	}
+
+	auto self(this->shared_from_this());
+	boost::asio::async_read(m_socket, boost::asio::buffer(&mSocketData, 1),
+			[this, self](boost::system::error_code ec, std::size_t) {
+				if (!_callbacks.stateChanged) {
+					return;
+				}
+				if (ec || mSocketData != SharedMemoryChannel::ACCEPTED) {
+					error() << "The server didn't accept the shared memory.";
+					m_socket.close();
+					_callbacks.stateChanged(NEGOTIATE_FAILED);
+					return;
+				}
+				mIsEstablished = true;
+				watchSocket();
+				//Send what the negotiation has written so far.
+				this->write();
+				transfer();
+			});
+}
+
+void SharedMemoryStreamSocket::watchSocket()
+{
+	auto self(this->shared_from_this());
+	boost::asio::async_read(m_socket, boost::asio::buffer(&mSocketData, 1),
+			[this, self](boost::system::error_code ec, std::size_t) {
+				//Nothing more should be sent on the socket, so this means that the server is gone.
+				if (_callbacks.stateChanged && ec != boost::asio::error::operation_aborted) {
+					_callbacks.stateChanged(CONNECTION_FAILED);
+				}
+			});
+}
+
+void SharedMemoryStreamSocket::waitForWake()
+{
+	if (mIsWaiting) {
+		return;
+	}
+	mIsWaiting = true;
+	auto self(this->shared_from_this());
+	mWakeDescriptor.async_read_some(boost::asio::buffer(&mWakeCount, sizeof(mWakeCount)),
+			[this, self](boost::system::error_code ec, std::size_t) {
+				mIsWaiting = false;
+				if (!_callbacks.stateChanged) {
+					return;
+				}
+				if (ec) {
+					if (ec != boost::asio::error::operation_aborted) {
+						_callbacks.stateChanged(CONNECTION_FAILED);
+					}
+					return;
+				}
+				mStatistics.readSyscalls++;
+				transfer();
+			});
+}
+
+void SharedMemoryStreamSocket::transfer()
+{
+	auto& incoming = mChannel->incoming();
+	auto& outgoing = mChannel->outgoing();
+	while (true) {
+		auto length = receive();
+		if (mWriteBuffer.size() != 0) {
+			this->write();
+		}
+		//Let the server know if we've made room for it.
+		mChannel->wakePeerIfWaiting();
+		if (length > 0) {
+			if (!processReceived() || !_callbacks.stateChanged) {
+				return;
+			}
+			continue;
+		}
+		//Check once more after telling the server that we're about to wait, so that no wakeup is missed.
+		if (!incoming.prepareToWaitForData()) {
+			continue;
+		}
+		if (mWriteBuffer.size() != 0 && !outgoing.prepareToWaitForSpace()) {
+			continue;
+		}
+		break;
+	}
+	waitForWake();
+}
+
+std::size_t SharedMemoryStreamSocket::receive()
+{
+	auto& incoming = mChannel->incoming();
+	std::size_t total = 0;
+	std::size_t available;
+	while ((available = incoming.readable()) > 0 && total < read_burst_limit) {
+		std::size_t length = 0;
+		for (auto& buffer : mReadBuffer.prepare(available)) {
+			length += incoming.read(static_cast<char*>(buffer.data()), buffer.size());
+		}
+		this->commitReceived(length);
+		total += length;
+	}
+	if (total > 0) {
+		mStatistics.bytesRead += total;
+		mReadBuffer.recordBurst(total);
+	}
+	return total;
+}
+
+bool SharedMemoryStreamSocket::processReceived()
+{
+	if (_sc != nullptr) {
+		if (this->negotiate() == Atlas::Negotiate::FAILED) {
+			m_socket.close();
+			_callbacks.stateChanged(NEGOTIATE_FAILED);
+			return false;
+		}
+		this->write();
+		//The data which completed the negotiation might also contain the start of the session.
+		if (_sc != nullptr || !_callbacks.stateChanged) {
+			return true;
+		}
+	}
+	mStatistics.readBatches++;
+	try {
+		this->decodeReceived();
+	} catch (const NetworkFailure& e) {
+		//Thrown if the data can't be decompressed.
+		error() << "Error when decoding data from shared memory: " << e.what();
+		m_socket.close();
+		_callbacks.stateChanged(CONNECTION_FAILED);
+		return false;
+	}
+	_callbacks.dispatch();
+	return true;
+}
+
+void SharedMemoryStreamSocket::write()
+{
+	//Until the server has accepted the channel the data is kept in the buffer.
+	if (!mIsEstablished) {
+		return;
+	}
+	//Make sure that any data held by the compressor is written to the buffer.
+	if (mCompressor) {
+		mOutStream.flush();
+	}
+	auto& outgoing = mChannel->outgoing();
+	while (mWriteBuffer.size() != 0) {
+		std::size_t total = 0;
+		for (auto& buffer : mWriteBuffer.data()) {
+			auto length = outgoing.write(static_cast<const char*>(buffer.data()), buffer.size());
+			total += length;
+			if (length < buffer.size()) {
+				break;
+			}
+		}
+		if (total > 0) {
+			mWriteBuffer.consume(total);
+			mStatistics.writes++;
+			mStatistics.bytesWritten += total;
+			mChannel->wakePeerIfWaiting();
+		}
+		//If the ring is full, the server will wake us up once it has made room.
+		if (mWriteBuffer.size() != 0 && outgoing.prepareToWaitForSpace()) {
+			break;
+		}
+	}
+	this->updateCongestion();
+}
+
+}
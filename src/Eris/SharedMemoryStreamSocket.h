@@ -0,0 +1,92 @@
+#ifndef ERIS_SHAREDMEMORYSTREAMSOCKET_H
+#define ERIS_SHAREDMEMORYSTREAMSOCKET_H
+
+#include "StreamSocket.h"
+#include "SharedMemoryChannel.h"
+
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+namespace Eris
+{
+
+/**
+ * @brief A socket for servers on the same machine, which moves all data through shared memory.
+ *
+ * A Unix domain socket is connected as usual, but is then only used to pass a SharedMemoryChannel to the
+ * server, and to notice if the server goes away. The Atlas negotiation and all further data go through the
+ * rings of the channel, which saves copying the data through the kernel. The server must support this.
+ *
+ * Only available on Linux.
+ */
+class SharedMemoryStreamSocket : public AsioStreamSocket<boost::asio::local::stream_protocol>
+{
+public:
+	/**
+	 * The default capacity of each of the rings.
+	 */
+	static constexpr std::size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+	SharedMemoryStreamSocket(boost::asio::io_service& io_service,
+							 const std::string& client_name, Atlas::Bridge& bridge,
+							 StreamSocket::Callbacks callbacks,
+							 std::size_t capacity = DEFAULT_CAPACITY);
+
+	~SharedMemoryStreamSocket() override;
+
+	void write() override;
+
+protected:
+	std::size_t mCapacity;
+	std::unique_ptr<SharedMemoryChannel> mChannel;
+
+	/**
+	 * Our eventfd of the channel, signalled when the rings need checking.
+	 */
+	boost::asio::posix::stream_descriptor mWakeDescriptor;
+	std::uint64_t mWakeCount;
+	bool mIsWaiting;
+
+	/**
+	 * True once the server has accepted the channel.
+	 */
+	bool mIsEstablished;
+
+	/**
+	 * Receives the reply to the handshake, and then anything else arriving on the socket.
+	 */
+	char mSocketData;
+
+	void negotiate_read() override;
+
+	void do_read() override;
+
+	void sendHandshake();
+
+	/**
+	 * @brief Fails the connection once the server closes the socket.
+	 */
+	void watchSocket();
+
+	void waitForWake();
+
+	/**
+	 * @brief Moves data between the buffers and the rings until there's nothing more to do.
+	 */
+	void transfer();
+
+	/**
+	 * @brief Copies everything in the incoming ring into the read buffer.
+	 * @return The number of bytes copied.
+	 */
+	std::size_t receive();
+
+	/**
+	 * @brief Negotiates, or decodes and dispatches, the received data.
+	 * @return False if the connection failed.
+	 */
+	bool processReceived();
+};
+
+}
+
+#endif //ERIS_SHAREDMEMORYSTREAMSOCKET_H
@@ -0,0 +1,112 @@
+#include "ShmRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace Eris
+{
+
+std::size_t ShmRing::mappingSize(std::size_t capacity)
+{
+	return sizeof(Header) + capacity;
+}
+
+void ShmRing::initialize(void* memory, std::size_t capacity)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		throw std::invalid_argument("The capacity of the ring must be a power of two.");
+	}
+	auto header = new(memory) Header();
+	header->written.store(0);
+	header->readerWaiting.store(0);
+	header->read.store(0);
+	header->writerWaiting.store(0);
+	header->capacity = capacity;
+}
+
+ShmRing::ShmRing(void* memory, std::size_t capacity) :
+		mHeader(static_cast<Header*>(memory)),
+		mData(static_cast<char*>(memory) + sizeof(Header)),
+		mCapacity(capacity)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0 || mHeader->capacity != capacity) {
+		throw std::invalid_argument("The ring doesn't have the expected capacity.");
+	}
+}
+
+std::size_t ShmRing::write(const char* data, std::size_t size)
+{
+	auto written = mHeader->written.load(std::memory_order_relaxed);
+	auto length = std::min(size, writable());
+	if (length == 0) {
+		return 0;
+	}
+	auto offset = static_cast<std::size_t>(written & (mCapacity - 1));
+	auto first = std::min(length, mCapacity - offset);
+	std::memcpy(mData + offset, data, first);
+	std::memcpy(mData, data + first, length - first);
+	//Sequentially consistent, so that it's ordered with the check of readerWaiting in shouldWakeReader().
+	mHeader->written.store(written + length);
+	return length;
+}
+
+std::size_t ShmRing::read(char* data, std::size_t size)
+{
+	auto read = mHeader->read.load(std::memory_order_relaxed);
+	auto length = std::min(size, readable());
+	if (length == 0) {
+		return 0;
+	}
+	auto offset = static_cast<std::size_t>(read & (mCapacity - 1));
+	auto first = std::min(length, mCapacity - offset);
+	std::memcpy(data, mData + offset, first);
+	std::memcpy(data + first, mData, length - first);
+	mHeader->read.store(read + length);
+	return length;
+}
+
+std::size_t ShmRing::readable() const
+{
+	auto used = mHeader->written.load() - mHeader->read.load();
+	//Guard against the peer having written nonsense into the header.
+	return static_cast<std::size_t>(std::min<std::uint64_t>(used, mCapacity));
+}
+
+std::size_t ShmRing::writable() const
+{
+	return mCapacity - readable();
+}
+
+bool ShmRing::prepareToWaitForData()
+{
+	mHeader->readerWaiting.store(1);
+	if (readable() != 0) {
+		mHeader->readerWaiting.store(0);
+		return false;
+	}
+	return true;
+}
+
+bool ShmRing::shouldWakeReader()
+{
+	return mHeader->readerWaiting.load() != 0 && mHeader->readerWaiting.exchange(0) != 0;
+}
+
+bool ShmRing::prepareToWaitForSpace()
+{
+	mHeader->writerWaiting.store(1);
+	if (writable() != 0) {
+		mHeader->writerWaiting.store(0);
+		return false;
+	}
+	return true;
+}
+
+bool ShmRing::shouldWakeWriter()
+{
+	return mHeader->writerWaiting.load() != 0 && mHeader->writerWaiting.exchange(0) != 0;
+}
+
+}
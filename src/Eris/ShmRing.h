@@ -0,0 +1,119 @@
+#ifndef ERIS_SHMRING_H
+#define ERIS_SHMRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Eris
+{
+
+/**
+ * @brief A single producer, single consumer byte ring placed in memory shared between two processes.
+ *
+ * The ring consists of a header followed by the data area. The header holds the total number of bytes written
+ * and read, which only ever increase, so that the ring never needs any locking. The writer and reader each
+ * keep their own copy of the capacity, so a misbehaving peer can't make them access memory outside the ring.
+ *
+ * To avoid a system call for every write, the peer only needs to be woken up if it has said that it's
+ * about to wait: a reader calls prepareToWaitForData() before waiting, and the writer then checks
+ * shouldWakeReader() after writing. The same goes for a writer waiting for space.
+ */
+class ShmRing
+{
+public:
+
+	/**
+	 * @brief Gets the number of bytes of memory needed for a ring.
+	 * @param capacity The capacity of the ring, which must be a power of two.
+	 */
+	static std::size_t mappingSize(std::size_t capacity);
+
+	/**
+	 * @brief Sets up an empty ring in the memory. Only one of the processes should do this.
+	 * @param memory Memory of at least mappingSize(capacity) bytes, aligned to a cache line.
+	 * @param capacity The capacity of the ring, which must be a power of two.
+	 */
+	static void initialize(void* memory, std::size_t capacity);
+
+	/**
+	 * @brief Attaches to a ring set up with initialize().
+	 * @param memory The memory the ring was set up in.
+	 * @param capacity The capacity which the ring is expected to have.
+	 * @throws std::invalid_argument If the ring in the memory doesn't have the expected capacity.
+	 */
+	ShmRing(void* memory, std::size_t capacity);
+
+	/**
+	 * @brief Copies as much of the data as fits into the ring.
+	 * @return The number of bytes copied.
+	 */
+	std::size_t write(const char* data, std::size_t size);
+
+	/**
+	 * @brief Copies up to "size" bytes out of the ring.
+	 * @return The number of bytes copied.
+	 */
+	std::size_t read(char* data, std::size_t size);
+
+	/**
+	 * @brief Gets the number of bytes which can be read.
+	 */
+	std::size_t readable() const;
+
+	/**
+	 * @brief Gets the number of bytes which can be written.
+	 */
+	std::size_t writable() const;
+
+	std::size_t capacity() const;
+
+	/**
+	 * @brief Tells the writer that the reader is about to wait for data.
+	 * @return True if the ring is still empty, and the reader should wait. If false, data arrived in the meantime.
+	 */
+	bool prepareToWaitForData();
+
+	/**
+	 * @brief Checks if the reader is waiting for data, and needs to be woken up. Call after writing.
+	 */
+	bool shouldWakeReader();
+
+	/**
+	 * @brief Tells the reader that the writer is about to wait for space.
+	 * @return True if the ring is still full, and the writer should wait. If false, space was freed in the meantime.
+	 */
+	bool prepareToWaitForSpace();
+
+	/**
+	 * @brief Checks if the writer is waiting for space, and needs to be woken up. Call after reading.
+	 */
+	bool shouldWakeWriter();
+
+private:
+
+	struct Header
+	{
+		alignas(64) std::atomic<std::uint64_t> written;
+		std::atomic<std::uint32_t> readerWaiting;
+		alignas(64) std::atomic<std::uint64_t> read;
+		std::atomic<std::uint32_t> writerWaiting;
+		alignas(64) std::uint64_t capacity;
+	};
+
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The ring requires lock free 64 bit atomics.");
+	static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "The ring requires lock free 32 bit atomics.");
+
+	Header* mHeader;
+	char* mData;
+	std::size_t mCapacity;
+};
+
+inline std::size_t ShmRing::capacity() const
+{
+	return mCapacity;
+}
+
+}
+
+#endif //ERIS_SHMRING_H
@@ -0,0 +1,237 @@
+#include "StreamCompression.h"
+#include "Exceptions.h"
+
+#ifdef ERIS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <array>
+
+namespace Eris
+{
+
+#ifdef ERIS_HAVE_ZLIB
+namespace
+{
+
+const std::size_t compression_buffer_size = 16384;
+
+/**
+ * Compresses everything written to it into another buffer.
+ */
+class DeflateStreambuf : public std::streambuf
+{
+public:
+	DeflateStreambuf(std::streambuf& target, const std::string& dictionary, int level) :
+			mTarget(target),
+			mStream(),
+			mHasPendingData(false)
+	{
+		if (deflateInit(&mStream, level) != Z_OK) {
+			throw NetworkFailure("Could not initialize deflate compression.");
+		}
+		if (!dictionary.empty()) {
+			deflateSetDictionary(&mStream, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+		}
+		setp(mInput.data(), mInput.data() + mInput.size());
+	}
+
+	~DeflateStreambuf() override
+	{
+		deflateEnd(&mStream);
+	}
+
+protected:
+	int_type overflow(int_type ch) override
+	{
+		if (!deflateInput(Z_NO_FLUSH)) {
+			return traits_type::eof();
+		}
+		if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(ch);
+			pbump(1);
+		}
+		return traits_type::not_eof(ch);
+	}
+
+	int sync() override
+	{
+		//Avoid writing empty flush blocks if nothing has been written since the last sync.
+		if (pptr() == pbase() && !mHasPendingData) {
+			return 0;
+		}
+		return deflateInput(Z_SYNC_FLUSH) ? 0 : -1;
+	}
+
+private:
+	std::streambuf& mTarget;
+	z_stream mStream;
+	std::array<char, compression_buffer_size> mInput;
+	std::array<char, compression_buffer_size> mOutput;
+
+	/**
+	 * True if data has been handed to zlib, but not yet flushed out.
+	 */
+	bool mHasPendingData;
+
+	bool deflateInput(int flush)
+	{
+		mStream.next_in = reinterpret_cast<Bytef*>(pbase());
+		mStream.avail_in = static_cast<uInt>(pptr() - pbase());
+		do {
+			mStream.next_out = reinterpret_cast<Bytef*>(mOutput.data());
+			mStream.avail_out = static_cast<uInt>(mOutput.size());
+			auto result = deflate(&mStream, flush);
+			if (result == Z_STREAM_ERROR) {
+				return false;
+			}
+			auto produced = static_cast<std::streamsize>(mOutput.size() - mStream.avail_out);
+			if (produced > 0 && mTarget.sputn(mOutput.data(), produced) != produced) {
+				return false;
+			}
+		} while (mStream.avail_out == 0);
+
+		mHasPendingData = flush == Z_NO_FLUSH;
+		setp(mInput.data(), mInput.data() + mInput.size());
+		return true;
+	}
+};
+
+/**
+ * Decompresses data read from another buffer.
+ */
+class InflateStreambuf : public std::streambuf
+{
+public:
+	InflateStreambuf(std::streambuf& source, std::string dictionary) :
+			mSource(source),
+			mStream(),
+			mDictionary(std::move(dictionary))
+	{
+		if (inflateInit(&mStream) != Z_OK) {
+			throw NetworkFailure("Could not initialize deflate decompression.");
+		}
+		setg(mOutput.data(), mOutput.data(), mOutput.data());
+	}
+
+	~InflateStreambuf() override
+	{
+		inflateEnd(&mStream);
+	}
+
+protected:
+
+	int_type underflow() override
+	{
+		if (gptr() < egptr()) {
+			return traits_type::to_int_type(*gptr());
+		}
+		while (true) {
+			if (mStream.avail_in == 0) {
+				auto available = mSource.in_avail();
+				if (available <= 0) {
+					return traits_type::eof();
+				}
+				auto length = mSource.sgetn(mInput.data(), std::min(available, static_cast<std::streamsize>(mInput.size())));
+				mStream.next_in = reinterpret_cast<Bytef*>(mInput.data());
+				mStream.avail_in = static_cast<uInt>(length);
+			}
+
+			mStream.next_out = reinterpret_cast<Bytef*>(mOutput.data());
+			mStream.avail_out = static_cast<uInt>(mOutput.size());
+			auto result = inflate(&mStream, Z_SYNC_FLUSH);
+			if (result == Z_NEED_DICT) {
+				if (mDictionary.empty()
+					|| inflateSetDictionary(&mStream, reinterpret_cast<const Bytef*>(mDictionary.data()), static_cast<uInt>(mDictionary.size())) != Z_OK) {
+					throw NetworkFailure("Compressed data requires an unknown dictionary.");
+				}
+				result = inflate(&mStream, Z_SYNC_FLUSH);
+			}
+			if (result != Z_OK && result != Z_BUF_ERROR && result != Z_STREAM_END) {
+				throw NetworkFailure(std::string("Error when decompressing data: ") + (mStream.msg ? mStream.msg : "unknown error"));
+			}
+
+			auto produced = mOutput.size() - mStream.avail_out;
+			if (produced > 0) {
+				setg(mOutput.data(), mOutput.data(), mOutput.data() + produced);
+				return traits_type::to_int_type(*gptr());
+			}
+			//Nothing was produced, which means that all the input was consumed without completing a block. Try to get more.
+		}
+	}
+
+	std::streamsize showmanyc() override
+	{
+		if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+			return 0;
+		}
+		return egptr() - gptr();
+	}
+
+private:
+	std::streambuf& mSource;
+	z_stream mStream;
+	const std::string mDictionary;
+	std::array<char, compression_buffer_size> mInput;
+	std::array<char, compression_buffer_size> mOutput;
+};
+
+}
+#endif
+
+DeflateCompression::DeflateCompression(std::string dictionary, int level) :
+		mDictionary(std::move(dictionary)),
+		mLevel(level)
+{
+	if (!isAvailable()) {
+		throw InvalidOperation("Eris was built without zlib, so deflate compression isn't available.");
+	}
+}
+
+std::unique_ptr<std::streambuf> DeflateCompression::createCompressor(std::streambuf& target)
+{
+#ifdef ERIS_HAVE_ZLIB
+	return std::make_unique<DeflateStreambuf>(target, mDictionary, mLevel);
+#else
+	return nullptr;
+#endif
+}
+
+std::unique_ptr<std::streambuf> DeflateCompression::createDecompressor(std::streambuf& source)
+{
+#ifdef ERIS_HAVE_ZLIB
+	return std::make_unique<InflateStreambuf>(source, mDictionary);
+#else
+	return nullptr;
+#endif
+}
+
+bool DeflateCompression::isAvailable()
+{
+#ifdef ERIS_HAVE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+const std::string& DeflateCompression::getAtlasDictionary()
+{
+	//zlib gives the shortest codes to strings at the end of the dictionary, so the most common ones are put last.
+	static const std::string dictionary =
+			"<atlas><map><list name=\"args\"><string name=\"objtype\">obj</string><string name=\"parent\"></string>"
+			"<string name=\"id\"></string><string name=\"loc\"></string><list name=\"pos\"><float></float></list>"
+			"<list name=\"orientation\"></list><list name=\"velocity\"></list><list name=\"contains\"></list>"
+			"<float name=\"stamp\"></float><string name=\"from\"></string><string name=\"to\"></string>"
+			"<int name=\"serialno\"></int><int name=\"refno\"></int><float name=\"seconds\"></float></map></atlas>"
+			"children:[],description:\"\",name:\"\",bbox:[],mode:\"\",properties:{},attributes:{},"
+			"objtype:\"class\",parent:\"game_entity\",parent:\"thing\",parent:\"info\",parent:\"appearance\","
+			"parent:\"disappearance\",parent:\"set\",parent:\"move\",parent:\"look\",parent:\"create\",parent:\"delete\","
+			"contains:[],orientation:[],velocity:[],angular:[],_propel:[],_direction:[],"
+			"refno:,serialno:,seconds:,from:\"\",to:\"\",stamp:,loc:\"\",pos:[],"
+			"{objtype:\"op\",parent:\"sight\",args:[{objtype:\"obj\",id:\"\",parent:\"\",";
+	return dictionary;
+}
+
+}
@@ -0,0 +1,80 @@
+#ifndef ERIS_STREAMCOMPRESSION_H
+#define ERIS_STREAMCOMPRESSION_H
+
+#include <boost/noncopyable.hpp>
+
+#include <streambuf>
+#include <memory>
+#include <string>
+
+namespace Eris
+{
+
+/**
+ * @brief A compression layer which can be put between a StreamSocket and its codec.
+ *
+ * Implementations provide stream buffers which wrap the raw socket buffers. Data written to the
+ * compressor is compressed into the wrapped buffer, and data read from the decompressor is
+ * decompressed from the wrapped buffer.
+ *
+ * The compressor will hold on to data until it's synced (through std::ostream::flush() or pubsync()),
+ * which the socket does before each write.
+ */
+class StreamCompression : private boost::noncopyable
+{
+public:
+	virtual ~StreamCompression() = default;
+
+	/**
+	 * @brief Creates a buffer which compresses everything written to it into the target buffer.
+	 * @param target The buffer to which compressed data is written. Must outlive the returned instance.
+	 */
+	virtual std::unique_ptr<std::streambuf> createCompressor(std::streambuf& target) = 0;
+
+	/**
+	 * @brief Creates a buffer which decompresses data read from the source buffer.
+	 * @param source The buffer from which compressed data is read. Must outlive the returned instance.
+	 */
+	virtual std::unique_ptr<std::streambuf> createDecompressor(std::streambuf& source) = 0;
+};
+
+/**
+ * @brief Streaming deflate compression, as provided by zlib.
+ *
+ * A preset dictionary can be supplied, which helps a lot with the compression of small ops since these
+ * mainly consist of the same attribute names and keywords. Both ends of a connection must use the same dictionary.
+ */
+class DeflateCompression : public StreamCompression
+{
+public:
+
+	/**
+	 * @brief Ctor.
+	 * @param dictionary A preset dictionary. If empty no dictionary is used.
+	 * @param level The compression level, between 1 (fastest) and 9 (best compression).
+	 * @throws InvalidOperation If Eris was built without zlib.
+	 */
+	explicit DeflateCompression(std::string dictionary = getAtlasDictionary(), int level = 6);
+
+	std::unique_ptr<std::streambuf> createCompressor(std::streambuf& target) override;
+
+	std::unique_ptr<std::streambuf> createDecompressor(std::streambuf& source) override;
+
+	/**
+	 * @brief Gets a dictionary containing the strings commonly found in Atlas data, for both the Bach and XML codecs.
+	 */
+	static const std::string& getAtlasDictionary();
+
+	/**
+	 * @brief Checks whether Eris was built with zlib, which deflate compression needs.
+	 */
+	static bool isAvailable();
+
+private:
+	const std::string mDictionary;
+	const int mLevel;
+};
+
+}
+
+#endif //ERIS_STREAMCOMPRESSION_H
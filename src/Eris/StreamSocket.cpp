@@ -21,12 +21,16 @@
 #endif
 
 #include "StreamSocket.h"
+#include "StreamCompression.h"
+#include "Capture.h"
 #include "Log.h"
 
 #include <Atlas/Codec.h>
 #include <Atlas/Net/Stream.h>
 #include <Atlas/Objects/Encoder.h>
 
+#include <algorithm>
+
 using namespace boost::asio;
 
 static const int NEGOTIATE_TIMEOUT_SECONDS = 5;
@@ -39,10 +43,8 @@ StreamSocket::StreamSocket(io_service& io_service,
 						   Callbacks callbacks) :
 		_bridge(bridge),
 		_callbacks(std::move(callbacks)),
-		mWriteBuffer(new boost::asio::streambuf()),
-		mSendBuffer(new boost::asio::streambuf()),
 		mInStream(&mReadBuffer),
-		mOutStream(mWriteBuffer.get()),
+		mOutStream(&mWriteBuffer),
 		mShouldSend(false),
 		mIsSending(false),
 		_sc(std::make_unique<Atlas::Net::StreamConnect>(client_name, mInStream, mOutStream)),
@@ -50,7 +52,10 @@ StreamSocket::StreamSocket(io_service& io_service,
 		_connectTimer(io_service),
 		m_codec(nullptr),
 		m_encoder(nullptr),
-		m_is_connected(false) {
+		m_is_connected(false),
+		mHighWatermark(256 * 1024),
+		mLowWatermark(64 * 1024),
+		mIsCongested(false) {
 }
 
 StreamSocket::~StreamSocket() = default;
@@ -77,7 +82,13 @@ void StreamSocket::startNegotiation() {
 	});
 	_callbacks.stateChanged(NEGOTIATE);
 
+	//Route the negotiation through a separate buffer, so that we can alter the codecs offered.
+	if (!mCodecPreference.empty()) {
+		mOutStream.rdbuf(&mNegotiationBuffer);
+	}
+
 	_sc->poll();
+	transferNegotiationOutput();
 
 	write();
 	negotiate_read();
@@ -86,6 +97,7 @@ void StreamSocket::startNegotiation() {
 Atlas::Negotiate::State StreamSocket::negotiate() {
 	// poll and check if negotiation is complete
 	_sc->poll();
+	transferNegotiationOutput();
 
 	if (_sc->getState() == Atlas::Negotiate::IN_PROGRESS) {
 		return _sc->getState();
@@ -109,6 +121,16 @@ Atlas::Negotiate::State StreamSocket::negotiate() {
 		error() << "Could not create codec during negotiation.";
 		return Atlas::Negotiate::FAILED;
 	}
+	//The codec writes to the same stream as the negotiation did, which should now go straight to the write buffer.
+	mOutStream.rdbuf(&mWriteBuffer);
+	//Anything sent or received from now on goes through the compression layer, if there is one.
+	if (mCompression) {
+		mCompressor = mCompression->createCompressor(mWriteBuffer);
+		mDecompressor = mCompression->createDecompressor(mReadBuffer);
+		mOutStream.rdbuf(mCompressor.get());
+		mInStream.rdbuf(mDecompressor.get());
+	}
+
 	// Create a new encoder to send high level objects to the codec
 	m_encoder = std::make_unique<Atlas::Objects::ObjectsEncoder>(*m_codec);
 
@@ -130,4 +152,127 @@ Atlas::Objects::ObjectsEncoder& StreamSocket::getEncoder() {
 	return *m_encoder;
 }
 
+const StreamSocket::Statistics& StreamSocket::getStatistics() const {
+	return mStatistics;
+}
+
+void StreamSocket::setCompression(std::shared_ptr<StreamCompression> compression) {
+	mCompression = std::move(compression);
+}
+
+void StreamSocket::setReceivedDataHandler(std::function<void(std::string)> handler) {
+	mReceivedDataHandler = std::move(handler);
+}
+
+void StreamSocket::setCodecPreference(std::vector<std::string> codecs) {
+	mCodecPreference = std::move(codecs);
+}
+
+void StreamSocket::setCapture(std::shared_ptr<CaptureWriter> capture) {
+	mCapture = std::move(capture);
+}
+
+void StreamSocket::commitReceived(std::size_t length) {
+	if (mCapture && length > 0) {
+		//Preparing the same amount of space again returns the region the data was just read into.
+		mCapture->record(mReadBuffer.prepare(length));
+	}
+	mReadBuffer.commit(length);
+}
+
+std::vector<std::string> StreamSocket::orderCodecs(const std::vector<std::string>& offered, const std::vector<std::string>& preference) {
+	std::vector<std::string> result;
+	for (auto& preferred : preference) {
+		for (auto& codec : offered) {
+			//Allow for version suffixes, such as in "Bach_beta2".
+			if (codec == preferred || (codec.size() > preferred.size() && codec.compare(0, preferred.size(), preferred) == 0 && codec[preferred.size()] == '_')) {
+				if (std::find(result.begin(), result.end(), codec) == result.end()) {
+					result.push_back(codec);
+				}
+			}
+		}
+	}
+	if (result.empty()) {
+		warning() << "None of the preferred codecs are supported; offering all codecs.";
+		return offered;
+	}
+	return result;
+}
+
+void StreamSocket::transferNegotiationOutput() {
+	if (mOutStream.rdbuf() != &mNegotiationBuffer) {
+		return;
+	}
+	mNegotiationLine += mNegotiationBuffer.str();
+	mNegotiationBuffer.str("");
+
+	//The codecs are offered as a block of "ICAN <codec>" lines, which we collect and replace.
+	std::string::size_type pos;
+	while ((pos = mNegotiationLine.find('\n')) != std::string::npos) {
+		auto line = mNegotiationLine.substr(0, pos);
+		mNegotiationLine.erase(0, pos + 1);
+		if (line.compare(0, 5, "ICAN ") == 0) {
+			mOfferedCodecs.push_back(line.substr(5));
+			continue;
+		}
+		if (!mOfferedCodecs.empty()) {
+			auto codecs = orderCodecs(mOfferedCodecs, mCodecPreference);
+			for (auto& codec : codecs) {
+				mWriteBuffer.sputn("ICAN ", 5);
+				mWriteBuffer.sputn(codec.data(), static_cast<std::streamsize>(codec.size()));
+				mWriteBuffer.sputc('\n');
+			}
+			mOfferedCodecs.clear();
+		}
+		mWriteBuffer.sputn(line.data(), static_cast<std::streamsize>(line.size()));
+		mWriteBuffer.sputc('\n');
+	}
+}
+
+void StreamSocket::decodeReceived() {
+	if (mReceivedDataHandler) {
+		std::string data;
+		auto buffer = mInStream.rdbuf();
+		std::streamsize count;
+		while ((count = buffer->in_avail()) > 0) {
+			auto offset = data.size();
+			data.resize(offset + static_cast<std::size_t>(count));
+			data.resize(offset + static_cast<std::size_t>(buffer->sgetn(&data[offset], count)));
+		}
+		if (!data.empty()) {
+			mReceivedDataHandler(std::move(data));
+		}
+	} else {
+		m_codec->poll();
+	}
+}
+
+std::size_t StreamSocket::getQueuedBytes() const {
+	return mWriteBuffer.size();
+}
+
+void StreamSocket::setWriteWatermarks(std::size_t high, std::size_t low) {
+	mHighWatermark = high;
+	mLowWatermark = std::min(low, high);
+	updateCongestion();
+}
+
+bool StreamSocket::isCongested() const {
+	return mIsCongested;
+}
+
+void StreamSocket::updateCongestion() {
+	auto queued = mWriteBuffer.size();
+	if (!mIsCongested && queued >= mHighWatermark) {
+		mIsCongested = true;
+	} else if (mIsCongested && queued <= mLowWatermark) {
+		mIsCongested = false;
+	} else {
+		return;
+	}
+	if (_callbacks.congestionChanged) {
+		_callbacks.congestionChanged(mIsCongested);
+	}
+}
+
 }
@@ -19,6 +19,9 @@
 #ifndef STREAMSOCKET_H_
 #define STREAMSOCKET_H_
 
+#include "SegmentBuffer.h"
+#include "RingBuffer.h"
+
 #include <Atlas/Objects/ObjectsFwd.h>
 #include <Atlas/Negotiate.h>
 
@@ -27,6 +30,12 @@
 #include <boost/noncopyable.hpp>
 
 #include <memory>
+#include <functional>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdint>
 
 namespace Atlas
 {
@@ -45,6 +54,10 @@ class ObjectsEncoder;
 namespace Eris
 {
 
+class StreamCompression;
+class ResolverCache;
+class CaptureWriter;
+
 /**
  * @brief Handles the internal socket instance, interacting with the asynchronous io_service calls.
  *
@@ -70,6 +83,18 @@ public:
         DISCONNECTING ///< clean disconnection in progress
     } Status;
 
+    /**
+     * @brief Counters for the traffic on the socket.
+     */
+    struct Statistics
+    {
+        std::uint64_t readSyscalls = 0; ///< number of reads made on the socket, including the ones which didn't find any data
+        std::uint64_t bytesRead = 0; ///< number of bytes received
+        std::uint64_t readBatches = 0; ///< number of times received data has been decoded and dispatched
+        std::uint64_t writes = 0; ///< number of writes started on the socket
+        std::uint64_t bytesWritten = 0; ///< number of bytes sent
+    };
+
     /**
      * @brief Methods that are used as callbacks.
      */
@@ -84,6 +109,12 @@ public:
          * @brief Called when the internal state has changed.
          */
         std::function<void(Status)> stateChanged;
+
+        /**
+         * @brief Called when the amount of queued outgoing data rises above the high watermark (true),
+         * or falls back below the low watermark (false).
+         */
+        std::function<void(bool)> congestionChanged;
     };
 
     StreamSocket(boost::asio::io_service& io_service,
@@ -97,7 +128,7 @@ public:
      *
      * Call this when the owner instance is destroyed, or you otherwise don't want any callbacks.
      */
-    void detach();
+    virtual void detach();
 
     /**
      * @brief Gets the codec object.
@@ -117,30 +148,102 @@ public:
      * @brief Send any unsent data.
      */
     virtual void write() = 0;
+
+    /**
+     * @brief Gets counters for the traffic on this socket.
+     */
+    const Statistics& getStatistics() const;
+
+    /**
+     * @brief Gets the number of bytes queued for sending.
+     */
+    std::size_t getQueuedBytes() const;
+
+    /**
+     * @brief Sets the limits used to determine whether too much outgoing data is queued.
+     *
+     * The socket is considered congested once the queued data reaches the high watermark, and
+     * stays congested until it falls to the low watermark.
+     * @param high The high watermark, in bytes.
+     * @param low The low watermark, in bytes.
+     */
+    void setWriteWatermarks(std::size_t high, std::size_t low);
+
+    /**
+     * @brief Returns true if the amount of queued outgoing data has reached the high watermark, and not yet fallen to the low one.
+     */
+    bool isCongested() const;
+
+    /**
+     * @brief Checks the amount of queued outgoing data against the watermarks, calling the congestionChanged callback if needed.
+     */
+    void updateCongestion();
+
+    /**
+     * @brief Sets a compression layer which will be put between the socket and the codec once the Atlas negotiation has completed.
+     *
+     * Since this isn't part of the Atlas negotiation, both ends of the connection must have agreed on it beforehand.
+     * Must be called before connecting.
+     */
+    void setCompression(std::shared_ptr<StreamCompression> compression);
+
+    /**
+     * @brief Sets a handler which receives all incoming data once connected, instead of the codec.
+     *
+     * This allows the data to be decoded elsewhere, for example in a background thread.
+     * The dispatch callback is still called after each read.
+     * @param handler A handler, or an empty function to let the codec decode the data again.
+     */
+    void setReceivedDataHandler(std::function<void(std::string)> handler);
+
+    /**
+     * @brief Sets the codecs to offer during the Atlas negotiation, in order of preference.
+     *
+     * Codecs not in the list aren't offered to the server. Names are matched against the names used in the
+     * negotiation, ignoring any version suffix (i.e. "Bach" matches "Bach_beta2").
+     * Must be called before connecting.
+     * @param codecs Codec names, such as "Packed", "Bach" or "XML". An empty list offers all codecs.
+     */
+    void setCodecPreference(std::vector<std::string> codecs);
+
+    /**
+     * @brief Filters and orders the codecs offered in the negotiation according to a preference list.
+     *
+     * If none of the offered codecs are preferred, all of them are kept, as the negotiation would otherwise fail.
+     * @param offered The codecs supported by Atlas, as sent in the negotiation.
+     * @param preference Codec names in order of preference.
+     * @return The codecs to offer.
+     */
+    static std::vector<std::string> orderCodecs(const std::vector<std::string>& offered, const std::vector<std::string>& preference);
+
+    /**
+     * @brief Records all data received on the socket, as it arrives, for later replay.
+     * @param capture A capture file, or null to stop capturing.
+     */
+    void setCapture(std::shared_ptr<CaptureWriter> capture);
 protected:
     enum
     {
-        read_buffer_size = 2048
+        /**
+         * The max number of bytes read from the socket before the data is decoded and dispatched.
+         */
+        read_burst_limit = 1024 * 1024
     };
     Atlas::Bridge& _bridge;
     Callbacks _callbacks;
 
     /**
      * Buffer used to write data to be sent.
-     * Swapped with mSendBuffer once data is being sent.
+     * While an async_write is in progress the data at the start of the buffer is being sent, and
+     * should not be consumed until the write completes. New data can however still be appended.
      */
-    std::unique_ptr<boost::asio::streambuf> mWriteBuffer;
-
-    /**
-     * Buffer of data which is being sent. This should not be touched until
-     * the async_write call completes.
-     */
-    std::unique_ptr<boost::asio::streambuf> mSendBuffer;
+    SegmentBuffer mWriteBuffer;
 
     /**
      * Buffer for data being read from the socket.
+     * Its size adapts to the amount of data received in each burst.
      */
-    boost::asio::streambuf mReadBuffer;
+    RingBuffer mReadBuffer;
 
     /**
      * Stream for data being received.
@@ -158,7 +261,7 @@ protected:
     bool mShouldSend;
 
     /**
-     * True if we're currently sending through an async_write (and thus shouldn't touch mSendBuffer).
+     * True if we're currently sending through an async_write (and thus shouldn't consume from mWriteBuffer).
      */
     bool mIsSending;
 
@@ -169,11 +272,57 @@ protected:
     std::unique_ptr<Atlas::Objects::ObjectsEncoder> m_encoder;
     bool m_is_connected;
 
+    std::shared_ptr<StreamCompression> mCompression;
+
+    /**
+     * Buffers put between the streams and the socket buffers when compression is used.
+     */
+    std::unique_ptr<std::streambuf> mCompressor;
+    std::unique_ptr<std::streambuf> mDecompressor;
+
+    std::function<void(std::string)> mReceivedDataHandler;
+
+    std::vector<std::string> mCodecPreference;
+
+    /**
+     * Receives the negotiation output if there's a codec preference, so that the offered codecs can be altered.
+     */
+    std::stringbuf mNegotiationBuffer;
+
+    /**
+     * Negotiation output which hasn't yet been written to the write buffer: an incomplete line, and codecs offered so far.
+     */
+    std::string mNegotiationLine;
+    std::vector<std::string> mOfferedCodecs;
+
+    std::shared_ptr<CaptureWriter> mCapture;
+
+    Statistics mStatistics;
+
+    std::size_t mHighWatermark;
+    std::size_t mLowWatermark;
+    bool mIsCongested;
+
     virtual void do_read() = 0;
     virtual void negotiate_read() = 0;
     void startNegotiation();
     Atlas::Negotiate::State negotiate();
 
+    /**
+     * @brief Makes data which has been read into space prepared in the read buffer available, capturing it if needed.
+     */
+    void commitReceived(std::size_t length);
+
+    /**
+     * @brief Moves output from the negotiation to the write buffer, applying the codec preference.
+     */
+    void transferNegotiationOutput();
+
+    /**
+     * @brief Decodes all received data, or passes it on to the received data handler if there is one.
+     */
+    void decodeReceived();
+
 };
 
 /**
@@ -193,23 +342,90 @@ public:
 protected:
     typename ProtocolT::socket m_socket;
     void negotiate_read() override;
-    void negotiate_write();
     void do_read() override;
+
+    /**
+     * @brief Reads all data which is immediately available from the socket, without blocking.
+     * @return The number of bytes read.
+     */
+    std::size_t drain();
 };
 
 /**
  * @brief Template specialization which uses boost::asio sockets with resolvers (i.e. TCP and UDP, but not domain sockets).
+ *
+ * If the host resolves to more than one address, connection attempts are made to all of them in the manner of
+ * "Happy Eyeballs" (RFC 8305): the attempts are started one after another with a short delay, alternating between
+ * address families, and the first one to succeed is used while the rest are cancelled.
  */
 template<typename ProtocolT>
 class ResolvableAsioStreamSocket: public AsioStreamSocket<ProtocolT>
 {
 public:
+
+    /**
+     * @brief The outcome of an attempt to connect to one of the resolved addresses.
+     */
+    struct ConnectAttempt
+    {
+        typename ProtocolT::endpoint endpoint;
+        std::chrono::steady_clock::duration duration; ///< time from starting the attempt until it succeeded, failed or was cancelled
+        boost::system::error_code error; ///< empty if the attempt succeeded, operation_aborted if it was cancelled
+    };
+
     ResolvableAsioStreamSocket(boost::asio::io_service& io_service,
             const std::string& client_name, Atlas::Bridge& bridge,
             StreamSocket::Callbacks callbacks);
     void connectWithQuery(const typename ProtocolT::resolver::query& query);
+
+    /**
+     * @brief Connects to the first of the endpoints which accepts the connection.
+     * @param endpoints Endpoints to try, in order of preference.
+     */
+    void connect(const std::vector<typename ProtocolT::endpoint>& endpoints);
+    using AsioStreamSocket<ProtocolT>::connect;
+
+    /**
+     * @brief Gets the outcome of the attempts made during the last connect, in the order they finished.
+     */
+    const std::vector<ConnectAttempt>& getConnectAttempts() const;
+
+    /**
+     * @brief Orders endpoints so that address families alternate, keeping the order within each family.
+     */
+    static std::vector<typename ProtocolT::endpoint> interleaveAddressFamilies(const std::vector<typename ProtocolT::endpoint>& endpoints);
 protected:
-    typename ProtocolT::resolver m_resolver;
+    struct PendingAttempt
+    {
+        typename ProtocolT::socket socket;
+        typename ProtocolT::endpoint endpoint;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+     * Host names are looked up through the cache shared by all sockets.
+     */
+    ResolverCache& m_resolverCache;
+
+    /**
+     * Endpoints to connect to, and the index of the next one to try.
+     */
+    std::vector<typename ProtocolT::endpoint> mEndpoints;
+    std::size_t mNextEndpoint;
+
+    std::vector<std::shared_ptr<PendingAttempt>> mPendingAttempts;
+    std::vector<ConnectAttempt> mConnectAttempts;
+
+    /**
+     * Timer for starting the next attempt if the ongoing ones haven't completed.
+     */
+    boost::asio::steady_timer mAttemptTimer;
+
+    void startNextAttempt();
+
+    void attemptCompleted(const std::shared_ptr<PendingAttempt>& attempt, boost::system::error_code ec);
+
+    void cancelAttempts();
 };
 
 }
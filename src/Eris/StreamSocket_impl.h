@@ -24,10 +24,15 @@
 #endif
 
 #include "StreamSocket.h"
+#include "Exceptions.h"
+#include "ResolverCache.h"
 
 #include <Atlas/Codec.h>
 
+#include <algorithm>
+
 static const int CONNECT_TIMEOUT_SECONDS = 5;
+static const int CONNECT_ATTEMPT_DELAY_MILLISECONDS = 250;
 
 namespace Eris
 {
@@ -71,7 +76,9 @@ ResolvableAsioStreamSocket<ProtocolT>::ResolvableAsioStreamSocket(
         boost::asio::io_service& io_service, const std::string& client_name,
         Atlas::Bridge& bridge, StreamSocket::Callbacks callbacks) :
         AsioStreamSocket<ProtocolT>(io_service, client_name, bridge, std::move(callbacks)),
-        m_resolver(io_service)
+        m_resolverCache(boost::asio::use_service<ResolverCache>(io_service)),
+        mNextEndpoint(0),
+        mAttemptTimer(io_service)
 {
 }
 
@@ -82,11 +89,11 @@ void ResolvableAsioStreamSocket<ProtocolT>::connectWithQuery(
         const typename ProtocolT::resolver::query& query)
 {
     auto self(this->shared_from_this());
-    m_resolver.async_resolve(query,
-            [&, self](const boost::system::error_code& ec, typename ProtocolT::resolver::iterator iterator) {
+    m_resolverCache.template resolve<ProtocolT>(query.host_name(), query.service_name(),
+            [this, self](const boost::system::error_code& ec, const std::vector<typename ProtocolT::endpoint>& endpoints) {
                 if (this->_callbacks.stateChanged) {
-                    if (!ec && iterator != typename ProtocolT::resolver::iterator()) {
-                        this->connect(*iterator);
+                    if (!ec && !endpoints.empty()) {
+                        this->connect(interleaveAddressFamilies(endpoints));
                     } else {
                         this->_callbacks.stateChanged(StreamSocket::CONNECTING_FAILED);
                     }
@@ -94,6 +101,144 @@ void ResolvableAsioStreamSocket<ProtocolT>::connectWithQuery(
             });
 }
 
+template<typename ProtocolT>
+std::vector<typename ProtocolT::endpoint> ResolvableAsioStreamSocket<ProtocolT>::interleaveAddressFamilies(
+        const std::vector<typename ProtocolT::endpoint>& endpoints)
+{
+    //The resolver returns the addresses in order of preference, so we start with the family of the first one.
+    std::vector<typename ProtocolT::endpoint> first, second;
+    for (auto& endpoint : endpoints) {
+        if (endpoint.protocol().family() == endpoints.front().protocol().family()) {
+            first.push_back(endpoint);
+        } else {
+            second.push_back(endpoint);
+        }
+    }
+    std::vector<typename ProtocolT::endpoint> result;
+    for (std::size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+        if (i < first.size()) {
+            result.push_back(first[i]);
+        }
+        if (i < second.size()) {
+            result.push_back(second[i]);
+        }
+    }
+    return result;
+}
+
+template<typename ProtocolT>
+const std::vector<typename ResolvableAsioStreamSocket<ProtocolT>::ConnectAttempt>& ResolvableAsioStreamSocket<ProtocolT>::getConnectAttempts() const
+{
+    return mConnectAttempts;
+}
+
+template<typename ProtocolT>
+void ResolvableAsioStreamSocket<ProtocolT>::connect(
+        const std::vector<typename ProtocolT::endpoint>& endpoints)
+{
+    if (endpoints.empty()) {
+        this->_callbacks.stateChanged(StreamSocket::CONNECTING_FAILED);
+        return;
+    }
+    mEndpoints = endpoints;
+    mNextEndpoint = 0;
+    mConnectAttempts.clear();
+
+    this->_connectTimer.expires_from_now(
+            std::chrono::seconds(CONNECT_TIMEOUT_SECONDS));
+    auto self(this->shared_from_this());
+    this->_connectTimer.async_wait([this, self](boost::system::error_code ec) {
+        if (!ec) {
+            this->cancelAttempts();
+            if (this->_callbacks.stateChanged) {
+                this->_callbacks.stateChanged(StreamSocket::CONNECTING_TIMEOUT);
+            }
+        }
+    });
+
+    startNextAttempt();
+}
+
+template<typename ProtocolT>
+void ResolvableAsioStreamSocket<ProtocolT>::startNextAttempt()
+{
+    if (mNextEndpoint >= mEndpoints.size()) {
+        return;
+    }
+    auto attempt = std::make_shared<PendingAttempt>(PendingAttempt{typename ProtocolT::socket(this->m_socket.get_executor()),
+                                                                   mEndpoints[mNextEndpoint++],
+                                                                   std::chrono::steady_clock::now()});
+    mPendingAttempts.push_back(attempt);
+    auto self(this->shared_from_this());
+    attempt->socket.async_connect(attempt->endpoint, [this, self, attempt](boost::system::error_code ec) {
+        this->attemptCompleted(attempt, ec);
+    });
+
+    //Give the attempt a head start before trying the next address.
+    if (mNextEndpoint < mEndpoints.size()) {
+        mAttemptTimer.expires_from_now(std::chrono::milliseconds(CONNECT_ATTEMPT_DELAY_MILLISECONDS));
+        mAttemptTimer.async_wait([this, self](boost::system::error_code timerEc) {
+            if (!timerEc && this->_callbacks.stateChanged) {
+                this->startNextAttempt();
+            }
+        });
+    }
+}
+
+template<typename ProtocolT>
+void ResolvableAsioStreamSocket<ProtocolT>::attemptCompleted(const std::shared_ptr<PendingAttempt>& attempt, boost::system::error_code ec)
+{
+    auto I = std::find(mPendingAttempts.begin(), mPendingAttempts.end(), attempt);
+    if (I == mPendingAttempts.end()) {
+        //Already cancelled.
+        return;
+    }
+    mPendingAttempts.erase(I);
+    auto duration = std::chrono::steady_clock::now() - attempt->start;
+    mConnectAttempts.push_back(ConnectAttempt{attempt->endpoint, duration, ec});
+    debug() << "Connection attempt to " << attempt->endpoint << (ec ? " failed" : " succeeded") << " after "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << " ms.";
+
+    if (!this->_callbacks.stateChanged) {
+        cancelAttempts();
+        return;
+    }
+
+    if (!ec) {
+        //We have a winner; the other attempts aren't needed anymore.
+        cancelAttempts();
+        this->_connectTimer.cancel();
+        this->m_socket = std::move(attempt->socket);
+        this->m_is_connected = true;
+        //Needed for draining the socket without blocking when reading.
+        this->m_socket.non_blocking(true, ec);
+        this->startNegotiation();
+    } else {
+        //Don't wait for the delay to pass before trying the next address.
+        if (mNextEndpoint < mEndpoints.size()) {
+            mAttemptTimer.cancel();
+            startNextAttempt();
+        } else if (mPendingAttempts.empty()) {
+            this->_connectTimer.cancel();
+            this->_callbacks.stateChanged(StreamSocket::CONNECTING_FAILED);
+        }
+    }
+}
+
+template<typename ProtocolT>
+void ResolvableAsioStreamSocket<ProtocolT>::cancelAttempts()
+{
+    mAttemptTimer.cancel();
+    mNextEndpoint = mEndpoints.size();
+    for (auto& attempt : mPendingAttempts) {
+        mConnectAttempts.push_back(ConnectAttempt{attempt->endpoint, std::chrono::steady_clock::now() - attempt->start,
+                                                  boost::asio::error::operation_aborted});
+        boost::system::error_code ec;
+        attempt->socket.close(ec);
+    }
+    mPendingAttempts.clear();
+}
+
 template<typename ProtocolT>
 void AsioStreamSocket<ProtocolT>::connect(
         const typename ProtocolT::endpoint& endpoint)
@@ -115,6 +260,8 @@ void AsioStreamSocket<ProtocolT>::connect(
                     if (!ec) {
                         this->_connectTimer.cancel();
                         m_is_connected = true;
+                        //Needed for draining the socket without blocking when reading.
+                        m_socket.non_blocking(true, ec);
                         this->startNegotiation();
                     } else {
                         _callbacks.stateChanged(CONNECTING_FAILED);
@@ -127,13 +274,15 @@ template<typename ProtocolT>
 void AsioStreamSocket<ProtocolT>::negotiate_read()
 {
     auto self(this->shared_from_this());
-    m_socket.async_read_some(mReadBuffer.prepare(read_buffer_size),
+    m_socket.async_read_some(mReadBuffer.prepare(mReadBuffer.getReadSize()),
             [this, self](boost::system::error_code ec, std::size_t length)
             {
                 if (_callbacks.stateChanged) {
                     if (!ec)
                     {
-                        mReadBuffer.commit(length);
+                        this->commitReceived(length);
+                        mStatistics.readSyscalls++;
+                        mStatistics.bytesRead += length;
                         if (length > 0) {
                             auto negotiateResult = this->negotiate();
                             if (negotiateResult == Atlas::Negotiate::FAILED) {
@@ -148,7 +297,7 @@ void AsioStreamSocket<ProtocolT>::negotiate_read()
                             this->write();
                             this->do_read();
                         } else {
-                            this->negotiate_write();
+                            this->write();
                             this->negotiate_read();
                         }
                     } else {
@@ -166,14 +315,29 @@ template<typename ProtocolT>
 void AsioStreamSocket<ProtocolT>::do_read()
 {
     auto self(this->shared_from_this());
-    m_socket.async_read_some(mReadBuffer.prepare(read_buffer_size),
+    m_socket.async_read_some(mReadBuffer.prepare(mReadBuffer.getReadSize()),
             [this, self](boost::system::error_code ec, std::size_t length)
             {
                 if (_callbacks.stateChanged) {
                     if (!ec)
                     {
-                        mReadBuffer.commit(length);
-                        m_codec->poll();
+                        this->commitReceived(length);
+                        mStatistics.readSyscalls++;
+                        //Pick up anything else which has already arrived, so that a large burst of data
+                        //is decoded and dispatched in one go instead of one chunk at a time.
+                        auto burst = length + this->drain();
+                        mStatistics.bytesRead += burst;
+                        mStatistics.readBatches++;
+                        mReadBuffer.recordBurst(burst);
+                        try {
+                            this->decodeReceived();
+                        } catch (const NetworkFailure& e) {
+                            //Thrown if the data can't be decompressed.
+                            error() << "Error when decoding data from socket: " << e.what();
+                            m_socket.close();
+                            _callbacks.stateChanged(CONNECTION_FAILED);
+                            return;
+                        }
                         _callbacks.dispatch();
                         this->do_read();
                     } else {
@@ -187,10 +351,31 @@ void AsioStreamSocket<ProtocolT>::do_read()
             });
 }
 
+template<typename ProtocolT>
+std::size_t AsioStreamSocket<ProtocolT>::drain()
+{
+    std::size_t total = 0;
+    boost::system::error_code ec;
+    //The socket is in non-blocking mode, so this stops as soon as there's nothing more to read.
+    while (!ec && total < read_burst_limit) {
+        auto length = m_socket.read_some(mReadBuffer.prepare(mReadBuffer.getReadSize()), ec);
+        mStatistics.readSyscalls++;
+        this->commitReceived(length);
+        total += length;
+    }
+    //Any error other than "would block" will be reported by the next asynchronous read.
+    return total;
+}
+
 template<typename ProtocolT>
 void AsioStreamSocket<ProtocolT>::write()
 {
-    if (mWriteBuffer->size() != 0) {
+    //Make sure that any data held by the compressor is written to the buffer.
+    if (mCompressor) {
+        mOutStream.flush();
+    }
+    this->updateCongestion();
+    if (mWriteBuffer.size() != 0) {
         if (mIsSending) {
             //We're already sending in the background.
             //Make that we should send again once we've completed sending.
@@ -202,16 +387,18 @@ void AsioStreamSocket<ProtocolT>::write()
 
         //We'll use a self reference to make sure that the client isn't deleted while sending.
         auto self(this->shared_from_this());
-        //Swap places between writing buffer and sending buffer, and attach new write buffer to the out stream.
-        std::swap(mWriteBuffer, mSendBuffer);
-        mOutStream.rdbuf(mWriteBuffer.get());
         mIsSending = true;
 
-        async_write(m_socket, mSendBuffer->data(),
+        //Send the whole chain of blocks in one gathered write. Any data written while this is in progress
+        //is appended to the end of the chain, and will be sent once this write has completed.
+        mStatistics.writes++;
+        boost::asio::async_write(m_socket, mWriteBuffer.data(),
             [this, self](boost::system::error_code ec, std::size_t length)
             {
-                mSendBuffer->consume(length);
+                mWriteBuffer.consume(length);
+                mStatistics.bytesWritten += length;
                 mIsSending = false;
+                this->updateCongestion();
                 if (!ec) {
                     //Is there data queued for transmission which we should send right away?
                     if (mShouldSend) {
@@ -231,25 +418,6 @@ void AsioStreamSocket<ProtocolT>::write()
 
 }
 
-template<typename ProtocolT>
-void AsioStreamSocket<ProtocolT>::negotiate_write()
-{
-
-    if (mWriteBuffer->size() != 0) {
-        auto self(this->shared_from_this());
-        boost::asio::async_write(m_socket, mWriteBuffer->data(),
-                [this, self](boost::system::error_code ec, std::size_t length)
-                {
-                    if (!ec)
-                    {
-                        this->mWriteBuffer->consume(length);
-                    } else {
-                        warning() << "Error when writing to socket while negotiating: (" << ec << ") " << ec.message();
-                    }
-                });
-    }
-}
-
 }
 
 #endif /* STREAMSOCKET_IMPL_H_ */
@@ -25,7 +25,8 @@ TypeInfo::TypeInfo(std::string id, TypeService &ts) :
     m_parent(nullptr),
     m_bound(false),
     m_name(std::move(id)),
-    m_typeService(ts)
+    m_typeService(ts),
+    m_properties(ts.getPropertyNames())
 {
     if (m_name == "root") {
 		m_bound = true; // root node is always bound
@@ -36,7 +37,8 @@ TypeInfo::TypeInfo(const Root &atype, TypeService &ts) :
     m_parent(nullptr),
     m_bound(false),
     m_name(atype->getId()),
-    m_typeService(ts)
+    m_typeService(ts),
+    m_properties(ts.getPropertyNames())
 {
     if (m_name == "root") {
         m_bound = true; // root node is always bound
@@ -146,6 +148,7 @@ void TypeInfo::processTypeData(const Root &atype)
         //For already bound types we'll extract the properties and check if any changed.
 
         auto oldProperties = std::move(m_properties);
+        m_propertiesMap = boost::none;
 
 		extractDefaultProperties(atype);
 
@@ -251,6 +254,7 @@ void TypeInfo::extractDefaultProperties(const Atlas::Objects::Root& atype)
             warning() << "'properties' element is not of map type when processing entity type " << m_name << ".";
         } else {
 			m_properties = propertiesElement.Map();
+			m_propertiesMap = boost::none;
         }
     }
 }
@@ -277,12 +281,19 @@ const Atlas::Message::Element* TypeInfo::getProperty(const std::string& property
 void TypeInfo::setProperty(const std::string& propertyName, const Atlas::Message::Element& element)
 {
     onPropertyChanges(propertyName, element);
-    auto I = m_properties.find(propertyName);
-    if (I == m_properties.end()) {
-		m_properties.insert(Atlas::Message::MapType::value_type(propertyName, element));
-    } else {
-        I->second = element;
+    m_properties[propertyName] = element;
+    m_propertiesMap = boost::none;
+}
+
+const Atlas::Message::MapType& TypeInfo::getProperties() const
+{
+    if (!m_propertiesMap) {
+        m_propertiesMap.emplace();
+        for (auto& entry : m_properties) {
+            m_propertiesMap->emplace(entry.first, entry.second);
+        }
     }
+    return *m_propertiesMap;
 }
 
 void TypeInfo::onPropertyChanges(const std::string& propertyName, const Atlas::Message::Element& element)
@@ -290,7 +301,7 @@ void TypeInfo::onPropertyChanges(const std::string& propertyName, const Atlas::M
     PropertyChanges.emit(propertyName, element);
     ///Now go through all children, and only make them emit the event if they themselves doesn't have an property by this name (which thus overrides this).
     for (auto child : getChildren()) {
-        Atlas::Message::MapType::const_iterator J = child->m_properties.find(propertyName);
+        auto J = child->m_properties.find(propertyName);
         if (J == child->m_properties.end()) {
 			child->onPropertyChanges(propertyName, element);
         }
@@ -2,12 +2,16 @@
 #define ERIS_TYPE_INFO_H
 
 #include "Types.h"
+#include "PropertyTable.h"
+
 #include <Atlas/Message/Element.h>
 #include <Atlas/Objects/Root.h>
 
 #include <sigc++/trackable.h>
 #include <sigc++/signal.h>
 
+#include <boost/optional.hpp>
+
 #include <map>
 #include <string>
 
@@ -94,10 +98,19 @@ public:
     /**
     @brief Gets the default properties for this entity type.
     Note that the map returned does not include inherited properties.
+    The properties are kept in a PropertyTable, from which the map is built the first time it's asked for
+    after the properties have changed. The reference is valid until the properties next change.
     @returns An element map of the default properties for this type.
     */
     const Atlas::Message::MapType& getProperties() const;
 
+    /**
+    @brief Gets the table holding the default properties for this entity type.
+    Note that the table returned does not include inherited properties, and isn't in name order.
+    @returns A table of the default properties for this type.
+    */
+    const PropertyTable& getPropertyTable() const;
+
     /**
      * @brief Gets the value of the named property.
      * This method will search through both this instance and all of its parents for the property by the specified name. If no property can be found a null pointer will be returned.
@@ -195,7 +208,12 @@ private:
     /** 
      * @brief The default properties specified for this entity type.
      */
-    Atlas::Message::MapType m_properties;
+    PropertyTable m_properties;
+
+    /**
+     * @brief The map returned by getProperties(), built from m_properties when asked for.
+     */
+    mutable boost::optional<Atlas::Message::MapType> m_propertiesMap;
 
 	/*
 	 * @brief If the type is an archetype, the entities will be defined here.
@@ -204,7 +222,7 @@ private:
 
 };
 
-inline const Atlas::Message::MapType& TypeInfo::getProperties() const
+inline const PropertyTable& TypeInfo::getPropertyTable() const
 {
     return m_properties;
 }
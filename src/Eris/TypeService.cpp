@@ -17,6 +17,8 @@
 #include <Atlas/Objects/RootOperation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
+
 using namespace Atlas::Objects::Operation;
 using Atlas::Objects::Root;
 using Atlas::Objects::Entity::RootEntity;
@@ -26,23 +28,46 @@ using Atlas::Objects::smart_dynamic_cast;
 namespace Eris
 {
 
+namespace {
+/**
+ * Class numbers are assigned in sequence as classes are registered, so they should stay well below this.
+ */
+const std::size_t maxCachedClassNo = 1024;
+
+/**
+ * Counts the objects an op consists of: the op itself, and its args, including those of args which are ops.
+ */
+std::size_t countObjects(const RootOperation& op)
+{
+    std::size_t objects = 1;
+    for (auto& arg : op->getArgs()) {
+        auto argOp = smart_dynamic_cast<RootOperation>(arg);
+        objects += argOp ? countObjects(argOp) : 1;
+    }
+    return objects;
+}
+}
+
 TypeService::TypeService(Connection &con) :
     m_con(con),
-    m_inited(false)
+    m_inited(false),
+    m_waitingObjectsLimit(16384)
 {
     defineBuiltin("root", nullptr);
+    BoundType.connect(sigc::mem_fun(*this, &TypeService::redispatchWaitingOps));
 }
 
 TypeService::~TypeService() = default;
 
 void TypeService::init()
 {
-    assert(!m_inited);
     m_inited = true;
 	
     // every type already in the map delayed it's sendInfoRequest because we weren't inited;
     // go through and fix them now. This allows static construction (or early construction) of
     // things like ClassDispatchers in a moderately controlled fashion.
+    // When called again after a reconnect the types bound through the earlier connection are kept,
+    // and only the requests lost with it are sent again.
     for (auto& type : m_types) {
         if (!type.second->isBound()) sendRequest(type.second->getName());
     }
@@ -82,7 +107,24 @@ TypeInfo* TypeService::getTypeForAtlas(const Root &obj)
         return getTypeByName("root");
     }
 
-    return getTypeByName(obj->getParent());
+    auto classNo = obj->getClassNo();
+    std::size_t index = classNo >= 0 ? static_cast<std::size_t>(classNo) : maxCachedClassNo;
+    if (index < m_typesByClassNo.size()) {
+        auto type = m_typesByClassNo[index];
+        if (type && type->getName() == obj->getParent()) {
+            return type;
+        }
+    }
+
+    auto type = getTypeByName(obj->getParent());
+    // only bound types are cached, since unbound ones can be removed if the server doesn't know them
+    if (type->isBound() && index < maxCachedClassNo) {
+        if (index >= m_typesByClassNo.size()) {
+            m_typesByClassNo.resize(index + 1, nullptr);
+        }
+        m_typesByClassNo[index] = type;
+    }
+    return type;
 }
 
 void TypeService::handleOperation(const RootOperation& op)
@@ -187,13 +229,20 @@ void TypeService::recvError(const Get& get)
 
 			warning() << "type " << request->getId() << " undefined on server";
 			BadType.emit(T->second.get());
+			dropWaitingOps(T->second.get());
 
-			m_types.erase(T);
+			eraseType(T);
 
     	}
     }
 }
 
+void TypeService::eraseType(std::unordered_map<std::string, std::unique_ptr<TypeInfo>>::iterator I)
+{
+    std::replace(m_typesByClassNo.begin(), m_typesByClassNo.end(), I->second.get(), static_cast<TypeInfo*>(nullptr));
+    m_types.erase(I);
+}
+
 TypeInfo* TypeService::defineBuiltin(const std::string& name, TypeInfo* parent)
 {
     assert(m_types.count(name) == 0);
@@ -214,4 +263,54 @@ void TypeService::setTypeProviderId(std::string id) {
     m_type_provider_id = std::move(id);
 }
 
+void TypeService::redispatchWhenBound(TypeInfo* type, const RootOperation& op) {
+    auto objects = countObjects(op);
+    if (m_waitingOpsStatistics.objects + objects > m_waitingObjectsLimit) {
+        warning() << "too many ops waiting for types to be bound, dropping op waiting for " << type->getName();
+        m_waitingOpsStatistics.dropped++;
+        return;
+    }
+    m_waitingOps[type].push_back(WaitingOp{op, objects});
+    m_waitingOpsStatistics.ops++;
+    m_waitingOpsStatistics.objects += objects;
+    m_waitingOpsStatistics.peakObjects = std::max(m_waitingOpsStatistics.peakObjects, m_waitingOpsStatistics.objects);
+}
+
+void TypeService::setWaitingObjectsLimit(std::size_t maxObjects) {
+    m_waitingObjectsLimit = maxObjects;
+}
+
+TypeService::WaitingOpsStatistics TypeService::getWaitingOpsStatistics() const {
+    return m_waitingOpsStatistics;
+}
+
+void TypeService::redispatchWaitingOps(TypeInfo* type) {
+    auto I = m_waitingOps.find(type);
+    if (I == m_waitingOps.end()) {
+        return;
+    }
+    auto waiting = std::move(I->second);
+    m_waitingOps.erase(I);
+    for (auto& entry : waiting) {
+        m_waitingOpsStatistics.ops--;
+        m_waitingOpsStatistics.objects -= entry.objects;
+        m_waitingOpsStatistics.redispatched++;
+        m_con.postForDispatch(entry.op);
+    }
+}
+
+void TypeService::dropWaitingOps(TypeInfo* type) {
+    auto I = m_waitingOps.find(type);
+    if (I == m_waitingOps.end()) {
+        return;
+    }
+    warning() << "dropping " << I->second.size() << " ops waiting for bad type " << type->getName();
+    for (auto& entry : I->second) {
+        m_waitingOpsStatistics.ops--;
+        m_waitingOpsStatistics.objects -= entry.objects;
+        m_waitingOpsStatistics.dropped++;
+    }
+    m_waitingOps.erase(I);
+}
+
 } // of namespace Eris
@@ -1,15 +1,20 @@
 #ifndef ERIS_TYPE_SERVICE_H
 #define ERIS_TYPE_SERVICE_H
 
+#include "IdInterner.h"
+
 #include <Atlas/Objects/ObjectsFwd.h>
+#include <Atlas/Objects/RootOperation.h>
 
 #include <sigc++/trackable.h>
 #include <sigc++/signal.h>
 
 #include <unordered_map>
+#include <vector>
 #include <set>
 #include <string>
 #include <memory>
+#include <cstdint>
 
 namespace Eris {
 
@@ -63,6 +68,42 @@ public:
      */
     void setTypeProviderId(std::string id);
 
+    /**
+     * @brief Holds an op which can't be handled until the type is bound, and posts it for dispatch again once it is.
+     *
+     * The ops waiting for each type are kept in a list, which is posted all at once, in the order the ops
+     * arrived, when the type is bound. If the type turns out to be undefined the ops are dropped. To bound the
+     * memory used, ops are also dropped if the number of objects all waiting ops consist of would exceed the limit.
+     */
+    void redispatchWhenBound(TypeInfo* type, const Atlas::Objects::Operation::RootOperation& op);
+
+    /**
+     * @brief Sets the largest number of objects which all ops waiting for types may consist of. Defaults to 16384.
+     *
+     * Each op counts as one object, plus its args, including the args of args which are ops. The objects
+     * are counted rather than measured, since measuring them would mean copying them into messages.
+     */
+    void setWaitingObjectsLimit(std::size_t maxObjects);
+
+    /**
+     * @brief Describes the ops waiting for types to be bound.
+     */
+    struct WaitingOpsStatistics
+    {
+        std::size_t ops = 0; ///< number of ops waiting
+        std::size_t objects = 0; ///< number of objects the ops waiting consist of
+        std::size_t peakObjects = 0; ///< the highest number of objects waiting at once
+        std::uint64_t redispatched = 0; ///< number of ops posted again once their type was bound
+        std::uint64_t dropped = 0; ///< number of ops dropped because of the limit, or because their type was undefined
+    };
+
+    WaitingOpsStatistics getWaitingOpsStatistics() const;
+
+    /**
+     * @brief Gets the names of the properties of entities and types, which their property tables refer to.
+     */
+    IdInterner& getPropertyNames();
+
 protected:
 
     void recvTypeInfo(const Atlas::Objects::Root &atype);
@@ -71,6 +112,11 @@ protected:
 
     TypeInfo* defineBuiltin(const std::string& name, TypeInfo* parent);
 
+    /**
+     * Declared before the types, so that it outlives their property tables.
+     */
+    IdInterner m_propertyNames;
+
     /** The easy bit : a simple map from 'string-id' (e.g 'look' or 'farmer')
     to the corresponding TypeInfo instance. This could be a hash_map in the
     future, if efficiency considerations indicate it would be worthwhile */
@@ -83,8 +129,43 @@ protected:
      * An optional type provider, to which requests for types are sent.
      */
     std::string m_type_provider_id;
+
+    /**
+     * Bound types resolved by getTypeForAtlas(), indexed by the Atlas class number of the objects.
+     * Objects of a generic class can have any parent, so the name of an entry is checked before it's used.
+     */
+    std::vector<TypeInfo*> m_typesByClassNo;
+
+    struct WaitingOp
+    {
+        Atlas::Objects::Operation::RootOperation op;
+        std::size_t objects;
+    };
+
+    /**
+     * The ops waiting for each unbound type, in the order they arrived.
+     */
+    std::unordered_map<TypeInfo*, std::vector<WaitingOp>> m_waitingOps;
+
+    std::size_t m_waitingObjectsLimit;
+
+    WaitingOpsStatistics m_waitingOpsStatistics;
+
+    void redispatchWaitingOps(TypeInfo* type);
+
+    void dropWaitingOps(TypeInfo* type);
+
+    /**
+     * Removes a type, along with any entries for it in m_typesByClassNo.
+     */
+    void eraseType(std::unordered_map<std::string, std::unique_ptr<TypeInfo>>::iterator I);
 };
 
+inline IdInterner& TypeService::getPropertyNames()
+{
+    return m_propertyNames;
+}
+
 } // of namespace Eris
 
 #endif // of ERIS_TYPE_SERVICE_H
@@ -0,0 +1,186 @@
+#ifndef ERIS_URINGSTREAMSOCKET_H
+#define ERIS_URINGSTREAMSOCKET_H
+
+#include "StreamSocket_impl.h"
+#include "IoUringService.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace Eris
+{
+
+/**
+ * @brief A stream socket which does its reads and writes through io_uring once connected.
+ *
+ * Connecting and the Atlas negotiation are still done through boost::asio, as these only happen once per connection.
+ * Once negotiated, the socket is put in blocking mode (which io_uring requires to be able to wait for data) and all
+ * further traffic goes through the IoUringService of the io_service.
+ *
+ * @tparam BaseT Either AsioStreamSocket or ResolvableAsioStreamSocket.
+ */
+template<typename BaseT>
+class UringStreamSocket : public BaseT
+{
+public:
+    UringStreamSocket(boost::asio::io_service& io_service,
+            const std::string& client_name, Atlas::Bridge& bridge,
+            StreamSocket::Callbacks callbacks);
+    void write() override;
+
+    /**
+     * @brief Detaches the callbacks, and cancels the reads and writes in flight.
+     *
+     * These hold a reference to the socket until they complete, which a read won't do until the server
+     * sends something or closes the connection.
+     */
+    void detach() override;
+protected:
+    IoUringService& mService;
+
+    /**
+     * True once the socket has been switched over to io_uring.
+     */
+    bool mUsingUring;
+
+    /**
+     * The number of bytes submitted in the ongoing write.
+     */
+    std::size_t mWriteSize;
+
+    void do_read() override;
+
+    void switchToUring();
+};
+
+template<typename BaseT>
+UringStreamSocket<BaseT>::UringStreamSocket(
+        boost::asio::io_service& io_service, const std::string& client_name,
+        Atlas::Bridge& bridge, StreamSocket::Callbacks callbacks) :
+        BaseT(io_service, client_name, bridge, std::move(callbacks)),
+        mService(boost::asio::use_service<IoUringService>(io_service)),
+        mUsingUring(false),
+        mWriteSize(0)
+{
+}
+
+template<typename BaseT>
+void UringStreamSocket<BaseT>::switchToUring()
+{
+    if (!mUsingUring) {
+        mUsingUring = true;
+        boost::system::error_code ec;
+        this->m_socket.non_blocking(false, ec);
+        this->m_socket.native_non_blocking(false, ec);
+        if (ec) {
+            warning() << "Could not put socket in blocking mode: " << ec.message();
+        }
+    }
+}
+
+template<typename BaseT>
+void UringStreamSocket<BaseT>::detach()
+{
+    BaseT::detach();
+    if (mUsingUring) {
+        mService.cancel(this->m_socket.native_handle());
+    }
+}
+
+template<typename BaseT>
+void UringStreamSocket<BaseT>::do_read()
+{
+    //This is first called when negotiation has completed.
+    switchToUring();
+    auto self(this->shared_from_this());
+    auto fallback = this->mReadBuffer.prepare(this->mReadBuffer.getReadSize())[0];
+    mService.asyncRead(this->m_socket.native_handle(), fallback,
+            [this, self, fallback](int result, const char* data)
+            {
+                if (this->_callbacks.stateChanged) {
+                    if (result > 0)
+                    {
+                        auto length = static_cast<std::size_t>(result);
+                        //If the data ended up in one of the registered buffers it needs to be copied over.
+                        if (data != fallback.data()) {
+                            boost::asio::buffer_copy(this->mReadBuffer.prepare(length), boost::asio::buffer(data, length));
+                        }
+                        this->commitReceived(length);
+                        this->mStatistics.readSyscalls++;
+                        this->mStatistics.bytesRead += length;
+                        this->mStatistics.readBatches++;
+                        this->mReadBuffer.recordBurst(length);
+                        try {
+                            this->decodeReceived();
+                        } catch (const NetworkFailure& e) {
+                            //Thrown if the data can't be decompressed.
+                            error() << "Error when decoding data from socket: " << e.what();
+                            this->m_socket.close();
+                            this->_callbacks.stateChanged(StreamSocket::CONNECTION_FAILED);
+                            return;
+                        }
+                        this->_callbacks.dispatch();
+                        this->do_read();
+                    } else {
+                        if (result != -ECANCELED) {
+                            this->_callbacks.stateChanged(StreamSocket::CONNECTION_FAILED);
+                        } else {
+                            warning() << "Error when reading from socket: " << std::strerror(-result);
+                        }
+                    }
+                }
+            });
+}
+
+template<typename BaseT>
+void UringStreamSocket<BaseT>::write()
+{
+    //During negotiation the socket is still handled by asio.
+    if (!mUsingUring) {
+        BaseT::write();
+        return;
+    }
+    //Make sure that any data held by the compressor is written to the buffer.
+    if (this->mCompressor) {
+        this->mOutStream.flush();
+    }
+    this->updateCongestion();
+    if (this->mWriteBuffer.size() != 0) {
+        if (this->mIsSending) {
+            this->mShouldSend = true;
+            return;
+        }
+
+        this->mShouldSend = false;
+
+        auto self(this->shared_from_this());
+        this->mIsSending = true;
+        this->mStatistics.writes++;
+        mWriteSize = mService.asyncWrite(this->m_socket.native_handle(), this->mWriteBuffer.data(),
+            [this, self](int result)
+            {
+                this->mIsSending = false;
+                if (result >= 0) {
+                    this->mWriteBuffer.consume(static_cast<std::size_t>(result));
+                    this->mStatistics.bytesWritten += static_cast<std::size_t>(result);
+                    this->updateCongestion();
+                    //Unlike asio::async_write a single write might not send everything, in which case we continue with the rest.
+                    if (this->mShouldSend || static_cast<std::size_t>(result) < mWriteSize) {
+                        this->write();
+                    }
+                } else {
+                    if (result != -ECANCELED) {
+                        if (this->_callbacks.stateChanged) {
+                            this->_callbacks.stateChanged(StreamSocket::CONNECTION_FAILED);
+                        }
+                    } else {
+                        warning() << "Error when writing to socket: " << std::strerror(-result);
+                    }
+                }
+            });
+    }
+}
+
+}
+
+#endif //ERIS_URINGSTREAMSOCKET_H
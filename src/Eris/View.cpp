@@ -36,6 +36,14 @@ View::~View() {
 		deleteEntity(m_topLevel->getId());
 	}
 
+	auto& interner = getConnection().getIdInterner();
+	for (IdInterner::Handle handle = 0; handle < m_entitiesByHandle.size(); ++handle) {
+		if (m_entitiesByHandle[handle]) {
+			interner.release(handle);
+		}
+	}
+	m_entitiesByHandle.clear();
+
 	//To avoid having callbacks into the View when deleting children we first move all of them to a temporary copy
 	//and then destroy that.
 	auto contents = std::move(m_contents);
@@ -51,6 +59,13 @@ ViewEntity* View::getEntity(const std::string& eid) const {
 	return E->second.entity.get();
 }
 
+ViewEntity* View::getEntity(IdInterner::Handle handle) const {
+	if (handle >= m_entitiesByHandle.size()) {
+		return nullptr;
+	}
+	return m_entitiesByHandle[handle];
+}
+
 void View::registerFactory(std::unique_ptr<Factory> f) {
 	m_factories.insert(std::move(f));
 }
@@ -88,6 +103,11 @@ double View::getSimulationSpeed() const {
 
 void View::update() {
 
+	if (!m_stale.empty() && m_resyncDeadline != std::chrono::steady_clock::time_point() &&
+		std::chrono::steady_clock::now() > m_resyncDeadline) {
+		expireStaleEntities();
+	}
+
 	auto pruned = pruneAbandonedPendingEntities();
 	for (size_t i = 0; i < pruned; ++i) {
 		issueQueuedLook();
@@ -153,7 +173,9 @@ void View::appear(const std::string& eid, double stamp) {
 		ent->m_recentlyCreated = false;
 	}
 
-	if (ent->isVisible()) return;
+	//An entity kept through a reconnect is only looked at again if it has changed since.
+	bool wasStale = m_stale.erase(eid) != 0;
+	if (ent->isVisible() && !wasStale) return;
 
 	if ((stamp == 0) || (stamp > ent->getStamp())) {
 		if (isPending(eid)) {
@@ -177,7 +199,7 @@ void View::disappear(const std::string& eid) {
 			//debug() << "got disappearance for pending " << eid;
 			m_pending[eid].sightAction = SightAction::DISCARD;
 		} else {
-			warning() << "got disappear for unknown entity " << eid;
+			ERIS_WARNING_LIMITED() << "got disappear for unknown entity " << eid;
 		}
 	}
 }
@@ -219,6 +241,7 @@ void View::sight(const RootEntity& gent) {
 	auto* ent = getEntity(eid);
 	if (ent) {
 		// existing entity, update in place
+		m_stale.erase(eid);
 		ent->firstSight(gent);
 	} else {
 		ent = initialSight(gent);
@@ -248,6 +271,11 @@ ViewEntity* View::initialSight(const RootEntity& gent) {
 	auto I = m_contents.emplace(gent->getId(), EntityEntry{std::move(entity), std::move(router)});
 	auto& insertedEntry = I.first->second;
 	auto insertedEntity = insertedEntry.entity.get();
+	auto handle = getConnection().getIdInterner().intern(gent->getId());
+	if (handle >= m_entitiesByHandle.size()) {
+		m_entitiesByHandle.resize(handle + 1, nullptr);
+	}
+	m_entitiesByHandle[handle] = insertedEntity;
 	insertedEntity->init(gent, false);
 
 	InitialSightEntity.emit(insertedEntity);
@@ -296,6 +324,12 @@ void View::deleteEntity(const std::string& eid) {
 		entity->BeingDeleted.emit();
 		//We need to delete all children too.
 		auto children = I->second.entity->getContent();
+		auto& interner = getConnection().getIdInterner();
+		auto handle = interner.find(eid);
+		if (handle < m_entitiesByHandle.size() && m_entitiesByHandle[handle]) {
+			m_entitiesByHandle[handle] = nullptr;
+			interner.release(handle);
+		}
 		m_contents.erase(I);
 		for (auto& child : children) {
 			deleteEntity(child->getId());
@@ -452,6 +486,47 @@ void View::issueQueuedLook() {
 	sendLookAt(eid);
 }
 
+void View::markEntitiesStale() {
+	for (auto& entry : m_contents) {
+		m_stale.insert(entry.first);
+	}
+	m_resyncDeadline = {};
+}
+
+void View::resynchronise(std::chrono::steady_clock::duration gracePeriod) {
+	//Any looks sent through the old connection won't be answered; send them again.
+	auto pending = std::move(m_pending);
+	m_pending.clear();
+	m_lookQueue.clear();
+
+	//Start by requesting general entity data from the server, and then the avatar entity, as when first taking the avatar.
+	getEntityFromServer("");
+	getEntityFromServer(m_owner.getEntityId());
+	for (auto& entry : pending) {
+		if (entry.second.sightAction != SightAction::DISCARD) {
+			getEntityFromServer(entry.first);
+		}
+	}
+
+	m_resyncDeadline = std::chrono::steady_clock::now() + gracePeriod;
+}
+
+void View::expireStaleEntities() {
+	auto stale = std::move(m_stale);
+	m_stale.clear();
+	m_resyncDeadline = {};
+	for (auto& eid : stale) {
+		auto entity = getEntity(eid);
+		//The avatar entity and the entities containing it are looked at directly, and are never expired.
+		if (!entity || entity == m_owner.getEntity() ||
+			(m_owner.getEntity() && entity->isAncestorTo(*m_owner.getEntity()))) {
+			continue;
+		}
+		debug() << "Entity " << eid << " wasn't seen again after reconnecting, deleting it.";
+		deleteEntity(eid);
+	}
+}
+
 void View::dumpLookQueue() {
 	debug() << "look queue:";
 	for (const auto& lookOp : m_lookQueue) {
@@ -4,6 +4,7 @@
 // WF
 #include "Factory.h"
 #include "ViewEntity.h"
+#include "IdInterner.h"
 #include <Atlas/Objects/ObjectsFwd.h>
 #include <wfmath/timestamp.h>
 
@@ -19,9 +20,11 @@
 #include <map>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <Atlas/Message/Element.h>
 #include <memory>
 #include <chrono>
+#include <vector>
 
 namespace Eris
 {
@@ -49,6 +52,12 @@ public:
     */
     ViewEntity* getEntity(const std::string& eid) const;
 
+    /**
+    Retrieve an entity in the view by its id, as interned in the IdInterner of the
+    connection. Returns nullptr if no such entity exists in the view.
+    */
+    ViewEntity* getEntity(IdInterner::Handle handle) const;
+
     Avatar& getAvatar() const
     {
         return m_owner;
@@ -175,6 +184,19 @@ protected:
     are submitted to this method.
     */
     void taskRateChanged(Task*);
+
+    /**
+    Called when the connection has been lost, but the session is to be resumed. The
+    entities are kept, but are stale until the server has confirmed them again.
+    */
+    void markEntitiesStale();
+
+    /**
+    Called once the avatar has been taken over again after a reconnect. Entities whose
+    stamps haven't changed are kept as they are, while changed ones are looked at again.
+    Entities which haven't been seen again within the grace period are deleted.
+    */
+    void resynchronise(std::chrono::steady_clock::duration gracePeriod = std::chrono::seconds(10));
 private:
     ViewEntity* initialSight(const Atlas::Objects::Entity::RootEntity& ge);
 
@@ -204,6 +226,12 @@ private:
 		std::unique_ptr<EntityRouter> entityRouter;
     };
 	std::unordered_map<std::string, EntityEntry> m_contents;
+
+	/**
+	 * The entities in m_contents, indexed by the handles of their ids. Each entity holds a reference to
+	 * its interned id.
+	 */
+	std::vector<ViewEntity*> m_entitiesByHandle;
 	Entity* m_topLevel; ///< the top-level visible entity for this view
     WFMath::TimeStamp m_lastUpdateTime;
 
@@ -267,6 +295,18 @@ private:
     FactoryStore m_factories;
     
     std::set<Task*> m_progressingTasks;
+
+    /**
+    Entities kept through a reconnect, which the server hasn't confirmed yet.
+    */
+    std::unordered_set<std::string> m_stale;
+
+    /**
+    When the entities still stale should be deleted, if resynchronising.
+    */
+    std::chrono::steady_clock::time_point m_resyncDeadline;
+
+    void expireStaleEntities();
 };
 
 } // of namespace Eris
@@ -28,6 +28,7 @@ DEALINGS IN THE SOFTWARE.
 #define WAITFREEQUEUE_H_
 
 #include <atomic>
+#include <utility>
 
 namespace Eris
 {
@@ -61,6 +62,17 @@ public:
                 std::memory_order_release));
     }
 
+    void push(T&& data)
+    {
+        node* n = new node;
+        n->data = std::move(data);
+        node * stale_head = _head.load(std::memory_order_relaxed);
+        do {
+            n->next = stale_head;
+        } while (!_head.compare_exchange_weak(stale_head, n,
+                std::memory_order_release));
+    }
+
     node* pop_all(void)
     {
         node* last = pop_all_reverse(), *first = nullptr;
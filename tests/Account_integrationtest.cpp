@@ -137,6 +137,19 @@ public:
 		return netDisconnecting();
 	}
 
+	void test_netReconnecting() {
+		netReconnecting();
+	}
+
+	void test_resumeAvatars() {
+		resumeAvatars();
+	}
+
+	std::int64_t query_getResumeSerial() const {
+		assert(m_resumeRequests.size() == 1);
+		return m_resumeRequests.begin()->first;
+	}
+
 	void test_netFailure(const std::string& msg) {
 		netFailure(msg);
 	}
@@ -1092,6 +1105,72 @@ int main() {
 		acc.setup_setStatus(TestAccount::DISCONNECTED);
 	}
 
+	// Test netReconnecting() keeps the avatars, which are resumed once possessed again.
+	{
+		TestConnection con("name", "localhost",
+												 6767);
+
+		TestAccount acc(con);
+		acc.setup_insertActiveCharacters(std::make_unique<TestAvatar>(&acc, "2", "1"));
+		acc.setup_setStatus(TestAccount::LOGGED_IN);
+
+		acc.test_netReconnecting();
+		assert(acc.query_getStatus() == TestAccount::DISCONNECTED);
+		assert(acc.getActiveCharacters().size() == 1);
+
+		acc.test_resumeAvatars();
+		assert(acc.query_getStatus() == TestAccount::TAKING_CHAR);
+
+		Atlas::Objects::Operation::Info op;
+		Atlas::Objects::Entity::Anonymous info_arg;
+		Atlas::Objects::Entity::Anonymous entity_arg;
+		info_arg->setId("2");
+		entity_arg->setId("1");
+		info_arg->setAttr("entity", entity_arg->asMessage());
+		op->setArgs1(info_arg);
+		op->setRefno(acc.query_getResumeSerial());
+		SignalFlagger avatarSuccess_checker;
+		SignalFlagger avatarResumed_checker;
+		acc.AvatarSuccess.connect(sigc::hide(sigc::mem_fun(avatarSuccess_checker,
+														   &SignalFlagger::set)));
+		acc.AvatarResumed.connect(sigc::hide(sigc::mem_fun(avatarResumed_checker,
+														   &SignalFlagger::set)));
+
+		acc.test_avatarResponse(op);
+		assert(avatarResumed_checker.flagged());
+		assert(!avatarSuccess_checker.flagged());
+		assert(acc.query_getStatus() == TestAccount::LOGGED_IN);
+		assert(acc.getActiveCharacters().size() == 1);
+
+		acc.setup_setStatus(TestAccount::DISCONNECTED);
+	}
+
+	// Test that an avatar which can't be possessed again after reconnecting is removed.
+	{
+		TestConnection con("name", "localhost",
+												 6767);
+
+		TestAccount acc(con);
+		acc.setup_insertActiveCharacters(std::make_unique<TestAvatar>(&acc, "2", "1"));
+		acc.setup_setStatus(TestAccount::LOGGED_IN);
+
+		acc.test_netReconnecting();
+		acc.test_resumeAvatars();
+
+		Atlas::Objects::Operation::Error op;
+		op->setRefno(acc.query_getResumeSerial());
+		SignalFlagger avatarFailure_checker;
+		acc.AvatarFailure.connect(sigc::hide(sigc::mem_fun(avatarFailure_checker,
+														   &SignalFlagger::set)));
+
+		acc.test_avatarResponse(op);
+		assert(!avatarFailure_checker.flagged());
+		assert(acc.getActiveCharacters().empty());
+		assert(acc.query_getStatus() == TestAccount::LOGGED_IN);
+
+		acc.setup_setStatus(TestAccount::DISCONNECTED);
+	}
+
 	// Test netFailure()
 	{
 		TestConnection con("name", "localhost",
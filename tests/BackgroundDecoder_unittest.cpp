@@ -0,0 +1,128 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/BackgroundDecoder.h"
+#include "Eris/EventService.h"
+
+#include <Atlas/Codecs/Bach.h>
+#include <Atlas/Message/MEncoder.h>
+#include <Atlas/Message/QueuedDecoder.h>
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <cassert>
+
+using namespace Eris;
+using Atlas::Message::MapType;
+
+int main()
+{
+	boost::asio::io_service io_service;
+
+	//Encode some messages with the Bach codec.
+	std::stringstream encoded;
+	{
+		Atlas::Message::QueuedDecoder dummyBridge;
+		Atlas::Codecs::Bach codec(encoded, encoded, dummyBridge);
+		Atlas::Message::Encoder encoder(codec);
+		codec.streamBegin();
+		for (int i = 0; i < 100; ++i) {
+			encoder.streamMessageElement(MapType{{"objtype", "op"}, {"parent", "sight"}, {"serialno", i}});
+		}
+	}
+	auto data = encoded.str();
+
+	//A factory should be found for the codecs created by the Atlas negotiation.
+	{
+		Atlas::Message::QueuedDecoder dummyBridge;
+		std::stringstream stream;
+		Atlas::Codecs::Bach codec(stream, stream, dummyBridge);
+		assert(BackgroundDecoder::getFactoryFor(codec));
+	}
+
+	//Messages should be decoded in the background and delivered in order on the main thread, even when split up.
+	{
+		Eris::EventService eventService(io_service);
+		std::vector<MapType> received;
+		std::thread::id handlerThread;
+		BackgroundDecoder decoder(eventService,
+								  [](std::istream& in, std::ostream& out, Atlas::Bridge& bridge) -> std::unique_ptr<Atlas::Codec> {
+									  return std::make_unique<Atlas::Codecs::Bach>(in, out, bridge);
+								  },
+								  [&](std::vector<MapType> messages) {
+									  handlerThread = std::this_thread::get_id();
+									  for (auto& message : messages) {
+										  received.push_back(std::move(message));
+									  }
+								  });
+
+		for (std::size_t i = 0; i < data.size(); i += 37) {
+			decoder.push(data.substr(i, 37));
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (received.size() < 100 && std::chrono::steady_clock::now() < deadline) {
+			eventService.processAllHandlers();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		assert(received.size() == 100);
+		assert(handlerThread == std::this_thread::get_id());
+		for (int i = 0; i < 100; ++i) {
+			assert(received[i]["serialno"] == i);
+			assert(received[i]["parent"] == "sight");
+		}
+	}
+
+	//Handlers shouldn't be called once the decoder has been destroyed.
+	{
+		Eris::EventService eventService(io_service);
+		bool called = false;
+		{
+			BackgroundDecoder decoder(eventService,
+									  [](std::istream& in, std::ostream& out, Atlas::Bridge& bridge) -> std::unique_ptr<Atlas::Codec> {
+										  return std::make_unique<Atlas::Codecs::Bach>(in, out, bridge);
+									  },
+									  [&](std::vector<MapType>) { called = true; });
+			decoder.push(data);
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		eventService.processAllHandlers();
+		assert(!called);
+	}
+
+	//The decoder should be stoppable from within its handler, after which no more messages are handed to it.
+	{
+		Eris::EventService eventService(io_service);
+		std::size_t calls = 0;
+		std::unique_ptr<BackgroundDecoder> decoder;
+		decoder = std::make_unique<BackgroundDecoder>(eventService,
+													  [](std::istream& in, std::ostream& out, Atlas::Bridge& bridge) -> std::unique_ptr<Atlas::Codec> {
+														  return std::make_unique<Atlas::Codecs::Bach>(in, out, bridge);
+													  },
+													  [&](std::vector<MapType>) {
+														  ++calls;
+														  decoder->stop();
+													  });
+		for (std::size_t i = 0; i < data.size(); i += 37) {
+			decoder->push(data.substr(i, 37));
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (calls == 0 && std::chrono::steady_clock::now() < deadline) {
+			eventService.processAllHandlers();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		eventService.processAllHandlers();
+		assert(calls == 1);
+		decoder.reset();
+	}
+
+	return 0;
+}
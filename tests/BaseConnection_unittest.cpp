@@ -37,6 +37,7 @@
 #include <Atlas/Objects/Encoder.h>
 
 #include <iostream>
+#include <vector>
 
 #include <cassert>
 
@@ -46,6 +47,17 @@ public:
 : Eris::StreamSocket(io_service, client_name, bridge, callbacks)
 {}
     virtual void write(){}
+
+    void test_queue(const std::string& data) {
+        mOutStream << data;
+        updateCongestion();
+    }
+
+    void test_sent(std::size_t length) {
+        mWriteBuffer.data();
+        mWriteBuffer.consume(length);
+        updateCongestion();
+    }
 protected:
     virtual void do_read(){}
     virtual void negotiate_read(){}
@@ -322,5 +334,26 @@ int main()
         assert(tbc.timeout);
     }
 
+    // Test congestion reporting with watermarks
+    {
+        Atlas::Message::QueuedDecoder bridge;
+        std::vector<bool> changes;
+        Eris::StreamSocket::Callbacks callbacks;
+        callbacks.congestionChanged = [&](bool congested) { changes.push_back(congested); };
+        TestStreamClientSocketBase socket(io_service, "", bridge, callbacks);
+        socket.setWriteWatermarks(100, 20);
+
+        socket.test_queue(std::string(99, 'x'));
+        assert(!socket.isCongested());
+        assert(socket.getQueuedBytes() == 99);
+        socket.test_queue("x");
+        assert(socket.isCongested());
+        socket.test_sent(50);
+        assert(socket.isCongested());
+        socket.test_sent(30);
+        assert(!socket.isCongested());
+        assert(changes.size() == 2 && changes[0] && !changes[1]);
+    }
+
     return 0;
 }
@@ -0,0 +1,91 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/Capture.h"
+#include "Eris/Exceptions.h"
+
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+using namespace Eris;
+
+int main()
+{
+	std::string path = "Capture_unittest.capture";
+
+	//Records should be read back as written, with increasing timestamps.
+	{
+		auto before = std::chrono::system_clock::now();
+		{
+			CaptureWriter writer(path);
+			writer.record(boost::asio::buffer(std::string("ATLAS server\n")));
+			std::string first("IWILL ");
+			std::string second("Packed\n\n");
+			writer.record(std::array<boost::asio::const_buffer, 2>{{boost::asio::buffer(first), boost::asio::buffer(second)}});
+			assert(writer.getRecordCount() == 2);
+		}
+
+		CaptureReader reader(path);
+		assert(reader.getStartTime() >= before - std::chrono::seconds(1));
+		assert(reader.getStartTime() <= std::chrono::system_clock::now());
+
+		CaptureReader::Record record{};
+		assert(reader.next(record));
+		assert(std::string(record.data, record.size) == "ATLAS server\n");
+		auto firstTime = record.time;
+		assert(reader.next(record));
+		assert(std::string(record.data, record.size) == "IWILL Packed\n\n");
+		assert(record.time >= firstTime);
+		assert(!reader.next(record));
+
+		reader.rewind();
+		assert(reader.next(record));
+		assert(std::string(record.data, record.size) == "ATLAS server\n");
+	}
+
+	//A truncated record at the end should be ignored.
+	{
+		{
+			CaptureWriter writer(path);
+			writer.record(boost::asio::buffer(std::string("complete")));
+			writer.record(boost::asio::buffer(std::string("truncated")));
+		}
+		std::ifstream in(path, std::ios::binary);
+		std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		in.close();
+		{
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			out.write(contents.data(), static_cast<std::streamsize>(contents.size() - 3));
+		}
+
+		CaptureReader reader(path);
+		CaptureReader::Record record{};
+		assert(reader.next(record));
+		assert(std::string(record.data, record.size) == "complete");
+		assert(!reader.next(record));
+	}
+
+	//Other files should be rejected.
+	{
+		{
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			out << "This is not a capture file, even though it's long enough.";
+		}
+		bool threw = false;
+		try {
+			CaptureReader reader(path);
+		} catch (const BaseException&) {
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	std::remove(path.c_str());
+	return 0;
+}
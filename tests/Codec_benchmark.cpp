@@ -0,0 +1,182 @@
+// Compares the Atlas codecs on the kind of traffic Eris receives most: sights of entities, sights of Set ops
+// for entities moving around, and Appearance ops. For each codec it reports the number of bytes on the wire,
+// and the time and number of allocations needed to decode each op into objects, the way Connection does.
+
+#include <Atlas/Codecs/Bach.h>
+#include <Atlas/Codecs/Packed.h>
+#include <Atlas/Codecs/XML.h>
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Decoder.h>
+#include <Atlas/Objects/Encoder.h>
+#include <Atlas/Objects/Factories.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::atomic<std::size_t> allocationCount(0);
+}
+
+void* operator new(std::size_t size)
+{
+	allocationCount++;
+	if (void* ptr = std::malloc(size ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+using Atlas::Objects::Root;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Message::ListType;
+
+namespace {
+
+const int opCount = 10000;
+const int iterations = 5;
+
+/**
+ * Does the same as the decoder used by Connection, minus the dispatching.
+ */
+struct CountingDecoder : Atlas::Objects::ObjectsDecoder
+{
+	std::size_t count = 0;
+
+	explicit CountingDecoder(const Atlas::Objects::Factories& factories) : ObjectsDecoder(factories)
+	{
+	}
+
+	void objectArrived(Root obj) override
+	{
+		count++;
+	}
+};
+
+std::vector<Root> makeOps()
+{
+	std::vector<Root> ops;
+	for (int i = 0; i < opCount; ++i) {
+		auto id = std::to_string(100 + i % 500);
+		switch (i % 4) {
+			case 0: {
+				//An entity coming into view.
+				Anonymous entity;
+				entity->setId(id);
+				entity->setParent("oak");
+				entity->setLoc("0");
+				entity->setStamp(1000 + i);
+				entity->setAttr("pos", ListType{(i * 7919) % 1000 * 0.5, 0.0, (i * 104729) % 1000 * 0.25});
+				entity->setAttr("orientation", ListType{0.0, 0.7, 0.0, 0.7});
+				entity->setAttr("bbox", ListType{-1.0, 0.0, -1.0, 1.0, 8.5, 1.0});
+				entity->setAttr("mode", "planted");
+				entity->setName("oak tree");
+				Atlas::Objects::Operation::Sight sight;
+				sight->setArgs1(entity);
+				sight->setTo("1");
+				sight->setSeconds(10.5 + i);
+				ops.push_back(sight);
+				break;
+			}
+			case 1:
+			case 2: {
+				//An entity moving.
+				Anonymous entity;
+				entity->setId(id);
+				entity->setStamp(1000 + i);
+				entity->setAttr("pos", ListType{(i * 31) % 1000 * 0.5, 0.0, (i * 17) % 1000 * 0.25});
+				entity->setAttr("velocity", ListType{1.5, 0.0, -0.5});
+				Atlas::Objects::Operation::Set set;
+				set->setArgs1(entity);
+				set->setFrom(id);
+				Atlas::Objects::Operation::Sight sight;
+				sight->setArgs1(set);
+				sight->setTo("1");
+				sight->setSeconds(10.5 + i);
+				ops.push_back(sight);
+				break;
+			}
+			default: {
+				Anonymous entity;
+				entity->setId(id);
+				entity->setStamp(1000 + i);
+				Atlas::Objects::Operation::Appearance appearance;
+				appearance->setArgs1(entity);
+				appearance->setTo("1");
+				appearance->setSeconds(10.5 + i);
+				ops.push_back(appearance);
+				break;
+			}
+		}
+	}
+	return ops;
+}
+
+template<typename CodecT>
+void run(const std::string& name, const std::vector<Root>& ops, const Atlas::Objects::Factories& factories)
+{
+	std::stringstream encoded;
+	{
+		CountingDecoder dummy(factories);
+		CodecT codec(encoded, encoded, dummy);
+		Atlas::Objects::ObjectsEncoder encoder(codec);
+		codec.streamBegin();
+		for (auto& op : ops) {
+			encoder.streamObjectsMessage(op);
+		}
+	}
+	auto data = encoded.str();
+
+	std::chrono::steady_clock::duration elapsed{};
+	std::size_t allocations = 0;
+	for (int i = 0; i < iterations; ++i) {
+		std::stringstream in(data);
+		std::stringstream out;
+		CountingDecoder decoder(factories);
+		CodecT codec(in, out, decoder);
+
+		auto allocationsBefore = allocationCount.load();
+		auto start = std::chrono::steady_clock::now();
+		codec.poll();
+		elapsed += std::chrono::steady_clock::now() - start;
+		allocations += allocationCount.load() - allocationsBefore;
+
+		if (decoder.count != ops.size()) {
+			std::cerr << name << ": decoded " << decoder.count << " ops, expected " << ops.size() << std::endl;
+		}
+	}
+
+	double decodedOps = static_cast<double>(ops.size()) * iterations;
+	std::cout << name << ": " << data.size() << " bytes (" << static_cast<double>(data.size()) / static_cast<double>(ops.size()) << " per op), "
+			  << std::chrono::duration<double, std::nano>(elapsed).count() / decodedOps << " ns/op, "
+			  << static_cast<double>(allocations) / decodedOps << " allocations/op" << std::endl;
+}
+
+}
+
+int main()
+{
+	Atlas::Objects::Factories factories;
+	auto ops = makeOps();
+
+	run<Atlas::Codecs::Packed>("Packed", ops, factories);
+	run<Atlas::Codecs::Bach>("Bach", ops, factories);
+	run<Atlas::Codecs::XML>("XML", ops, factories);
+	return 0;
+}
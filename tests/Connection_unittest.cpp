@@ -27,12 +27,32 @@
 #include <Eris/Connection.h>
 
 #include <Eris/Log.h>
+#include <Eris/RingBuffer.h>
+#include <Eris/Router.h>
 #include <Eris/EventService.h>
 
+#include <Atlas/Codecs/Packed.h>
+#include <Atlas/Message/DecoderBase.h>
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Root.h>
 #include <Atlas/Objects/SmartPtr.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+using boost::asio::local::stream_protocol;
 
 static void writeLog(Eris::LogLevel, const std::string & msg)
 {       
@@ -53,11 +73,165 @@ class TestConnection : public Eris::Connection {
     		, port) {
     }
 
+    TestConnection(boost::asio::io_service& io_service,
+    		Eris::EventService& eventService,
+    		const std::string &cnm,
+    		const std::string& socket)
+    : Eris::Connection(io_service,
+    		eventService,
+    		cnm,
+    		socket) {
+    }
+
     void testSetStatus(Status sc) { setStatus(sc); }
 
     void testDispatch() { dispatch(); }
+
+    void testPostForDispatch(const Atlas::Objects::Root& obj) { postForDispatch(obj); }
+};
+
+class RecordingRouter : public Eris::Router {
+  public:
+    RouterResult handleOperation(const Atlas::Objects::Operation::RootOperation& op) override {
+        serials.push_back(op->getSerialno());
+        return HANDLED;
+    }
+
+    std::vector<std::int64_t> serials;
+};
+
+struct MessageCollector : Atlas::Message::DecoderBase {
+    void messageArrived(Atlas::Message::MapType obj) override {
+        messages.push_back(std::move(obj));
+    }
+
+    std::vector<Atlas::Message::MapType> messages;
 };
 
+/**
+ * Stands in for a server: accepts one connection on a Unix socket, negotiates, and then decodes what the client sends.
+ */
+class StubServer {
+  public:
+    explicit StubServer(const std::string& path) :
+        m_path(path),
+        m_acceptor(m_io_service, makeEndpoint(path)),
+        m_socket(m_io_service),
+        m_descriptor(-1) {
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~StubServer() {
+        close();
+        m_thread.join();
+        std::remove(m_path.c_str());
+    }
+
+    /**
+     * Closes the connection to the client.
+     */
+    void close() {
+        int descriptor = m_descriptor;
+        if (descriptor != -1) {
+            ::shutdown(descriptor, SHUT_RDWR);
+        }
+    }
+
+    std::vector<Atlas::Message::MapType> getMessages() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_messages;
+    }
+
+    std::size_t getMessageCount() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_messages.size();
+    }
+
+    /**
+     * Runs the client until the server has received the number of messages.
+     */
+    void waitForMessages(boost::asio::io_service& io_service, std::size_t count) {
+        while (getMessageCount() < count) {
+            io_service.poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+  private:
+    std::string m_path;
+    boost::asio::io_service m_io_service;
+    stream_protocol::acceptor m_acceptor;
+    stream_protocol::socket m_socket;
+    std::atomic<int> m_descriptor;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::vector<Atlas::Message::MapType> m_messages;
+
+    static stream_protocol::endpoint makeEndpoint(const std::string& path) {
+        std::remove(path.c_str());
+        return stream_protocol::endpoint(path);
+    }
+
+    void run() {
+        m_acceptor.accept(m_socket);
+        m_descriptor = m_socket.native_handle();
+        boost::system::error_code ec;
+        boost::asio::write(m_socket, boost::asio::buffer(std::string("ATLAS server\n")), ec);
+        boost::asio::streambuf negotiation;
+        auto length = boost::asio::read_until(m_socket, negotiation, "\n\n", ec);
+        if (ec) {
+            return;
+        }
+        std::string offer(boost::asio::buffers_begin(negotiation.data()), boost::asio::buffers_begin(negotiation.data()) + length);
+        negotiation.consume(length);
+        auto codecStart = offer.find("ICAN ") + 5;
+        auto codec = offer.substr(codecStart, offer.find('\n', codecStart) - codecStart);
+        boost::asio::write(m_socket, boost::asio::buffer("IWILL " + codec + "\n\n"), ec);
+
+        Eris::RingBuffer buffer;
+        std::istream in(&buffer);
+        std::ostream out(nullptr);
+        MessageCollector collector;
+        Atlas::Codecs::Packed decoder(in, out, collector);
+        auto feed = [&](boost::asio::const_buffer data) {
+            buffer.commit(boost::asio::buffer_copy(buffer.prepare(data.size()), data));
+            decoder.poll();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& message : collector.messages) {
+                m_messages.push_back(std::move(message));
+            }
+            collector.messages.clear();
+        };
+        feed(negotiation.data());
+
+        std::array<char, 8192> chunk{};
+        while (!ec) {
+            auto read = m_socket.read_some(boost::asio::buffer(chunk), ec);
+            feed(boost::asio::buffer(chunk.data(), read));
+        }
+    }
+};
+
+/**
+ * Connects to a StubServer, running the client until the negotiation is done.
+ */
+static void connectTo(Eris::Connection& c, boost::asio::io_service& io_service) {
+    c.setCodecPreference({"Packed"});
+    c.connect();
+    while (c.getStatus() != Eris::BaseConnection::CONNECTED) {
+        io_service.run_one();
+    }
+    //Let the last writes of the negotiation finish.
+    io_service.poll();
+}
+
+static Atlas::Objects::Operation::RootOperation makeOp(Atlas::Objects::Operation::RootOperation op, const std::string& from, std::int64_t serial)
+{
+    op->setFrom(from);
+    op->setSerialno(serial);
+    return op;
+}
+
 int main()
 {
     Eris::Logged.connect(sigc::ptr_fun(writeLog));
@@ -138,6 +312,54 @@ int main()
         c.testSetStatus(Eris::BaseConnection::DISCONNECTED);
     }
 
+    // A lost connection should be reconnected until that succeeds or disconnect() is called
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        std::string path = "Connection_unittest_reconnect.socket";
+        std::remove(path.c_str());
+        //Nothing listens on the socket, so each attempt fails.
+        TestConnection c(io_service, event_service, "name", path);
+        c.setAutoReconnect(true, std::chrono::milliseconds(1));
+
+        int reconnecting = 0;
+        c.Reconnecting.connect([&]() { reconnecting++; });
+        int attempts = 0;
+        c.StatusChanged.connect([&](Eris::BaseConnection::Status status) {
+            if (status == Eris::BaseConnection::CONNECTING) {
+                attempts++;
+            }
+        });
+
+        c.testSetStatus(Eris::BaseConnection::CONNECTED);
+        c.testSetStatus(Eris::BaseConnection::DISCONNECTED);
+        assert(reconnecting == 1);
+
+        while (attempts < 1) {
+            io_service.run_one();
+        }
+        //An attempt which goes through DISCONNECTING, as when negotiation times out, should be retried too.
+        c.testSetStatus(Eris::BaseConnection::NEGOTIATE);
+        c.testSetStatus(Eris::BaseConnection::DISCONNECTING);
+        c.testSetStatus(Eris::BaseConnection::DISCONNECTED);
+        //The failures of the real attempts should be retried.
+        while (attempts < 4) {
+            io_service.run_one();
+        }
+        //Failed attempts aren't new losses.
+        assert(reconnecting == 1);
+
+        c.disconnect();
+        assert(c.getStatus() == Eris::BaseConnection::DISCONNECTED);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+        while (std::chrono::steady_clock::now() < deadline) {
+            io_service.poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(attempts == 4);
+        assert(c.getStatus() == Eris::BaseConnection::DISCONNECTED);
+    }
+
     // Test dispatch()
     {
         boost::asio::io_service io_service;
@@ -147,8 +369,119 @@ int main()
         c.testDispatch();
     }
 
+    // Test dispatch() with a budget, resumed manually
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        TestConnection c(io_service, event_service, " name", "localhost", 6767);
+
+        Eris::Connection::DispatchBudget budget;
+        budget.ops = 2;
+        c.setDispatchBudget(budget, Eris::Connection::DispatchResume::MANUAL);
+        for (int i = 0; i < 5; ++i) {
+            c.testPostForDispatch(Atlas::Objects::Operation::Get());
+        }
+        c.testDispatch();
+        assert(c.getDispatchQueueStatistics().depth == 3);
+        assert(c.getDispatchQueueStatistics().maxDepth == 5);
+        assert(event_service.processAllHandlers() == 0);
+
+        assert(c.pump(budget) == 2);
+        assert(c.pump(Eris::Connection::DispatchBudget()) == 1);
+        auto statistics = c.getDispatchQueueStatistics();
+        assert(statistics.depth == 0);
+        assert(statistics.oldestAge == std::chrono::steady_clock::duration::zero());
+        assert(statistics.deferrals == 2);
+    }
+
+    // Test dispatch() with a budget, resumed through the EventService
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        TestConnection c(io_service, event_service, " name", "localhost", 6767);
+
+        Eris::Connection::DispatchBudget budget;
+        budget.ops = 2;
+        c.setDispatchBudget(budget);
+        for (int i = 0; i < 5; ++i) {
+            c.testPostForDispatch(Atlas::Objects::Operation::Get());
+        }
+        c.testDispatch();
+        assert(c.getDispatchQueueStatistics().depth == 3);
+        assert(event_service.processOneHandler() == 1);
+        assert(c.getDispatchQueueStatistics().depth == 1);
+        assert(event_service.processAllHandlers() == 1);
+        assert(c.getDispatchQueueStatistics().depth == 0);
+    }
+
+    // Test dispatch lanes
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        TestConnection c(io_service, event_service, " name", "localhost", 6767);
+        RecordingRouter router;
+        c.setDefaultRouter(&router);
+
+        c.setDispatchLanes({Eris::Connection::DispatchLane{"high", 2}, Eris::Connection::DispatchLane{"low", 1}},
+                [](const Atlas::Objects::Operation::RootOperation& op) -> std::size_t {
+                    return op->getClassNo() == Atlas::Objects::Operation::GET_NO ? 0 : 1;
+                });
+        c.testPostForDispatch(makeOp(Atlas::Objects::Operation::Look(), "a", 1));
+        c.testPostForDispatch(makeOp(Atlas::Objects::Operation::Get(), "b", 2));
+        c.testPostForDispatch(makeOp(Atlas::Objects::Operation::Get(), "b", 3));
+        c.testPostForDispatch(makeOp(Atlas::Objects::Operation::Get(), "c", 4));
+        // Has to stay behind the Look from the same entity.
+        c.testPostForDispatch(makeOp(Atlas::Objects::Operation::Get(), "a", 5));
+        c.testDispatch();
+
+        assert((router.serials == std::vector<std::int64_t>{2, 3, 1, 4, 5}));
+        auto lanes = c.getLaneStatistics();
+        assert(lanes.size() == 2);
+        assert(lanes[0].name == "high");
+        assert(lanes[0].dispatched == 3);
+        assert(lanes[1].dispatched == 2);
+        assert(lanes[1].depth == 0);
+        c.clearDefaultRouter();
+    }
+
     // FIXME Not testing all the code paths through gotData()
 
+    // Ids should stay interned while routers are registered for them, and be released after
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        TestConnection c(io_service, event_service, " name", "localhost", 6767);
+        RecordingRouter router;
+        auto& interner = c.getIdInterner();
+
+        c.registerRouterForTo(&router, "1");
+        c.registerRouterForFrom(&router, "1");
+        //Registering again shouldn't add another reference.
+        c.registerRouterForFrom(&router, "1");
+        assert(interner.find("1") != Eris::IdInterner::INVALID_HANDLE);
+        c.unregisterRouterForFrom("1");
+        assert(interner.find("1") != Eris::IdInterner::INVALID_HANDLE);
+        c.unregisterRouterForTo(&router, "1");
+        assert(interner.find("1") == Eris::IdInterner::INVALID_HANDLE);
+        assert(interner.size() == 0);
+
+        //An op queued for a router which has been replaced since should go to the new one.
+        c.registerRouterForTo(&router, "2");
+        Atlas::Objects::Operation::Talk talk;
+        talk->setTo("2");
+        talk->setSerialno(1);
+        c.testPostForDispatch(talk);
+        c.unregisterRouterForTo(&router, "2");
+        RecordingRouter other;
+        c.registerRouterForTo(&other, "3");
+        c.registerRouterForTo(&router, "2");
+        c.testDispatch();
+        assert(router.serials == std::vector<std::int64_t>{1});
+        assert(other.serials.empty());
+        c.unregisterRouterForTo(&router, "2");
+        c.unregisterRouterForTo(&other, "3");
+    }
+
     // Test send()
     {
         boost::asio::io_service io_service;
@@ -159,5 +492,186 @@ int main()
 
         c.send(obj);
     }
+
+    // Test corked send() and flush() when not connected
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        Eris::Connection c(io_service, event_service, " name", "localhost", 6767);
+
+        c.setCorked(true, std::chrono::milliseconds(10));
+
+        Atlas::Objects::Root obj;
+
+        c.send(obj);
+        c.flush();
+        c.setCorked(false);
+
+        auto statistics = c.getIoStatistics();
+        assert(statistics.opsSent == 0);
+        assert(statistics.getOpsPerWrite() == 0);
+        assert(statistics.getWriteSyscallsSaved() == 0);
+    }
+
+    // Corked ops should be held until flushed, and then be written together
+    {
+        std::string path = "Connection_unittest.socket";
+        Eris::setLogLevel(Eris::LOG_WARNING);
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        StubServer server(path);
+        Eris::Connection c(io_service, event_service, "name", path);
+        connectTo(c, io_service);
+        auto messagesBefore = server.getMessageCount();
+
+        //Held until flush() is called, since the max latency won't pass.
+        c.setCorked(true, std::chrono::hours(1));
+        auto writes = c.getIoStatistics().socket.writes;
+        for (int i = 0; i < 3; ++i) {
+            c.send(makeOp(Atlas::Objects::Operation::Talk(), "corked", i + 1));
+        }
+        io_service.poll();
+        assert(c.getIoStatistics().socket.writes == writes);
+        assert(server.getMessageCount() == messagesBefore);
+        c.flush();
+        server.waitForMessages(io_service, messagesBefore + 3);
+        assert(c.getIoStatistics().socket.writes == writes + 1);
+        auto messages = server.getMessages();
+        for (std::size_t i = 0; i < 3; ++i) {
+            assert(messages[messagesBefore + i]["serialno"].Int() == static_cast<Atlas::Message::IntType>(i + 1));
+        }
+
+        //Without a max latency, ops should be written at the end of the turn of the event loop.
+        c.setCorked(true);
+        writes = c.getIoStatistics().socket.writes;
+        c.send(makeOp(Atlas::Objects::Operation::Talk(), "corked", 4));
+        c.send(makeOp(Atlas::Objects::Operation::Talk(), "corked", 5));
+        assert(c.getIoStatistics().socket.writes == writes);
+        server.waitForMessages(io_service, messagesBefore + 5);
+        assert(c.getIoStatistics().socket.writes == writes + 1);
+
+        //With a max latency, ops should be written once it has passed.
+        c.setCorked(true, std::chrono::milliseconds(20));
+        writes = c.getIoStatistics().socket.writes;
+        auto start = std::chrono::steady_clock::now();
+        c.send(makeOp(Atlas::Objects::Operation::Talk(), "corked", 6));
+        c.send(makeOp(Atlas::Objects::Operation::Talk(), "corked", 7));
+        io_service.poll();
+        assert(c.getIoStatistics().socket.writes == writes);
+        server.waitForMessages(io_service, messagesBefore + 7);
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+        assert(c.getIoStatistics().socket.writes == writes + 1);
+
+        c.setCorked(false);
+        c.disconnect();
+    }
+
+    // Test congestion policy when not connected
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        Eris::Connection c(io_service, event_service, " name", "localhost", 6767);
+
+        c.setSendWatermarks(1024, 256);
+        c.setCongestionPolicy(Eris::Connection::CongestionPolicy::REPLACE_SUPERSEDED);
+        assert(!c.isSendCongested());
+        c.setCongestionPolicy(Eris::Connection::CongestionPolicy::QUEUE_ALL);
+        assert(c.getIoStatistics().opsReplaced == 0);
+    }
+
+    // Ops held while congested should be replaced by newer ones about the same thing, which are then sent last
+    {
+        std::string path = "Connection_unittest.socket";
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        StubServer server(path);
+        Eris::Connection c(io_service, event_service, "name", path);
+        connectTo(c, io_service);
+        auto messagesBefore = server.getMessageCount();
+
+        //Keep the first op in the buffer, so that the socket is congested by it.
+        c.setCorked(true, std::chrono::hours(1));
+        c.setSendWatermarks(1, 0);
+        c.setCongestionPolicy(Eris::Connection::CongestionPolicy::REPLACE_SUPERSEDED);
+        auto makeSet = [](const std::string& id, double status) {
+            Atlas::Objects::Entity::Anonymous arg;
+            arg->setId(id);
+            arg->setAttr("status", status);
+            Atlas::Objects::Operation::Set set;
+            set->setFrom("avatar");
+            set->setArgs1(arg);
+            return set;
+        };
+        c.send(makeSet("e1", 0));
+        assert(c.isSendCongested());
+        c.send(makeSet("e1", 1));
+        c.send(makeSet("e2", 1));
+        c.send(makeSet("e1", 2));
+        assert(c.getIoStatistics().opsReplaced == 1);
+
+        c.flush();
+        server.waitForMessages(io_service, messagesBefore + 3);
+        std::vector<std::pair<std::string, double>> received;
+        auto messages = server.getMessages();
+        for (auto I = messages.begin() + messagesBefore; I != messages.end(); ++I) {
+            auto& arg = (*I)["args"].List().front().Map();
+            received.emplace_back(arg.at("id").String(), arg.at("status").Float());
+        }
+        assert((received == std::vector<std::pair<std::string, double>>{{"e1", 0}, {"e2", 1}, {"e1", 2}}));
+        assert(!c.isSendCongested());
+        c.setCorked(false);
+        c.disconnect();
+    }
+
+    // Ops sent from many threads at once should all reach the server, in the order each thread sent them
+    {
+        const std::size_t threadCount = 8;
+        const std::size_t opsPerThread = 500;
+        std::string path = "Connection_unittest.socket";
+        Eris::setLogLevel(Eris::LOG_WARNING);
+
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        StubServer server(path);
+        Eris::Connection c(io_service, event_service, "name", path);
+        connectTo(c, io_service);
+        auto messagesBefore = server.getMessageCount();
+
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threadCount; ++t) {
+            workers.emplace_back([&c, t]() {
+                for (std::size_t i = 0; i < opsPerThread; ++i) {
+                    Atlas::Message::MapType op;
+                    op["objtype"] = "op";
+                    op["parent"] = "talk";
+                    op["from"] = "worker" + std::to_string(t);
+                    op["serialno"] = Eris::getNewSerialno();
+                    c.sendFromAnyThread(std::move(op));
+                }
+            });
+        }
+        server.waitForMessages(io_service, messagesBefore + threadCount * opsPerThread);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        std::map<std::string, std::vector<std::int64_t>> received;
+        for (auto& message : server.getMessages()) {
+            auto I = message.find("from");
+            if (I != message.end() && I->second.isString() && I->second.String().compare(0, 6, "worker") == 0) {
+                received[I->second.String()].push_back(message["serialno"].Int());
+            }
+        }
+        assert(received.size() == threadCount);
+        std::set<std::int64_t> serials;
+        for (auto& entry : received) {
+            assert(entry.second.size() == opsPerThread);
+            //Each thread got its serials in increasing order, so they should arrive in increasing order too.
+            assert(std::is_sorted(entry.second.begin(), entry.second.end()));
+            serials.insert(entry.second.begin(), entry.second.end());
+        }
+        //No serial should have been handed out twice.
+        assert(serials.size() == threadCount * opsPerThread);
+    }
     return 0;
 }
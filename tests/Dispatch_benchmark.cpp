@@ -0,0 +1,232 @@
+// Measures the time needed to dispatch the kinds of ops which make up most of the in-game traffic, from
+// Connection through the IGRouter and EntityRouter into the View and its entities: sights of Set ops for
+// entities moving around, Appearance ops, Sound(Talk) ops and sights of actions, which need their type resolved.
+// The number of heap allocations made while dispatching each op is reported too.
+
+#include <Eris/Account.h>
+#include <Eris/Avatar.h>
+#include <Eris/Connection.h>
+#include <Eris/EventService.h>
+#include <Eris/Factory.h>
+#include <Eris/Log.h>
+#include <Eris/TypeService.h>
+#include <Eris/View.h>
+#include <Eris/ViewEntity.h>
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+std::size_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size)
+{
+	++allocationCount;
+	if (auto ptr = std::malloc(size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+using Atlas::Objects::Root;
+using Atlas::Objects::Entity::Anonymous;
+using Atlas::Objects::Operation::RootOperation;
+
+namespace {
+
+const int entityCount = 100;
+const int opCount = 100000;
+
+/**
+ * Hands ops straight to the dispatching, the way they arrive from the server.
+ */
+class BenchmarkConnection : public Eris::Connection
+{
+public:
+	BenchmarkConnection(boost::asio::io_service& io_service, Eris::EventService& eventService) :
+			Eris::Connection(io_service, eventService, "benchmark", "localhost", 6767)
+	{
+	}
+
+	void send(const Atlas::Objects::Root&) override
+	{
+	}
+
+	void inject(const RootOperation& op)
+	{
+		dispatchOp(op);
+	}
+};
+
+class BenchmarkFactory : public Eris::Factory
+{
+public:
+	bool accept(const Atlas::Objects::Entity::RootEntity&, Eris::TypeInfo*) override
+	{
+		return true;
+	}
+
+	std::unique_ptr<Eris::ViewEntity> instantiate(const Atlas::Objects::Entity::RootEntity& ge, Eris::TypeInfo* type, Eris::View& v) override
+	{
+		return std::make_unique<Eris::ViewEntity>(ge->getId(), type, v);
+	}
+};
+
+void defineType(Eris::TypeService& typeService, const std::string& name, const std::string& parent)
+{
+	Root type;
+	type->setObjtype("class");
+	type->setId(name);
+	type->setParent(parent);
+	Atlas::Objects::Operation::Info info;
+	info->setArgs1(type);
+	typeService.getTypeByName(name);
+	typeService.handleOperation(info);
+}
+
+std::string entityId(int i)
+{
+	return "e" + std::to_string(i % entityCount);
+}
+
+RootOperation makeSightOfSet(int i)
+{
+	Anonymous arg;
+	arg->setId(entityId(i));
+	arg->setAttr("status", 1.0 / (i + 1));
+	Atlas::Objects::Operation::Set set;
+	set->setFrom(entityId(i));
+	set->setArgs1(arg);
+	Atlas::Objects::Operation::Sight sight;
+	sight->setFrom(entityId(i));
+	sight->setTo("avatar");
+	sight->setArgs1(set);
+	return std::move(sight);
+}
+
+RootOperation makeAppearance(int i)
+{
+	Anonymous arg;
+	arg->setId(entityId(i));
+	arg->setStamp(0.5);
+	Atlas::Objects::Operation::Appearance appearance;
+	appearance->setTo("avatar");
+	appearance->setArgs1(arg);
+	return std::move(appearance);
+}
+
+RootOperation makeSoundOfTalk(int i)
+{
+	Anonymous what;
+	what->setAttr("say", "hello");
+	Atlas::Objects::Operation::Talk talk;
+	talk->setFrom(entityId(i));
+	talk->setArgs1(what);
+	Atlas::Objects::Operation::Sound sound;
+	sound->setFrom(entityId(i));
+	sound->setTo("avatar");
+	sound->setArgs1(talk);
+	return std::move(sound);
+}
+
+RootOperation makeSightOfAction(int i)
+{
+	Anonymous what;
+	what->setId(entityId(i + 1));
+	Atlas::Objects::Operation::Touch touch;
+	touch->setFrom(entityId(i));
+	touch->setArgs1(what);
+	Atlas::Objects::Operation::Sight sight;
+	sight->setFrom(entityId(i));
+	sight->setTo("avatar");
+	sight->setArgs1(touch);
+	return std::move(sight);
+}
+
+void run(BenchmarkConnection& connection, const std::string& name, const std::function<RootOperation(int)>& makeOp)
+{
+	std::vector<RootOperation> ops;
+	ops.reserve(opCount);
+	for (int i = 0; i < opCount; ++i) {
+		ops.push_back(makeOp(i));
+	}
+
+	auto allocationsBefore = allocationCount;
+	auto start = std::chrono::steady_clock::now();
+	for (auto& op : ops) {
+		connection.inject(op);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	auto allocations = static_cast<double>(allocationCount - allocationsBefore);
+	std::cout << name << ": " << elapsed * 1e9 / opCount << " ns per op, "
+			  << allocations / opCount << " allocations per op" << std::endl;
+}
+
+}
+
+int main()
+{
+	Eris::setLogLevel(Eris::LOG_ERROR);
+	boost::asio::io_service io_service;
+	Eris::EventService eventService(io_service);
+	BenchmarkConnection connection(io_service, eventService);
+	Eris::Account account(connection);
+
+	auto& typeService = connection.getTypeService();
+	defineType(typeService, "game_entity", "root");
+	defineType(typeService, "thing", "game_entity");
+	defineType(typeService, "root_operation", "root");
+	defineType(typeService, "action", "root_operation");
+	defineType(typeService, "touch", "action");
+
+	Eris::Avatar avatar(account, "mind", "avatar");
+	avatar.getView().registerFactory(std::make_unique<BenchmarkFactory>());
+	for (int i = 0; i < entityCount; ++i) {
+		Anonymous entity;
+		entity->setId(entityId(i));
+		entity->setParent("thing");
+		entity->setStamp(1);
+		Atlas::Objects::Operation::Sight sight;
+		sight->setTo("avatar");
+		sight->setArgs1(entity);
+		connection.inject(sight);
+	}
+
+	run(connection, "Sight(Set)", makeSightOfSet);
+	run(connection, "Appearance", makeAppearance);
+	run(connection, "Sound(Talk)", makeSoundOfTalk);
+	run(connection, "Sight(Touch)", makeSightOfAction);
+	run(connection, "mixed", [](int i) {
+		switch (i % 10) {
+			case 0:
+			case 1:
+				return makeAppearance(i);
+			case 2:
+				return makeSoundOfTalk(i);
+			case 3:
+				return makeSightOfAction(i);
+			default:
+				return makeSightOfSet(i);
+		}
+	});
+	return 0;
+}
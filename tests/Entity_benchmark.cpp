@@ -0,0 +1,106 @@
+// Measures Entity::setFromRoot() on the Set ops which make up most of the movement traffic: position, velocity,
+// orientation and stamp, with the occasional other property. Also compares mapping the property names to native
+// properties through a chain of string comparisons, as nativePropertyChanged() used to, and through the perfect
+// hash in NativeProperties.
+
+#include <Eris/Entity.h>
+#include <Eris/NativeProperties.h>
+
+#include <Atlas/Objects/Anonymous.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Atlas::Objects::Entity::Anonymous;
+
+namespace {
+
+const int opCount = 100000;
+
+class BenchmarkEntity : public Eris::Entity
+{
+public:
+	BenchmarkEntity() : Eris::Entity("1", nullptr)
+	{
+	}
+
+	Eris::Entity* getEntity(const std::string&) override
+	{
+		return nullptr;
+	}
+
+	void set(const Atlas::Objects::Root& obj)
+	{
+		setFromRoot(obj);
+	}
+};
+
+std::vector<Atlas::Objects::Root> makeMovementSets()
+{
+	std::vector<Atlas::Objects::Root> sets;
+	for (int i = 0; i < opCount; ++i) {
+		Anonymous arg;
+		arg->setId("1");
+		arg->setStamp(i);
+		arg->setAttr("pos", Atlas::Message::ListType{i * 0.1, 0.0, 2.0});
+		arg->setAttr("velocity", Atlas::Message::ListType{1.0, 0.0, (i % 2) * 0.5});
+		arg->setAttr("orientation", Atlas::Message::ListType{0.0, 0.0, 0.0, 1.0});
+		if (i % 10 == 0) {
+			arg->setAttr("mode", "walking");
+		}
+		sets.push_back(arg);
+	}
+	return sets;
+}
+
+/**
+ * The comparisons made by nativePropertyChanged() before it used NativeProperties.
+ */
+int lookupByComparison(const std::string& p)
+{
+	const char* names[] = {"name", "stamp", "pos", "velocity", "angular", "accel", "orientation", "bbox", "loc", "contains", "tasks", "scale"};
+	for (int i = 0; i < 12; ++i) {
+		if (p == names[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+}
+
+int main()
+{
+	auto sets = makeMovementSets();
+	BenchmarkEntity entity;
+
+	auto start = std::chrono::steady_clock::now();
+	for (auto& set : sets) {
+		entity.set(set);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "setFromRoot: " << elapsed * 1e9 / opCount << " ns per op" << std::endl;
+
+	std::vector<std::string> names{"stamp", "pos", "velocity", "orientation", "mode", "parent", "id", "loc"};
+	const int lookupCount = opCount * 10;
+	long found = 0;
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookupCount; ++i) {
+		found += lookupByComparison(names[i % names.size()]);
+	}
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "string comparisons: " << elapsed * 1e9 / lookupCount << " ns per name" << std::endl;
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookupCount; ++i) {
+		found += static_cast<int>(Eris::NativeProperties::lookup(names[i % names.size()]));
+	}
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "perfect hash: " << elapsed * 1e9 / lookupCount << " ns per name" << std::endl;
+
+	//Keep the lookups from being optimized away.
+	return found == 0 ? 1 : 0;
+}
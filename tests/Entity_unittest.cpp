@@ -32,6 +32,8 @@
 #include <Eris/TypeInfo.h>
 #include <Eris/TypeService.h>
 
+#include <Atlas/Objects/Anonymous.h>
+
 class TestErisEntity : public Eris::Entity
 {
   public:
@@ -59,6 +61,14 @@ class TestErisEntity : public Eris::Entity
         m_orientation = orientation;
     }
 
+    void testSetProperty(const std::string& name, const Atlas::Message::Element& value) {
+        setProperty(name, value);
+    }
+
+    void testSetFromRoot(const Atlas::Objects::Root& obj) {
+        setFromRoot(obj);
+    }
+
     void testUpdatePositionWithDelta(const WFMath::TimeDiff& diff) {
         m_moving = true;
 		m_lastPosTime = WFMath::TimeStamp::epochStart();
@@ -113,6 +123,115 @@ int main()
 
     }
 
+    {
+        //Native properties should be found through the perfect hash, and nothing else.
+        for (auto& name : Eris::NativeProperties::names) {
+            auto property = Eris::NativeProperties::lookup(name);
+            assert(property != Eris::NativeProperty::NONE);
+            assert(Eris::NativeProperties::names[static_cast<std::size_t>(property)] == name);
+        }
+        assert(Eris::NativeProperties::lookup("") == Eris::NativeProperty::NONE);
+        assert(Eris::NativeProperties::lookup("mode") == Eris::NativeProperty::NONE);
+        assert(Eris::NativeProperties::lookup("positions") == Eris::NativeProperty::NONE);
+    }
+
+    {
+        //Setting native properties should update the members, and only movement properties should count as a move.
+        TestErisEntity e("1", 0);
+        int moves = 0;
+        std::set<std::string> changed;
+        e.Moved.connect([&]() { moves++; });
+        e.Changed.connect([&](const std::set<std::string>& names) { changed = names; });
+
+        e.testSetProperty("name", "thing");
+        assert(e.getName() == "thing");
+        assert(changed == std::set<std::string>{"name"});
+        e.testSetProperty("mode", "fixed");
+        assert(changed == std::set<std::string>{"mode"});
+        assert(moves == 0);
+
+        e.testSetProperty("pos", Atlas::Message::ListType{1.0, 2.0, 3.0});
+        assert(e.getPosition() == WFMath::Point<3>(1, 2, 3));
+        assert(moves == 1);
+        e.testSetProperty("velocity", Atlas::Message::ListType{1.0, 0.0, 0.0});
+        assert(moves == 2);
+        assert(e.isMoving());
+        e.testSetProperty("stamp", 1.0);
+        assert(moves == 2);
+    }
+
+    {
+        //The modified properties should be tracked as handles, which can be turned back into names.
+        Eris::IdInterner names;
+        Eris::PropertyIdSet ids(names);
+        assert(ids.empty());
+        assert(ids.insert("pos"));
+        assert(!ids.insert("pos"));
+        assert(ids.insert(200));
+        assert(ids.size() == 2);
+        assert(ids.contains("pos"));
+        assert(!ids.contains("velocity"));
+        std::vector<Eris::IdInterner::Handle> handles(ids.begin(), ids.end());
+        assert(handles == (std::vector<Eris::IdInterner::Handle>{names.find("pos"), 200}));
+        ids.clear();
+        assert(ids.empty());
+        assert(ids.begin() == ids.end());
+        assert(!ids.contains("pos"));
+    }
+
+    {
+        //Both signals should be emitted for a batch of changes, with the same properties.
+        TestErisEntity e("1", 0);
+        std::set<std::string> changedIds;
+        e.PropertiesChanged.connect([&](const Eris::PropertyIdSet& ids) {
+            for (auto handle : ids) {
+                changedIds.insert(ids.getName(handle));
+            }
+        });
+        e.testSetProperty("mode", "fixed");
+        assert(changedIds == std::set<std::string>{"mode"});
+
+        std::set<std::string> changed;
+        auto connection = e.Changed.connect([&](const std::set<std::string>& names) { changed = names; });
+        changedIds.clear();
+        e.testSetProperty("pos", Atlas::Message::ListType{1.0, 2.0, 3.0});
+        assert(changedIds == std::set<std::string>{"pos"});
+        assert(changed == changedIds);
+        connection.disconnect();
+    }
+
+    {
+        //All attributes which are set should become properties, except for the id and the contents.
+        TestErisEntity e("1", 0);
+        Atlas::Objects::Entity::Anonymous arg;
+        arg->setId("2");
+        arg->setName("thing");
+        arg->setPos(std::vector<double>{1.0, 2.0, 3.0});
+        arg->setContains(std::vector<std::string>{"3"});
+        arg->setAttr("mode", "fixed");
+        arg->setAttr("extra", Atlas::Message::MapType{{"list", Atlas::Message::ListType{1, 2.0, "three"}}});
+        std::set<std::string> changed;
+        e.Changed.connect([&](const std::set<std::string>& names) { changed = names; });
+
+        e.testSetFromRoot(arg);
+        assert(e.getId() == "1");
+        assert(!e.hasProperty("id"));
+        assert(!e.hasProperty("contains"));
+        assert(e.getName() == "thing");
+        assert(e.getPosition() == WFMath::Point<3>(1, 2, 3));
+        assert(e.valueOfProperty("mode") == "fixed");
+        assert(e.valueOfProperty("extra") == (Atlas::Message::MapType{{"list", Atlas::Message::ListType{1, 2.0, "three"}}}));
+        assert(changed.count("name") && changed.count("pos") && changed.count("mode") && changed.count("extra"));
+        auto instanceProperties = e.getInstanceProperties();
+        assert(instanceProperties.size() == e.getInstancePropertyTable().size());
+        assert(instanceProperties["mode"] == "fixed");
+
+        //Values which haven't changed shouldn't be reported.
+        arg->setAttr("mode", "planted");
+        e.testSetFromRoot(arg);
+        assert(changed == std::set<std::string>{"mode"});
+    }
+
 
     return 0;
 }
@@ -652,6 +652,10 @@ ViewEntity* View::getEntity(const std::string& eid) const {
 	return 0;
 }
 
+ViewEntity* View::getEntity(IdInterner::Handle handle) const {
+	return 0;
+}
+
 bool View::isPending(const std::string& eid) const {
 	return false;
 }
@@ -689,7 +693,8 @@ TransferInfo::TransferInfo(std::string host, int port,
 TypeInfo::TypeInfo(std::string id, TypeService& ts) :
 		m_bound(false),
 		m_name(id),
-		m_typeService(ts) {
+		m_typeService(ts),
+		m_properties(ts.getPropertyNames()) {
 }
 
 bool TypeInfo::isA(TypeInfo* tp) const {
@@ -728,6 +733,10 @@ Router::RouterResult Router::handleOperation(const RootOperation&) {
 	return IGNORED;
 }
 
+Router::RouterResult Router::routeOperation(const RootOperation& op, IdInterner::Handle, IdInterner::Handle) {
+	return handleOperation(op);
+}
+
 Router::RouterResult Router::handleEntity(const RootEntity&) {
 	return IGNORED;
 }
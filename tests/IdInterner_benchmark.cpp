@@ -0,0 +1,107 @@
+// Compares the cost of the id lookups made while dispatching an op, with the routers and entities keyed by
+// their string ids, as they used to be, and by handles from an IdInterner, as Connection and View now do.
+//
+// Each op is looked up the way Connection::dispatchOp() and the IGRouter do it: the router registered for the
+// FROM id, the router registered for the TO id, and the entity in the View. With interned ids the strings are
+// only hashed once, when the op is queued.
+
+#include "Eris/IdInterner.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const int entityCount = 10000;
+const int opCount = 1000000;
+
+struct Op
+{
+	std::string from;
+	std::string to;
+};
+
+struct Target
+{
+	int value;
+};
+
+std::vector<Op> makeOps()
+{
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> distribution(0, entityCount - 1);
+	std::vector<Op> ops;
+	ops.reserve(opCount);
+	for (int i = 0; i < opCount; ++i) {
+		//Server ids are numbers, large enough to not fit in the small string buffer.
+		ops.push_back(Op{std::to_string(1000000000000000LL + distribution(random)), "avatar"});
+	}
+	return ops;
+}
+
+void report(const std::string& name, std::chrono::steady_clock::time_point start, long checksum)
+{
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << ": " << elapsed * 1e9 / opCount << " ns per op (" << checksum << ")" << std::endl;
+}
+
+}
+
+int main()
+{
+	auto ops = makeOps();
+	Target target{1};
+
+	{
+		std::unordered_map<std::string, Target*> fromRouters;
+		std::unordered_map<std::string, Target*> toRouters;
+		std::unordered_map<std::string, Target*> contents;
+		for (int i = 0; i < entityCount; ++i) {
+			auto id = std::to_string(1000000000000000LL + i);
+			fromRouters[id] = &target;
+			contents[id] = &target;
+		}
+		toRouters["avatar"] = &target;
+
+		long checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (auto& op : ops) {
+			auto F = fromRouters.find(op.from);
+			auto T = toRouters.find(op.to);
+			auto E = contents.find(op.from);
+			checksum += F->second->value + T->second->value + E->second->value;
+		}
+		report("string keys", start, checksum);
+	}
+
+	{
+		Eris::IdInterner interner;
+		std::unordered_map<Eris::IdInterner::Handle, Target*> fromRouters;
+		std::unordered_map<Eris::IdInterner::Handle, Target*> toRouters;
+		std::vector<Target*> contents(entityCount + 2, nullptr);
+		for (int i = 0; i < entityCount; ++i) {
+			auto handle = interner.intern(std::to_string(1000000000000000LL + i));
+			fromRouters[handle] = &target;
+			contents[handle] = &target;
+		}
+		toRouters[interner.intern("avatar")] = &target;
+
+		long checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (auto& op : ops) {
+			auto from = interner.find(op.from);
+			auto to = interner.find(op.to);
+			auto F = fromRouters.find(from);
+			auto T = toRouters.find(to);
+			checksum += F->second->value + T->second->value + contents[from]->value;
+		}
+		report("interned handles", start, checksum);
+	}
+
+	return 0;
+}
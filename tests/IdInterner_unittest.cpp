@@ -0,0 +1,64 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/IdInterner.h"
+
+#include <cassert>
+#include <string>
+
+using Eris::IdInterner;
+
+int main()
+{
+	IdInterner interner;
+	assert(interner.size() == 0);
+	assert(interner.find("1") == IdInterner::INVALID_HANDLE);
+	assert(interner.getId(IdInterner::INVALID_HANDLE).empty());
+
+	//Interning the same id again should give the same handle.
+	auto first = interner.intern("1");
+	auto second = interner.intern("2");
+	assert(first != IdInterner::INVALID_HANDLE);
+	assert(second != IdInterner::INVALID_HANDLE);
+	assert(first != second);
+	assert(interner.intern("1") == first);
+	assert(interner.find("1") == first);
+	assert(interner.find("2") == second);
+	assert(interner.size() == 2);
+
+	//The ids should be kept when the table grows.
+	for (int i = 3; i < 10000; ++i) {
+		interner.intern(std::to_string(i));
+	}
+	assert(interner.getId(first) == "1");
+	assert(interner.getId(second) == "2");
+	assert(interner.getId(interner.find("9999")) == "9999");
+	assert(interner.getId(100000).empty());
+
+	//An id should only be removed once each reference to it has been released.
+	{
+		IdInterner released;
+		auto handle = released.intern("a");
+		released.intern("a");
+		released.release(handle);
+		assert(released.find("a") == handle);
+		released.release(handle);
+		assert(released.find("a") == IdInterner::INVALID_HANDLE);
+		assert(released.getId(handle).empty());
+		assert(released.size() == 0);
+
+		//The handle should be handed out again.
+		assert(released.intern("b") == handle);
+		assert(released.getId(handle) == "b");
+		released.retain(handle);
+		released.release(handle);
+		assert(released.find("b") == handle);
+		released.release(IdInterner::INVALID_HANDLE);
+	}
+
+	return 0;
+}
@@ -0,0 +1,187 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/IoUringService.h"
+#include "Eris/Log.h"
+#include "Eris/UringStreamSocket.h"
+
+#include <Atlas/Message/QueuedDecoder.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Eris;
+using boost::asio::local::stream_protocol;
+
+namespace
+{
+
+typedef UringStreamSocket<AsioStreamSocket<stream_protocol>> TestSocket;
+
+/**
+ * Connects a socket to the acceptor, and acts as the server in the Atlas negotiation.
+ */
+std::shared_ptr<TestSocket> connectAndNegotiate(boost::asio::io_service& io_service, stream_protocol::acceptor& acceptor,
+												stream_protocol::socket& peer, Atlas::Bridge& bridge,
+												std::vector<StreamSocket::Status>& states, const std::string& path)
+{
+	StreamSocket::Callbacks callbacks;
+	callbacks.dispatch = [] {};
+	callbacks.stateChanged = [&states](StreamSocket::Status status) {
+		states.push_back(status);
+	};
+	auto socket = std::make_shared<TestSocket>(io_service, "test", bridge, callbacks);
+	socket->connect(stream_protocol::endpoint(path));
+	acceptor.accept(peer);
+	boost::asio::write(peer, boost::asio::buffer(std::string("ATLAS server\n")));
+
+	std::string offer;
+	while (offer.find("\n\n") == std::string::npos) {
+		io_service.poll();
+		std::vector<char> data(peer.available());
+		if (!data.empty()) {
+			peer.read_some(boost::asio::buffer(data));
+			offer.append(data.data(), data.size());
+		}
+	}
+	auto codecStart = offer.find("ICAN ") + 5;
+	auto codec = offer.substr(codecStart, offer.find('\n', codecStart) - codecStart);
+	boost::asio::write(peer, boost::asio::buffer("IWILL " + codec + "\n\n"));
+	while (std::find(states.begin(), states.end(), StreamSocket::CONNECTED) == states.end()) {
+		io_service.run_one();
+	}
+	return socket;
+}
+
+}
+
+int main()
+{
+	//Data written through the ring on one end should be read through it on the other.
+	{
+		boost::asio::io_service io_service;
+		auto& service = boost::asio::use_service<IoUringService>(io_service);
+		stream_protocol::socket a(io_service), b(io_service);
+		boost::asio::local::connect_pair(a, b);
+
+		std::string message("hello through the ring");
+		int written = 0;
+		service.asyncWrite(a.native_handle(), boost::asio::buffer(message), [&](int result) {
+			written = result;
+		});
+		std::vector<char> fallback(1024);
+		std::string received;
+		service.asyncRead(b.native_handle(), boost::asio::buffer(fallback), [&](int result, const char* data) {
+			assert(result > 0);
+			received.assign(data, static_cast<std::size_t>(result));
+		});
+		io_service.run();
+		assert(written == static_cast<int>(message.size()));
+		assert(received == message);
+		assert(service.getSubmittedOperations() == 2);
+	}
+
+	//A read should complete with zero bytes once the other end has been closed.
+	{
+		boost::asio::io_service io_service;
+		auto& service = boost::asio::use_service<IoUringService>(io_service);
+		stream_protocol::socket a(io_service), b(io_service);
+		boost::asio::local::connect_pair(a, b);
+
+		int readResult = -1;
+		std::vector<char> fallback(1024);
+		service.asyncRead(b.native_handle(), boost::asio::buffer(fallback), [&](int result, const char*) {
+			readResult = result;
+		});
+		a.close();
+		io_service.run();
+		assert(readResult == 0);
+	}
+
+	//Cancelling should complete a read which would otherwise wait forever.
+	{
+		boost::asio::io_service io_service;
+		auto& service = boost::asio::use_service<IoUringService>(io_service);
+		stream_protocol::socket a(io_service), b(io_service);
+		boost::asio::local::connect_pair(a, b);
+
+		int readResult = 0;
+		std::vector<char> fallback(1024);
+		service.asyncRead(b.native_handle(), boost::asio::buffer(fallback), [&](int result, const char*) {
+			readResult = result;
+		});
+		io_service.poll();
+		assert(readResult == 0);
+		service.cancel(b.native_handle());
+		//Returns once nothing is in flight anymore.
+		io_service.run();
+		assert(readResult == -ECANCELED);
+	}
+
+	std::string path = "IoUringService_unittest.socket";
+	Atlas::Message::QueuedDecoder bridge;
+
+	//Once negotiated, ops should go through the ring, and the server closing the connection should be noticed.
+	{
+		std::remove(path.c_str());
+		boost::asio::io_service io_service;
+		stream_protocol::acceptor acceptor(io_service, stream_protocol::endpoint(path));
+		stream_protocol::socket peer(io_service);
+		std::vector<StreamSocket::Status> states;
+		auto socket = connectAndNegotiate(io_service, acceptor, peer, bridge, states, path);
+
+		auto& service = boost::asio::use_service<IoUringService>(io_service);
+		auto submitted = service.getSubmittedOperations();
+		socket->getEncoder().streamObjectsMessage(Atlas::Objects::Operation::Talk());
+		socket->write();
+		std::string received;
+		while (received.find("talk") == std::string::npos) {
+			io_service.poll();
+			std::vector<char> data(peer.available());
+			if (!data.empty()) {
+				peer.read_some(boost::asio::buffer(data));
+				received.append(data.data(), data.size());
+			}
+		}
+		assert(service.getSubmittedOperations() > submitted);
+		assert(socket->getStatistics().bytesWritten > 0);
+
+		peer.close();
+		while (std::find(states.begin(), states.end(), StreamSocket::CONNECTION_FAILED) == states.end()) {
+			io_service.run_one();
+		}
+		socket->detach();
+	}
+
+	//Detaching should cancel the read in flight, so that the socket is released.
+	{
+		std::remove(path.c_str());
+		boost::asio::io_service io_service;
+		stream_protocol::acceptor acceptor(io_service, stream_protocol::endpoint(path));
+		stream_protocol::socket peer(io_service);
+		std::vector<StreamSocket::Status> states;
+		auto socket = connectAndNegotiate(io_service, acceptor, peer, bridge, states, path);
+
+		std::weak_ptr<TestSocket> weakSocket = socket;
+		socket->detach();
+		socket.reset();
+		while (!weakSocket.expired()) {
+			io_service.run_one();
+		}
+		//The server is still connected, so the read could only have ended through being cancelled.
+		assert(peer.is_open());
+	}
+	std::remove(path.c_str());
+
+	return 0;
+}
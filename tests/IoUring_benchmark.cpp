@@ -0,0 +1,286 @@
+// Compares the throughput and client CPU usage of doing socket I/O through the asio reactor and through io_uring.
+//
+// A number of loopback connections are made to an echo server running in a separate thread. Each connection
+// keeps a few ops in flight, sending a new one whenever one is echoed back, until all ops have been sent.
+// Only the CPU time of the client thread is measured.
+
+#include "Eris/IoUringService.h"
+
+#include <boost/asio.hpp>
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+const std::size_t opSize = 256;
+const int connectionCount = 16;
+const int opsPerConnection = 20000;
+const int pipelineDepth = 8;
+
+/**
+ * Echoes back everything it receives, on all connections.
+ */
+class EchoServer
+{
+public:
+	EchoServer() :
+			mAcceptor(mIoService, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)),
+			mWork(mIoService)
+	{
+		accept();
+		mThread = std::thread([this]() { mIoService.run(); });
+	}
+
+	~EchoServer()
+	{
+		mIoService.stop();
+		mThread.join();
+	}
+
+	tcp::endpoint getEndpoint() const
+	{
+		return mAcceptor.local_endpoint();
+	}
+
+private:
+	struct Session
+	{
+		explicit Session(boost::asio::io_service& io_service) : socket(io_service), buffer(64 * 1024)
+		{
+		}
+
+		tcp::socket socket;
+		std::vector<char> buffer;
+	};
+
+	boost::asio::io_service mIoService;
+	tcp::acceptor mAcceptor;
+	boost::asio::io_service::work mWork;
+	std::list<std::shared_ptr<Session>> mSessions;
+	std::thread mThread;
+
+	void accept()
+	{
+		auto session = std::make_shared<Session>(mIoService);
+		mAcceptor.async_accept(session->socket, [this, session](boost::system::error_code ec) {
+			if (!ec) {
+				session->socket.set_option(tcp::no_delay(true));
+				mSessions.push_back(session);
+				read(session);
+				accept();
+			}
+		});
+	}
+
+	void read(std::shared_ptr<Session> session)
+	{
+		session->socket.async_read_some(boost::asio::buffer(session->buffer), [this, session](boost::system::error_code ec, std::size_t length) {
+			if (!ec) {
+				boost::asio::async_write(session->socket, boost::asio::buffer(session->buffer.data(), length),
+										 [this, session](boost::system::error_code writeEc, std::size_t) {
+											 if (!writeEc) {
+												 read(session);
+											 }
+										 });
+			}
+		});
+	}
+};
+
+struct Client
+{
+	explicit Client(boost::asio::io_service& io_service) :
+			socket(io_service),
+			readBuffer(64 * 1024),
+			writeBuffer(opSize * pipelineDepth, 'x')
+	{
+	}
+
+	tcp::socket socket;
+	std::vector<char> readBuffer;
+	std::vector<char> writeBuffer;
+	std::size_t partialBytes = 0;
+	int opsSent = 0;
+	int opsReceived = 0;
+	int opsQueued = 0;
+	bool writing = false;
+};
+
+typedef std::function<void(int)> CompletionHandler;
+
+struct AsioTransport
+{
+	void read(Client& client, CompletionHandler handler)
+	{
+		client.socket.async_read_some(boost::asio::buffer(client.readBuffer), [handler](boost::system::error_code ec, std::size_t length) {
+			handler(ec ? -1 : static_cast<int>(length));
+		});
+	}
+
+	void write(Client& client, const char* data, std::size_t size, CompletionHandler handler)
+	{
+		boost::asio::async_write(client.socket, boost::asio::buffer(data, size), [handler](boost::system::error_code ec, std::size_t length) {
+			handler(ec ? -1 : static_cast<int>(length));
+		});
+	}
+};
+
+struct UringTransport
+{
+	Eris::IoUringService& service;
+
+	void read(Client& client, CompletionHandler handler)
+	{
+		service.asyncRead(client.socket.native_handle(), boost::asio::buffer(client.readBuffer), [handler](int result, const char*) {
+			handler(result);
+		});
+	}
+
+	void write(Client& client, const char* data, std::size_t size, CompletionHandler handler)
+	{
+		service.asyncWrite(client.socket.native_handle(), boost::asio::buffer(data, size), std::move(handler));
+	}
+};
+
+template<typename TransportT>
+class Driver
+{
+public:
+	Driver(TransportT& transport) : mTransport(transport), mFinished(0)
+	{
+	}
+
+	void start(Client& client)
+	{
+		client.opsQueued = pipelineDepth;
+		pumpWrite(client);
+		read(client);
+	}
+
+	int getFinished() const
+	{
+		return mFinished;
+	}
+
+private:
+	TransportT& mTransport;
+	int mFinished;
+
+	void read(Client& client)
+	{
+		mTransport.read(client, [this, &client](int result) {
+			if (result <= 0) {
+				std::cerr << "Read failed." << std::endl;
+				return;
+			}
+			client.partialBytes += static_cast<std::size_t>(result);
+			auto completed = static_cast<int>(client.partialBytes / opSize);
+			client.partialBytes %= opSize;
+			client.opsReceived += completed;
+			client.opsQueued += std::min(completed, opsPerConnection - client.opsSent - client.opsQueued);
+			pumpWrite(client);
+			if (client.opsReceived < opsPerConnection) {
+				read(client);
+			} else {
+				mFinished++;
+			}
+		});
+	}
+
+	void pumpWrite(Client& client)
+	{
+		if (!client.writing && client.opsQueued > 0) {
+			auto count = std::min(client.opsQueued, pipelineDepth);
+			client.opsQueued -= count;
+			client.opsSent += count;
+			client.writing = true;
+			write(client, client.writeBuffer.data(), static_cast<std::size_t>(count) * opSize);
+		}
+	}
+
+	void write(Client& client, const char* data, std::size_t size)
+	{
+		mTransport.write(client, data, size, [this, &client, data, size](int result) {
+			if (result < 0) {
+				std::cerr << "Write failed." << std::endl;
+				return;
+			}
+			if (static_cast<std::size_t>(result) < size) {
+				write(client, data + result, size - static_cast<std::size_t>(result));
+			} else {
+				client.writing = false;
+				pumpWrite(client);
+			}
+		});
+	}
+};
+
+double getThreadCpuSeconds()
+{
+	timespec ts{};
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+template<typename TransportT>
+void run(const std::string& name, boost::asio::io_service& io_service, TransportT& transport, const tcp::endpoint& endpoint)
+{
+	std::vector<std::unique_ptr<Client>> clients;
+	for (int i = 0; i < connectionCount; ++i) {
+		clients.emplace_back(new Client(io_service));
+		clients.back()->socket.connect(endpoint);
+		clients.back()->socket.set_option(tcp::no_delay(true));
+	}
+
+	Driver<TransportT> driver(transport);
+	auto start = std::chrono::steady_clock::now();
+	auto cpuStart = getThreadCpuSeconds();
+	for (auto& client : clients) {
+		driver.start(*client);
+	}
+	while (driver.getFinished() < connectionCount) {
+		io_service.run_one();
+	}
+	auto cpu = getThreadCpuSeconds() - cpuStart;
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	double totalOps = static_cast<double>(connectionCount) * opsPerConnection;
+	std::cout << name << ": " << static_cast<long>(totalOps / elapsed) << " ops/s, "
+			  << cpu * 1000.0 / connectionCount << " ms client CPU per connection ("
+			  << cpu * 1e6 / totalOps << " us per op)" << std::endl;
+}
+
+}
+
+int main()
+{
+	EchoServer server;
+
+	{
+		boost::asio::io_service io_service;
+		AsioTransport transport;
+		run("asio reactor", io_service, transport, server.getEndpoint());
+	}
+
+	{
+		boost::asio::io_service io_service;
+		auto& service = boost::asio::use_service<Eris::IoUringService>(io_service);
+		UringTransport transport{service};
+		run("io_uring", io_service, transport, server.getEndpoint());
+		std::cout << "io_uring: " << service.getSubmittedOperations() << " operations in "
+				  << service.getSubmitCalls() << " submit calls" << std::endl;
+	}
+	return 0;
+}
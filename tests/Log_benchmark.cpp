@@ -0,0 +1,66 @@
+// Measures the cost of log statements on the dispatch path: a debug message with the level turned off, written
+// with the stream classes, which format the message before it's discarded, and with the ERIS_DEBUG() macro,
+// which checks the level first; and a warning handled by a slow slot on Logged, as clients often connect, and
+// by an AsyncLogSink which calls the same handler on its own thread.
+
+#include "Eris/AsyncLogSink.h"
+#include "Eris/Log.h"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const int messageCount = 1000000;
+
+void run(const std::string& name, int count, const std::function<void(int)>& log)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i) {
+		log(i);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << name << ": " << elapsed * 1e9 / count << " ns per message" << std::endl;
+}
+
+}
+
+int main()
+{
+	std::string parent("sight");
+
+	Eris::setLogLevel(Eris::LOG_WARNING);
+	run("debug(), disabled", messageCount, [&](int i) {
+		Eris::debug() << "received op:" << parent << " " << i;
+	});
+	run("ERIS_DEBUG(), disabled", messageCount, [&](int i) {
+		ERIS_DEBUG() << "received op:" << parent << " " << i;
+	});
+
+	std::ofstream file("Log_benchmark.log");
+	auto handler = [&](Eris::LogLevel, const std::string& message) {
+		file << message << std::endl;
+	};
+
+	const int warningCount = messageCount / 10;
+	{
+		auto connection = Eris::Logged.connect(handler);
+		run("warning(), Logged", warningCount, [&](int i) {
+			Eris::warning() << "no-one handled op:" << parent << " " << i;
+		});
+		connection.disconnect();
+	}
+	{
+		Eris::AsyncLogSink sink(handler, warningCount);
+		Eris::setAsyncLogSink(&sink);
+		run("warning(), AsyncLogSink", warningCount, [&](int i) {
+			Eris::warning() << "no-one handled op:" << parent << " " << i;
+		});
+		Eris::setAsyncLogSink(nullptr);
+		std::cout << "dropped: " << sink.getDropped() << std::endl;
+	}
+	return 0;
+}
@@ -25,9 +25,25 @@
 #endif
 
 
+#include <Eris/AsyncLogSink.h>
 #include <Eris/Log.h>
 
 #include <cassert>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+int formatted = 0;
+
+std::string format(const std::string& text)
+{
+    formatted++;
+    return text;
+}
+}
 
 int main()
 {
@@ -48,5 +64,132 @@ int main()
     Eris::setLogLevel(Eris::LOG_DEBUG);
     assert(Eris::getLogLevel() == Eris::LOG_DEBUG);
 
+    //Nothing should be formatted by the macros if the level isn't logged.
+    {
+        std::vector<std::string> messages;
+        auto connection = Eris::Logged.connect([&](Eris::LogLevel, const std::string& message) {
+            messages.push_back(message);
+        });
+        Eris::setLogLevel(Eris::LOG_WARNING);
+        assert(!Eris::isLogging(Eris::LOG_DEBUG));
+        assert(Eris::isLogging(Eris::LOG_ERROR));
+        ERIS_DEBUG() << format("debug");
+        assert(formatted == 0);
+        assert(messages.empty());
+        ERIS_WARNING() << format("warning");
+        assert(formatted == 1);
+        assert(messages.size() == 1 && messages.front() == "warning");
+
+        //A dangling else should still belong to the surrounding if.
+        bool elseTaken = false;
+        if (formatted == 0)
+            ERIS_WARNING() << "not logged";
+        else
+            elseTaken = true;
+        assert(elseTaken);
+
+        //Only the first messages from a call site should get through.
+        messages.clear();
+        for (int i = 0; i < 15; ++i) {
+            ERIS_WARNING_LIMITED() << "storm " << i;
+        }
+        assert(messages.size() == 10);
+        connection.disconnect();
+    }
+
+    {
+        Eris::LogRateLimiter limiter(2, std::chrono::hours(1));
+        assert(limiter.allow());
+        assert(limiter.allow());
+        assert(!limiter.allow());
+        assert(!limiter.allow());
+        assert(limiter.takeSuppressedNote() == "(2 similar messages suppressed) ");
+        assert(limiter.takeSuppressedNote().empty());
+
+        Eris::LogRateLimiter shortLimiter(1, std::chrono::milliseconds(1));
+        assert(shortLimiter.allow());
+        assert(!shortLimiter.allow());
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        assert(shortLimiter.allow());
+    }
+
+    //With an async sink installed messages should be handed to it instead of Logged.
+    {
+        bool emitted = false;
+        auto connection = Eris::Logged.connect([&](Eris::LogLevel, const std::string&) {
+            emitted = true;
+        });
+        std::mutex mutex;
+        std::vector<std::string> messages;
+        {
+            Eris::AsyncLogSink sink([&](Eris::LogLevel level, const std::string& message) {
+                assert(level == Eris::LOG_WARNING);
+                std::lock_guard<std::mutex> lock(mutex);
+                messages.push_back(message);
+            });
+            Eris::setAsyncLogSink(&sink);
+            Eris::warning() << "async";
+            Eris::setAsyncLogSink(nullptr);
+        }
+        assert(!emitted);
+        assert(messages.size() == 1 && messages.front() == "async");
+        connection.disconnect();
+    }
+
+    //Messages pushed from many threads should all arrive, in order for each thread.
+    {
+        const int threadCount = 4;
+        const int messageCount = 1000;
+        std::vector<std::vector<int>> received(threadCount);
+        {
+            Eris::AsyncLogSink sink([&](Eris::LogLevel, const std::string& message) {
+                auto separator = message.find(':');
+                received[std::stoi(message.substr(0, separator))].push_back(std::stoi(message.substr(separator + 1)));
+            }, threadCount * messageCount);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&sink, t]() {
+                    for (int i = 0; i < messageCount; ++i) {
+                        assert(sink.push(Eris::LOG_WARNING, std::to_string(t) + ":" + std::to_string(i)));
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            assert(sink.getDropped() == 0);
+        }
+        for (auto& messages : received) {
+            assert(messages.size() == static_cast<std::size_t>(messageCount));
+            for (int i = 0; i < messageCount; ++i) {
+                assert(messages[i] == i);
+            }
+        }
+    }
+
+    //Messages which don't fit should be dropped, rather than waiting for the handler.
+    {
+        std::promise<void> release;
+        auto released = release.get_future().share();
+        int handled = 0;
+        int accepted = 0;
+        {
+            Eris::AsyncLogSink sink([&](Eris::LogLevel, const std::string&) {
+                released.wait();
+                handled++;
+            }, 2);
+            for (int i = 0; i < 4; ++i) {
+                if (sink.push(Eris::LOG_WARNING, "full")) {
+                    accepted++;
+                }
+            }
+            assert(sink.getDropped() >= 1);
+            assert(accepted + static_cast<int>(sink.getDropped()) == 4);
+            release.set_value();
+        }
+        //The sink should have handed all accepted messages to the handler before it was destroyed.
+        assert(handled == accepted);
+    }
+
     return 0;
 }
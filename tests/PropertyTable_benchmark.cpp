@@ -0,0 +1,131 @@
+// Compares the memory used by the instance properties of entities kept in a std::map, as Entity used to, and in a
+// PropertyTable with names interned in a shared IdInterner, as Entity now does. The properties are those most
+// entities have once they've been seen. Both the bytes per entity, including the values, and the time taken to
+// look up properties are reported.
+
+#include "Eris/IdInterner.h"
+#include "Eris/PropertyTable.h"
+
+#include <Atlas/Message/Element.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+std::size_t allocatedBytes = 0;
+
+/**
+ * Room in front of each allocation for its size, so that deallocations can be subtracted.
+ */
+const std::size_t headerSize = alignof(std::max_align_t);
+}
+
+void* operator new(std::size_t size)
+{
+	if (auto ptr = static_cast<char*>(std::malloc(size + headerSize))) {
+		*reinterpret_cast<std::size_t*>(ptr) = size;
+		allocatedBytes += size;
+		return ptr + headerSize;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	if (ptr) {
+		auto start = static_cast<char*>(ptr) - headerSize;
+		allocatedBytes -= *reinterpret_cast<std::size_t*>(start);
+		std::free(start);
+	}
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+
+namespace {
+
+const int entityCount = 20000;
+const int lookupCount = 1000000;
+
+std::vector<std::pair<std::string, Element>> makeProperties(int i)
+{
+	return {
+			{"name",           "tree " + std::to_string(i)},
+			{"stamp",          1.0 * i},
+			{"pos",            ListType{i * 0.5, 0.0, i * 0.25}},
+			{"velocity",       ListType{0.0, 0.0, 0.0}},
+			{"orientation",    ListType{0.0, 0.0, 0.0, 1.0}},
+			{"bbox",           ListType{-1.0, 0.0, -1.0, 1.0, 10.0, 1.0}},
+			{"loc",            "0"},
+			{"mode",           "planted"},
+			{"mass",           500.0},
+			{"status",         1.0},
+			{"planted_offset", -0.5},
+			{"solid",          1}
+	};
+}
+
+template<typename MakeT, typename LookupT>
+void run(const std::string& name, MakeT make, LookupT lookup)
+{
+	auto before = allocatedBytes;
+	auto containers = make();
+	auto used = allocatedBytes - before;
+	std::cout << name << ": " << static_cast<double>(used) / entityCount << " bytes per entity";
+
+	std::vector<std::string> names{"pos", "velocity", "mode", "bbox", "scale"};
+	auto start = std::chrono::steady_clock::now();
+	std::size_t found = 0;
+	for (int i = 0; i < lookupCount; ++i) {
+		found += lookup(containers[i % entityCount], names[i % names.size()]);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << ", " << elapsed * 1e9 / lookupCount << " ns per lookup (" << found << " found)" << std::endl;
+}
+
+}
+
+int main()
+{
+	run("std::map", []() {
+		//The containers are allocated too, as they are when held by an Entity.
+		std::vector<std::unique_ptr<std::map<std::string, Element>>> maps;
+		maps.reserve(entityCount);
+		for (int i = 0; i < entityCount; ++i) {
+			maps.emplace_back(new std::map<std::string, Element>());
+			for (auto& entry : makeProperties(i)) {
+				(*maps.back())[entry.first] = entry.second;
+			}
+		}
+		return maps;
+	}, [](const std::unique_ptr<std::map<std::string, Element>>& map, const std::string& name) {
+		return map->find(name) != map->end() ? 1 : 0;
+	});
+
+	Eris::IdInterner names;
+	run("PropertyTable", [&]() {
+		std::vector<std::unique_ptr<Eris::PropertyTable>> tables;
+		tables.reserve(entityCount);
+		for (int i = 0; i < entityCount; ++i) {
+			tables.emplace_back(new Eris::PropertyTable(names));
+			for (auto& entry : makeProperties(i)) {
+				(*tables.back())[entry.first] = entry.second;
+			}
+		}
+		return tables;
+	}, [](const std::unique_ptr<Eris::PropertyTable>& table, const std::string& name) {
+		return table->find(name) != table->end() ? 1 : 0;
+	});
+	return 0;
+}
@@ -0,0 +1,126 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/PropertyTable.h"
+
+#include <cassert>
+#include <map>
+#include <string>
+
+using namespace Eris;
+using Atlas::Message::Element;
+
+int main()
+{
+	IdInterner names;
+
+	//Properties should be found by name and by handle, and missing ones not at all.
+	{
+		PropertyTable table(names);
+		assert(table.empty());
+		assert(table.find("pos") == table.end());
+		assert(table.getAllocatedSize() == 0);
+
+		table["pos"] = 1.0;
+		table["name"] = "thing";
+		assert(table.size() == 2);
+		assert(table.find("pos")->second == 1.0);
+		assert(table.find("name")->second == "thing");
+		assert(table.find("name")->first == "name");
+		assert(table.find("mode") == table.end());
+		assert(table.find(names.find("pos"))->second == 1.0);
+		assert(table.find(IdInterner::INVALID_HANDLE) == table.end());
+
+		table["pos"] = 2.0;
+		assert(table.size() == 2);
+		assert(table.find("pos")->second == 2.0);
+
+		table[names.find("pos")] = 3.0;
+		table[names.intern("mode")] = "fixed";
+		assert(table.size() == 3);
+		assert(table.find("pos")->second == 3.0);
+		assert(table.find("mode")->second == "fixed");
+	}
+
+	//Tables should share the interned names.
+	{
+		PropertyTable first(names);
+		PropertyTable second(names);
+		first["velocity"] = 1;
+		auto count = names.size();
+		second["velocity"] = 2;
+		assert(names.size() == count);
+		assert(&first.find("velocity")->first == &second.find("velocity")->first);
+	}
+
+	//Entries should survive growth and erasure of other entries, and iteration should cover them all.
+	{
+		PropertyTable table(names);
+		for (int i = 0; i < 200; ++i) {
+			table["property" + std::to_string(i)] = i;
+		}
+		assert(table.size() == 200);
+		for (int i = 0; i < 200; i += 2) {
+			assert(table.erase("property" + std::to_string(i)) == 1);
+		}
+		assert(table.erase("property0") == 0);
+		assert(table.size() == 100);
+		for (int i = 0; i < 200; ++i) {
+			auto I = table.find("property" + std::to_string(i));
+			if (i % 2 == 0) {
+				assert(I == table.end());
+			} else {
+				assert(I != table.end());
+				assert(I->second == i);
+			}
+		}
+		std::map<std::string, Element> seen;
+		for (auto& entry : table) {
+			seen.emplace(entry.first, entry.second);
+		}
+		assert(seen.size() == 100);
+
+		table.erase(table.find("property1"));
+		assert(table.size() == 99);
+		assert(table.find("property1") == table.end());
+		assert(table.find("property3")->second == 3);
+	}
+
+	//Copies should be independent, and moved from tables empty.
+	{
+		PropertyTable table(names);
+		table["name"] = "original";
+		table["stamp"] = 1.0;
+		PropertyTable copy(table);
+		copy["name"] = "copy";
+		assert(table.find("name")->second == "original");
+		assert(copy.find("name")->second == "copy");
+		assert(copy.find("stamp")->second == 1.0);
+
+		PropertyTable moved(std::move(copy));
+		assert(moved.size() == 2);
+		assert(copy.empty());
+		assert(copy.find("name") == copy.end());
+
+		PropertyTable assigned(names);
+		assigned = table;
+		assert(assigned.find("name")->second == "original");
+		assigned = std::move(moved);
+		assert(assigned.find("name")->second == "copy");
+
+		assigned = Atlas::Message::MapType{{"mode", "fixed"}};
+		assert(assigned.size() == 1);
+		assert(assigned.find("mode")->second == "fixed");
+		assert(assigned.find("name") == assigned.end());
+
+		assigned.clear();
+		assert(assigned.empty());
+		assert(assigned.begin() == assigned.end());
+	}
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/ResolverCache.h"
+
+#include <boost/asio/ip/udp.hpp>
+
+#include <cassert>
+
+using namespace Eris;
+using boost::asio::ip::tcp;
+
+int main()
+{
+	boost::asio::io_service io_service;
+	auto& cache = boost::asio::use_service<ResolverCache>(io_service);
+
+	//A stand-in for the resolver, which only completes lookups when told to.
+	std::vector<std::pair<std::string, ResolverCache::ResultHandler>> lookups;
+	cache.setBackend([&](const std::string& host, const std::string&, ResolverCache::ResultHandler handler) {
+		lookups.emplace_back(host, std::move(handler));
+	});
+	auto now = std::chrono::steady_clock::time_point();
+	cache.setClock([&]() { return now; });
+	cache.setTimeToLive(std::chrono::seconds(60), std::chrono::seconds(10));
+
+	ResolverCache::Endpoints endpoints{tcp::endpoint(boost::asio::ip::make_address("192.0.2.1"), 6767)};
+
+	int called = 0;
+	boost::system::error_code lastError;
+	ResolverCache::Endpoints lastEndpoints;
+	auto handler = [&](const boost::system::error_code& ec, const ResolverCache::Endpoints& result) {
+		called++;
+		lastError = ec;
+		lastEndpoints = result;
+	};
+
+	//Concurrent requests for the same name should share one lookup.
+	{
+		cache.resolve("example.org", "6767", handler);
+		cache.resolve("example.org", "6767", handler);
+		assert(lookups.size() == 1);
+		lookups.front().second({}, endpoints);
+		lookups.clear();
+		//Handlers are always called through the io_service.
+		assert(called == 0);
+		io_service.run();
+		io_service.reset();
+		assert(called == 2);
+		assert(!lastError);
+		assert(lastEndpoints == endpoints);
+		assert(cache.getStatistics().shared == 1);
+	}
+
+	//Results should be cached until they expire.
+	{
+		called = 0;
+		now += std::chrono::seconds(59);
+		cache.resolve("example.org", "6767", handler);
+		assert(lookups.empty());
+		io_service.run();
+		io_service.reset();
+		assert(called == 1);
+		assert(lastEndpoints == endpoints);
+
+		now += std::chrono::seconds(2);
+		cache.resolve("example.org", "6767", handler);
+		assert(lookups.size() == 1);
+		lookups.front().second({}, endpoints);
+		lookups.clear();
+		io_service.run();
+		io_service.reset();
+		assert(called == 2);
+	}
+
+	//Different services are different entries.
+	{
+		cache.resolve("example.org", "8453", handler);
+		assert(lookups.size() == 1);
+		lookups.front().second({}, endpoints);
+		lookups.clear();
+		io_service.run();
+		io_service.reset();
+	}
+
+	//Failed lookups should be cached too, for a shorter time.
+	{
+		called = 0;
+		cache.resolve("missing.example.org", "6767", handler);
+		assert(lookups.size() == 1);
+		lookups.front().second(boost::asio::error::host_not_found, {});
+		lookups.clear();
+		io_service.run();
+		io_service.reset();
+		assert(called == 1);
+		assert(lastError == boost::asio::error::host_not_found);
+
+		now += std::chrono::seconds(9);
+		cache.resolve("missing.example.org", "6767", handler);
+		assert(lookups.empty());
+		io_service.run();
+		io_service.reset();
+		assert(called == 2);
+		assert(lastError == boost::asio::error::host_not_found);
+
+		now += std::chrono::seconds(2);
+		cache.resolve("missing.example.org", "6767", handler);
+		assert(lookups.size() == 1);
+		lookups.front().second({}, endpoints);
+		lookups.clear();
+		io_service.run();
+		io_service.reset();
+		assert(called == 3);
+		assert(!lastError);
+	}
+
+	//Aborted lookups shouldn't be cached.
+	{
+		cache.resolve("aborted.example.org", "6767", handler);
+		lookups.front().second(boost::asio::error::operation_aborted, {});
+		lookups.clear();
+		io_service.run();
+		io_service.reset();
+		assert(lastError == boost::asio::error::operation_aborted);
+		cache.resolve("aborted.example.org", "6767", handler);
+		assert(lookups.size() == 1);
+		lookups.clear();
+	}
+
+	//Results can be had for other protocols.
+	{
+		cache.clear();
+		bool gotUdp = false;
+		cache.resolve<boost::asio::ip::udp>("example.org", "6767",
+											[&](const boost::system::error_code& ec, const std::vector<boost::asio::ip::udp::endpoint>& result) {
+												gotUdp = true;
+												assert(result.size() == 1);
+												assert(result.front().address() == endpoints.front().address());
+												assert(result.front().port() == 6767);
+											});
+		lookups.front().second({}, endpoints);
+		lookups.clear();
+		io_service.run();
+		io_service.reset();
+		assert(gotUdp);
+	}
+
+	return 0;
+}
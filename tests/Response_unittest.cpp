@@ -24,7 +24,90 @@
 #define DEBUG
 #endif
 
+#include <Eris/Response.h>
+
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using Atlas::Objects::Operation::RootOperation;
+
+static RootOperation makeResponse(std::int64_t refno)
+{
+    RootOperation op;
+    op->setRefno(refno);
+    return op;
+}
+
 int main()
 {
+    auto second = std::chrono::seconds(1);
+
+    // Test that answered requests don't expire
+    {
+        Eris::ResponseTracker tracker(second, 8);
+        int answers = 0;
+        std::vector<std::int64_t> timeouts;
+        auto callback = [&](const RootOperation&) {
+            answers++;
+            return Eris::Router::HANDLED;
+        };
+        auto onTimeout = [&](std::int64_t serial) { timeouts.push_back(serial); };
+        tracker.await(1, callback, 3 * second, onTimeout);
+        tracker.await(2, callback, 3 * second, onTimeout);
+        assert(tracker.getStatistics().outstanding == 2);
+
+        assert(tracker.handleOp(makeResponse(1)) == Eris::Router::HANDLED);
+        assert(answers == 1);
+        assert(!tracker.isAwaiting(1));
+
+        auto now = std::chrono::steady_clock::now();
+        assert(tracker.expire(now + second) == 0);
+        assert(tracker.expire(now + 5 * second) == 1);
+        assert((timeouts == std::vector<std::int64_t>{2}));
+        assert(tracker.handleOp(makeResponse(2)) == Eris::Router::IGNORED);
+        assert(answers == 1);
+
+        auto statistics = tracker.getStatistics();
+        assert(statistics.outstanding == 0);
+        assert(statistics.peakOutstanding == 2);
+        assert(statistics.answered == 1);
+        assert(statistics.expired == 1);
+    }
+
+    // Test that slots are reused, and deadlines further away than a turn of the wheel are kept
+    {
+        Eris::ResponseTracker tracker(second, 8);
+        auto callback = [](const RootOperation&) { return Eris::Router::HANDLED; };
+        tracker.await(1, callback, 20 * second);
+        tracker.await(2, callback, std::chrono::steady_clock::duration::zero());
+        tracker.await(3, callback, 2 * second);
+        tracker.handleOp(makeResponse(3));
+        tracker.await(4, callback, 2 * second);
+        assert(tracker.getStatistics().slots == 3);
+
+        auto now = std::chrono::steady_clock::now();
+        assert(tracker.expire(now + 10 * second) == 1);
+        assert(tracker.isAwaiting(1));
+        assert(tracker.expire(now + 30 * second) == 1);
+        assert(!tracker.isAwaiting(1));
+        // Without a timeout the request is kept forever.
+        assert(tracker.expire(now + std::chrono::hours(1000)) == 0);
+        assert(tracker.isAwaiting(2));
+    }
+
+    // Test that a timeout callback can await again
+    {
+        Eris::ResponseTracker tracker(second, 8);
+        auto callback = [](const RootOperation&) { return Eris::Router::HANDLED; };
+        tracker.await(1, callback, second, [&](std::int64_t) {
+            tracker.await(2, callback, second);
+        });
+        assert(tracker.expire(std::chrono::steady_clock::now() + 3 * second) == 1);
+        assert(tracker.isAwaiting(2));
+    }
+
     return 0;
 }
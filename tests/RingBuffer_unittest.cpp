@@ -0,0 +1,109 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/RingBuffer.h"
+
+#include <istream>
+#include <string>
+#include <cstring>
+#include <cassert>
+
+using namespace Eris;
+
+static void write(RingBuffer& buffer, const std::string& data)
+{
+	auto buffers = buffer.prepare(data.size());
+	auto first = buffers[0].size();
+	assert(first + buffers[1].size() == data.size());
+	std::memcpy(buffers[0].data(), data.data(), first);
+	std::memcpy(buffers[1].data(), data.data() + first, data.size() - first);
+	buffer.commit(data.size());
+}
+
+static std::string read(std::istream& stream, std::size_t count)
+{
+	std::string result(count, '\0');
+	stream.read(&result[0], static_cast<std::streamsize>(count));
+	result.resize(static_cast<std::size_t>(stream.gcount()));
+	return result;
+}
+
+int main()
+{
+	{
+		RingBuffer buffer(16);
+		std::istream stream(&buffer);
+		assert(buffer.size() == 0);
+		assert(buffer.capacity() == 16);
+		assert(stream.peek() == std::char_traits<char>::eof());
+	}
+
+	//Data wrapping around the end of the ring should be read back in order.
+	{
+		RingBuffer buffer(16);
+		std::istream stream(&buffer);
+		write(buffer, "0123456789");
+		assert(read(stream, 6) == "012345");
+		write(buffer, "abcdefghij");
+		assert(buffer.capacity() == 16);
+		assert(buffer.size() == 14);
+		//The "in_avail" method should report both the contiguous part and the wrapped part, as the Atlas codecs rely on that.
+		std::string result;
+		std::streamsize count;
+		while ((count = buffer.in_avail()) > 0) {
+			for (std::streamsize i = 0; i < count; ++i) {
+				result += static_cast<char>(buffer.sbumpc());
+			}
+		}
+		assert(result == "6789abcdefghij");
+		assert(buffer.size() == 0);
+	}
+
+	//Preparing more than there's room for should grow the ring, while keeping the data.
+	{
+		RingBuffer buffer(16);
+		std::istream stream(&buffer);
+		write(buffer, "0123456789");
+		assert(read(stream, 8) == "01234567");
+		write(buffer, "abcdefghijklmnopqrstuvwxyz");
+		assert(buffer.capacity() == 32);
+		std::string line;
+		std::getline(stream, line);
+		assert(line == "89abcdefghijklmnopqrstuvwxyz");
+	}
+
+	//The ring should grow with large bursts, and shrink back when bursts become small again.
+	{
+		RingBuffer buffer(16, 1024);
+		std::istream stream(&buffer);
+		assert(buffer.getReadSize() == 16);
+		for (int i = 0; i < 5; ++i) {
+			write(buffer, std::string(buffer.getReadSize(), 'x'));
+			buffer.recordBurst(buffer.size());
+			read(stream, buffer.size());
+		}
+		assert(buffer.capacity() > 16);
+		assert(buffer.getReadSize() >= 256);
+
+		for (int i = 0; i < 100; ++i) {
+			write(buffer, "small");
+			buffer.recordBurst(5);
+			assert(read(stream, 5) == "small");
+		}
+		//Some slack is kept, to avoid resizing back and forth.
+		assert(buffer.capacity() <= 32);
+	}
+
+	//A full buffer should always ask for more room.
+	{
+		RingBuffer buffer(16);
+		write(buffer, std::string(16, 'x'));
+		assert(buffer.getReadSize() > 0);
+	}
+
+	return 0;
+}
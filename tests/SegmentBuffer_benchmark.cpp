@@ -0,0 +1,170 @@
+// Compares the chained segment write buffer used by StreamSocket with the previous design,
+// where two boost::asio::streambuf instances were swapped each time a write was started.
+//
+// Ops are written in bursts through an std::ostream, as the Atlas encoder does, and each burst
+// is then written to a local socket pair which is drained by a background thread.
+
+#include "Eris/SegmentBuffer.h"
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+static std::atomic<std::size_t> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+	allocationCount++;
+	if (void* p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+
+const std::size_t opCount = 200000;
+const std::size_t burstSize = 64;
+
+/**
+ * Writes something that resembles an encoded movement op in the Bach codec.
+ */
+void writeOp(std::ostream& stream, std::size_t i)
+{
+	stream << "{arg:[{id:\"" << (i % 500) << "\",pos:[" << i * 0.5 << "," << i * 0.25 << ",12.5],velocity:[1.0,0.0,0.5],"
+		   << "stamp:" << i << "}],objtype:\"op\",parent:\"set\",from:\"" << (i % 500) << "\",serialno:" << i << "}";
+}
+
+struct Result
+{
+	double seconds;
+	std::size_t bytes;
+	std::size_t allocations;
+};
+
+void report(const std::string& name, const Result& result)
+{
+	std::cout << name << ": "
+			  << (static_cast<double>(result.bytes) / result.seconds) / (1024.0 * 1024.0) << " MiB/s, "
+			  << static_cast<double>(result.allocations) / opCount << " allocations/op" << std::endl;
+}
+
+template<typename WriterT>
+Result run()
+{
+	boost::asio::io_service io_service;
+	boost::asio::local::stream_protocol::socket writeSocket(io_service), readSocket(io_service);
+	boost::asio::local::connect_pair(writeSocket, readSocket);
+
+	std::atomic<bool> done(false);
+	std::thread drainer([&]() {
+		char buf[65536];
+		boost::system::error_code ec;
+		while (!ec) {
+			readSocket.read_some(boost::asio::buffer(buf), ec);
+		}
+	});
+
+	WriterT writer;
+	std::size_t bytes = 0;
+	auto allocationsBefore = allocationCount.load();
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < opCount; i += burstSize) {
+		for (std::size_t j = 0; j < burstSize; ++j) {
+			writeOp(writer.stream(), i + j);
+		}
+		bytes += writer.flush(writeSocket);
+	}
+	auto end = std::chrono::steady_clock::now();
+	auto allocations = allocationCount.load() - allocationsBefore;
+
+	writeSocket.close();
+	drainer.join();
+	done = true;
+
+	return Result{std::chrono::duration<double>(end - start).count(), bytes, allocations};
+}
+
+/**
+ * The design StreamSocket used previously.
+ */
+struct DoubleStreambufWriter
+{
+	std::unique_ptr<boost::asio::streambuf> writeBuffer;
+	std::unique_ptr<boost::asio::streambuf> sendBuffer;
+	std::ostream outStream;
+
+	DoubleStreambufWriter() :
+			writeBuffer(new boost::asio::streambuf()),
+			sendBuffer(new boost::asio::streambuf()),
+			outStream(writeBuffer.get())
+	{
+	}
+
+	std::ostream& stream()
+	{
+		return outStream;
+	}
+
+	template<typename SocketT>
+	std::size_t flush(SocketT& socket)
+	{
+		std::swap(writeBuffer, sendBuffer);
+		outStream.rdbuf(writeBuffer.get());
+		auto length = boost::asio::write(socket, sendBuffer->data());
+		sendBuffer->consume(length);
+		return length;
+	}
+};
+
+struct SegmentBufferWriter
+{
+	Eris::SegmentBuffer buffer;
+	std::ostream outStream;
+
+	SegmentBufferWriter() :
+			outStream(&buffer)
+	{
+	}
+
+	std::ostream& stream()
+	{
+		return outStream;
+	}
+
+	template<typename SocketT>
+	std::size_t flush(SocketT& socket)
+	{
+		auto length = boost::asio::write(socket, buffer.data());
+		buffer.consume(length);
+		return length;
+	}
+};
+
+}
+
+int main()
+{
+	//Run once to warm up.
+	run<SegmentBufferWriter>();
+
+	report("double streambuf", run<DoubleStreambufWriter>());
+	report("segment buffer", run<SegmentBufferWriter>());
+	return 0;
+}
@@ -0,0 +1,87 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/SegmentBuffer.h"
+
+#include <ostream>
+#include <string>
+#include <cassert>
+
+using namespace Eris;
+
+static std::string contents(SegmentBuffer& buffer)
+{
+	std::string result;
+	for (auto& entry : buffer.data()) {
+		result.append(static_cast<const char*>(entry.data()), entry.size());
+	}
+	return result;
+}
+
+int main()
+{
+	{
+		SegmentBuffer buffer(8);
+		assert(buffer.size() == 0);
+		assert(buffer.data().empty());
+		buffer.consume(10);
+		assert(buffer.size() == 0);
+	}
+
+	//Data spanning multiple blocks should be gathered in order.
+	{
+		SegmentBuffer buffer(8);
+		std::ostream stream(&buffer);
+		stream << "hello" << ' ' << "world, this spans blocks";
+		assert(buffer.size() == 30);
+		assert(buffer.data().size() == 4);
+		assert(contents(buffer) == "hello world, this spans blocks");
+	}
+
+	//Partial consumption, and appending while data is "in flight".
+	{
+		SegmentBuffer buffer(8);
+		std::ostream stream(&buffer);
+		stream << "0123456789";
+		auto inFlight = buffer.data();
+		assert(inFlight.size() == 2);
+		auto firstData = inFlight.begin()->data();
+		stream << "abcdef";
+		//The memory of the previously gathered buffers must not have moved.
+		assert(std::string(static_cast<const char*>(firstData), 8) == "01234567");
+		buffer.consume(10);
+		assert(buffer.size() == 6);
+		assert(contents(buffer) == "abcdef");
+		buffer.consume(3);
+		assert(contents(buffer) == "def");
+	}
+
+	//Blocks should be recycled once consumed.
+	{
+		SegmentBuffer buffer(16, 4);
+		std::ostream stream(&buffer);
+		for (int i = 0; i < 100; ++i) {
+			stream << "some op data " << i;
+			buffer.data();
+			buffer.consume(buffer.size());
+		}
+		assert(buffer.size() == 0);
+		assert(buffer.getBlockAllocations() <= 3);
+	}
+
+	//Single character writes should go through overflow correctly.
+	{
+		SegmentBuffer buffer(3);
+		std::ostream stream(&buffer);
+		for (char c = 'a'; c <= 'j'; ++c) {
+			stream.put(c);
+		}
+		assert(contents(buffer) == "abcdefghij");
+	}
+
+	return 0;
+}
@@ -0,0 +1,141 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/Log.h"
+#include "Eris/SharedMemoryStreamSocket.h"
+#include "Eris/StreamSocket_impl.h"
+
+#include <Atlas/Message/QueuedDecoder.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Eris;
+using boost::asio::local::stream_protocol;
+
+namespace
+{
+
+/**
+ * Stands in for a server supporting shared memory.
+ */
+struct Peer
+{
+	Peer(boost::asio::io_service& io_service, const std::string& path) :
+			acceptor(io_service, stream_protocol::endpoint(path)),
+			socket(io_service)
+	{
+	}
+
+	/**
+	 * Receives the channel sent by the client, and replies to it.
+	 */
+	void receiveChannel(bool acceptChannel)
+	{
+		channel = SharedMemoryChannel::receiveHandshake(socket.native_handle());
+		char reply = acceptChannel ? SharedMemoryChannel::ACCEPTED : 'N';
+		boost::asio::write(socket, boost::asio::buffer(&reply, 1));
+	}
+
+	void send(const std::string& data)
+	{
+		assert(channel->outgoing().write(data.data(), data.size()) == data.size());
+		channel->wakePeerIfWaiting();
+	}
+
+	std::string receive()
+	{
+		std::string data(channel->incoming().readable(), '\0');
+		channel->incoming().read(&data[0], data.size());
+		channel->wakePeerIfWaiting();
+		return data;
+	}
+
+	stream_protocol::acceptor acceptor;
+	stream_protocol::socket socket;
+	std::unique_ptr<SharedMemoryChannel> channel;
+};
+
+}
+
+int main()
+{
+	boost::asio::io_service io_service;
+	Atlas::Message::QueuedDecoder bridge;
+	std::string path = "SharedMemoryStreamSocket_unittest.socket";
+	std::remove(path.c_str());
+
+	std::vector<StreamSocket::Status> states;
+	StreamSocket::Callbacks callbacks;
+	callbacks.dispatch = [] {};
+	callbacks.stateChanged = [&](StreamSocket::Status status) {
+		states.push_back(status);
+	};
+
+	//The negotiation should go through the shared memory, and the socket only be used to notice the server going away.
+	{
+		Peer peer(io_service, path);
+		auto socket = std::make_shared<SharedMemoryStreamSocket>(io_service, "test", bridge, callbacks, 4096);
+		socket->connect(stream_protocol::endpoint(path));
+		peer.acceptor.accept(peer.socket);
+		//The channel is sent once the connection has been established.
+		while (states.empty()) {
+			io_service.run_one();
+		}
+		peer.receiveChannel(true);
+
+		std::string greeting("ATLAS server\n");
+		peer.send(greeting);
+		while (socket->getStatistics().bytesRead < greeting.size()) {
+			io_service.run_one();
+		}
+		assert(states.front() == StreamSocket::NEGOTIATE);
+
+		//What the client sent during the negotiation should be in the ring, and not on the socket.
+		std::string received;
+		while (received.find('\n') == std::string::npos) {
+			received += peer.receive();
+			io_service.poll();
+		}
+		assert(received.compare(0, 6, "ATLAS ") == 0);
+		assert(peer.socket.available() == 0);
+		assert(socket->getQueuedBytes() == 0);
+
+		states.clear();
+		peer.socket.close();
+		while (states.empty()) {
+			io_service.run_one();
+		}
+		assert(states.back() == StreamSocket::CONNECTION_FAILED);
+		socket->detach();
+	}
+	std::remove(path.c_str());
+
+	//If the server doesn't accept the channel the negotiation should fail.
+	{
+		states.clear();
+		Peer peer(io_service, path);
+		auto socket = std::make_shared<SharedMemoryStreamSocket>(io_service, "test", bridge, callbacks, 4096);
+		socket->connect(stream_protocol::endpoint(path));
+		peer.acceptor.accept(peer.socket);
+		//The channel is sent once the connection has been established.
+		while (states.empty()) {
+			io_service.run_one();
+		}
+		peer.receiveChannel(false);
+		while (std::find(states.begin(), states.end(), StreamSocket::NEGOTIATE_FAILED) == states.end()) {
+			io_service.run_one();
+		}
+		socket->detach();
+	}
+	std::remove(path.c_str());
+
+	return 0;
+}
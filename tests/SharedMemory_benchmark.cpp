@@ -0,0 +1,208 @@
+// Compares the throughput and client CPU usage of receiving data from a local server through a Unix domain socket,
+// as AsioStreamSocket<local::stream_protocol> does, and through the rings of a SharedMemoryChannel, as
+// SharedMemoryStreamSocket does.
+//
+// A server thread sends data in messages of a fixed size, as fast as the client can take it. The client reads
+// it into a RingBuffer and consumes it, in the same way as the sockets do. Only the CPU time of the client
+// thread is measured.
+
+#include "Eris/RingBuffer.h"
+#include "Eris/SharedMemoryChannel.h"
+
+#include <boost/asio.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using boost::asio::local::stream_protocol;
+
+namespace {
+
+const std::size_t totalBytes = 256 * 1024 * 1024;
+const std::size_t ringCapacity = 1024 * 1024;
+
+double getThreadCpuSeconds()
+{
+	timespec ts{};
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+/**
+ * Reads everything available from the buffer, as the codec would.
+ */
+void consume(Eris::RingBuffer& buffer, std::vector<char>& scratch)
+{
+	while (buffer.sgetn(scratch.data(), static_cast<std::streamsize>(scratch.size())) > 0) {
+	}
+}
+
+struct Result
+{
+	double elapsed;
+	double cpu;
+	std::size_t wakeups;
+};
+
+void report(const std::string& name, std::size_t messageSize, const Result& result)
+{
+	std::cout << name << " (" << messageSize << " byte messages): "
+			  << static_cast<long>(static_cast<double>(totalBytes) / (1024 * 1024) / result.elapsed) << " MB/s, "
+			  << result.cpu * 1e9 / static_cast<double>(totalBytes) << " ns client CPU per byte, "
+			  << result.wakeups << " wakeups" << std::endl;
+}
+
+Result runSocket(std::size_t messageSize)
+{
+	boost::asio::io_service io_service;
+	stream_protocol::socket client(io_service);
+	stream_protocol::socket server(io_service);
+	boost::asio::local::connect_pair(client, server);
+	client.non_blocking(true);
+
+	std::thread serverThread([&]() {
+		std::vector<char> message(messageSize, 'x');
+		for (std::size_t sent = 0; sent < totalBytes; sent += messageSize) {
+			boost::asio::write(server, boost::asio::buffer(message));
+		}
+	});
+
+	Eris::RingBuffer buffer;
+	std::vector<char> scratch(64 * 1024);
+	std::size_t received = 0;
+	Result result{0, 0, 0};
+	auto start = std::chrono::steady_clock::now();
+	auto cpuStart = getThreadCpuSeconds();
+
+	std::function<void()> read = [&]() {
+		client.async_read_some(buffer.prepare(buffer.getReadSize()), [&](boost::system::error_code ec, std::size_t length) {
+			if (ec) {
+				std::cerr << "Read failed." << std::endl;
+				return;
+			}
+			result.wakeups++;
+			buffer.commit(length);
+			auto burst = length;
+			//Drain the socket, as AsioStreamSocket does.
+			boost::system::error_code drainEc;
+			while (!drainEc) {
+				auto drained = client.read_some(buffer.prepare(buffer.getReadSize()), drainEc);
+				buffer.commit(drained);
+				burst += drained;
+			}
+			buffer.recordBurst(burst);
+			received += burst;
+			consume(buffer, scratch);
+			if (received < totalBytes) {
+				read();
+			}
+		});
+	};
+	read();
+	io_service.run();
+
+	result.cpu = getThreadCpuSeconds() - cpuStart;
+	result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	serverThread.join();
+	return result;
+}
+
+Result runSharedMemory(std::size_t messageSize)
+{
+	boost::asio::io_service io_service;
+	stream_protocol::socket clientSocket(io_service);
+	stream_protocol::socket serverSocket(io_service);
+	boost::asio::local::connect_pair(clientSocket, serverSocket);
+
+	auto channel = Eris::SharedMemoryChannel::create(ringCapacity);
+	channel->sendHandshake(clientSocket.native_handle());
+	auto serverChannel = Eris::SharedMemoryChannel::receiveHandshake(serverSocket.native_handle());
+
+	std::thread serverThread([&]() {
+		std::vector<char> message(messageSize, 'x');
+		auto& ring = serverChannel->outgoing();
+		for (std::size_t sent = 0; sent < totalBytes; sent += messageSize) {
+			std::size_t offset = 0;
+			while (offset < messageSize) {
+				offset += ring.write(message.data() + offset, messageSize - offset);
+				serverChannel->wakePeerIfWaiting();
+				if (offset < messageSize && ring.prepareToWaitForSpace()) {
+					pollfd fd{serverChannel->getWakeDescriptor(), POLLIN, 0};
+					::poll(&fd, 1, -1);
+					std::uint64_t count;
+					(void) ::read(fd.fd, &count, sizeof(count));
+				}
+			}
+		}
+	});
+
+	boost::asio::posix::stream_descriptor wake(io_service, ::dup(channel->getWakeDescriptor()));
+	std::uint64_t wakeCount = 0;
+	Eris::RingBuffer buffer;
+	std::vector<char> scratch(64 * 1024);
+	std::size_t received = 0;
+	Result result{0, 0, 0};
+	auto start = std::chrono::steady_clock::now();
+	auto cpuStart = getThreadCpuSeconds();
+
+	//The same steps as SharedMemoryStreamSocket::transfer().
+	std::function<void()> transfer = [&]() {
+		auto& ring = channel->incoming();
+		while (received < totalBytes) {
+			std::size_t burst = 0;
+			std::size_t available;
+			while ((available = ring.readable()) > 0) {
+				std::size_t length = 0;
+				for (auto& region : buffer.prepare(available)) {
+					length += ring.read(static_cast<char*>(region.data()), region.size());
+				}
+				buffer.commit(length);
+				burst += length;
+			}
+			channel->wakePeerIfWaiting();
+			if (burst > 0) {
+				buffer.recordBurst(burst);
+				received += burst;
+				consume(buffer, scratch);
+				continue;
+			}
+			if (ring.prepareToWaitForData()) {
+				wake.async_read_some(boost::asio::buffer(&wakeCount, sizeof(wakeCount)), [&](boost::system::error_code ec, std::size_t) {
+					if (ec) {
+						std::cerr << "Wait failed." << std::endl;
+						return;
+					}
+					result.wakeups++;
+					transfer();
+				});
+				return;
+			}
+		}
+	};
+	transfer();
+	io_service.run();
+
+	result.cpu = getThreadCpuSeconds() - cpuStart;
+	result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	serverThread.join();
+	return result;
+}
+
+}
+
+int main()
+{
+	for (std::size_t messageSize : {256, 4096, 65536}) {
+		report("Unix domain socket", messageSize, runSocket(messageSize));
+		report("shared memory", messageSize, runSharedMemory(messageSize));
+	}
+	return 0;
+}
@@ -0,0 +1,169 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/ShmRing.h"
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Eris;
+
+namespace
+{
+struct Memory
+{
+	explicit Memory(std::size_t capacity) : storage(ShmRing::mappingSize(capacity) / 64 + 1)
+	{
+	}
+
+	void* get()
+	{
+		return storage.data();
+	}
+
+	struct alignas(64) CacheLine
+	{
+		char bytes[64];
+	};
+	std::vector<CacheLine> storage;
+};
+}
+
+int main()
+{
+	//Data should come out as it went in, also when wrapping around the end.
+	{
+		Memory memory(16);
+		ShmRing::initialize(memory.get(), 16);
+		ShmRing writer(memory.get(), 16);
+		ShmRing reader(memory.get(), 16);
+		assert(reader.readable() == 0);
+		assert(writer.writable() == 16);
+
+		char buffer[16];
+		for (int i = 0; i < 10; ++i) {
+			std::string data = "0123456789" + std::to_string(i);
+			assert(writer.write(data.data(), data.size()) == data.size());
+			assert(reader.readable() == data.size());
+			assert(reader.read(buffer, sizeof(buffer)) == data.size());
+			assert(std::string(buffer, data.size()) == data);
+		}
+	}
+
+	//Writes should stop when the ring is full.
+	{
+		Memory memory(16);
+		ShmRing::initialize(memory.get(), 16);
+		ShmRing ring(memory.get(), 16);
+		std::string data(20, 'x');
+		assert(ring.write(data.data(), data.size()) == 16);
+		assert(ring.writable() == 0);
+		assert(ring.write(data.data(), data.size()) == 0);
+		char buffer[4];
+		assert(ring.read(buffer, sizeof(buffer)) == 4);
+		assert(ring.writable() == 4);
+	}
+
+	//The reader should only need waking if it said it was about to wait.
+	{
+		Memory memory(16);
+		ShmRing::initialize(memory.get(), 16);
+		ShmRing ring(memory.get(), 16);
+		ring.write("a", 1);
+		assert(!ring.shouldWakeReader());
+		//There's data, so the reader shouldn't wait.
+		assert(!ring.prepareToWaitForData());
+		char buffer[1];
+		ring.read(buffer, 1);
+		assert(ring.prepareToWaitForData());
+		ring.write("b", 1);
+		assert(ring.shouldWakeReader());
+		//Only once.
+		assert(!ring.shouldWakeReader());
+	}
+
+	//The same goes for the writer waiting for space.
+	{
+		Memory memory(16);
+		ShmRing::initialize(memory.get(), 16);
+		ShmRing ring(memory.get(), 16);
+		std::string data(16, 'x');
+		ring.write(data.data(), data.size());
+		assert(ring.prepareToWaitForSpace());
+		char buffer[1];
+		ring.read(buffer, 1);
+		assert(ring.shouldWakeWriter());
+		assert(!ring.shouldWakeWriter());
+		assert(!ring.prepareToWaitForSpace());
+	}
+
+	//Attaching with the wrong capacity should fail.
+	{
+		Memory memory(16);
+		ShmRing::initialize(memory.get(), 16);
+		bool threw = false;
+		try {
+			ShmRing ring(memory.get(), 32);
+		} catch (const std::invalid_argument&) {
+			threw = true;
+		}
+		assert(threw);
+	}
+
+	//Data should pass unharmed between threads.
+	{
+		const std::size_t capacity = 4096;
+		const std::size_t total = 16 * 1024 * 1024;
+		Memory memory(capacity);
+		ShmRing::initialize(memory.get(), capacity);
+		ShmRing writer(memory.get(), capacity);
+		ShmRing reader(memory.get(), capacity);
+
+		std::thread producer([&]() {
+			std::vector<char> chunk(1000);
+			std::size_t sent = 0;
+			while (sent < total) {
+				auto size = std::min(chunk.size(), total - sent);
+				for (std::size_t i = 0; i < size; ++i) {
+					chunk[i] = static_cast<char>((sent + i) % 251);
+				}
+				std::size_t offset = 0;
+				while (offset < size) {
+					auto length = writer.write(chunk.data() + offset, size - offset);
+					if (length == 0) {
+						std::this_thread::yield();
+					}
+					offset += length;
+				}
+				sent += size;
+			}
+		});
+
+		std::vector<char> buffer(1500);
+		std::size_t received = 0;
+		bool valid = true;
+		while (received < total) {
+			auto length = reader.read(buffer.data(), buffer.size());
+			if (length == 0) {
+				std::this_thread::yield();
+			}
+			for (std::size_t i = 0; i < length; ++i) {
+				valid = valid && buffer[i] == static_cast<char>((received + i) % 251);
+			}
+			received += length;
+		}
+		producer.join();
+		assert(valid);
+		assert(reader.readable() == 0);
+	}
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+// Measures the bandwidth saved by the stream compression, and the time spent compressing and decompressing.
+//
+// The data resembles what's received when first entering a large world: bursts of Sight ops of entities,
+// followed by type info responses. Each burst is flushed as a whole, as the socket does before each write.
+
+#include "Eris/StreamCompression.h"
+#include "Eris/SegmentBuffer.h"
+#include "Eris/RingBuffer.h"
+
+#include <boost/asio/buffer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int burstCount = 50;
+const int opsPerBurst = 200;
+
+std::vector<std::string> makeBursts()
+{
+	std::vector<std::string> bursts;
+	for (int burst = 0; burst < burstCount; ++burst) {
+		std::stringstream ss;
+		for (int i = 0; i < opsPerBurst; ++i) {
+			int id = burst * opsPerBurst + i;
+			if (burst % 5 == 4) {
+				ss << "{objtype:\"op\",parent:\"info\",args:[{objtype:\"class\",id:\"type_" << id << "\",parent:\"thing\","
+				   << "properties:{bbox:[-0.5,-0.5,0,0.5,0.5,1.8],mass:" << id % 70 << ",mode:\"fixed\",present:\"dural/" << id << ".entitymap\","
+				   << "usages:{consume:{name:\"Consume\",constraint:\"actor can_reach entity\"}}}}],refno:" << id << ",to:\"1\"}";
+			} else {
+				ss << "{objtype:\"op\",parent:\"sight\",args:[{objtype:\"obj\",id:\"" << id << "\",parent:\"oak\",loc:\"0\","
+				   << "pos:[" << (id * 7919) % 1000 << "." << id % 10 << ",0," << (id * 104729) % 1000 << ".25],"
+				   << "orientation:[0,0." << id % 97 << ",0,0.9],bbox:[-1,0,-1,1,8.5,1],stamp:" << 1000 + id << ","
+				   << "contains:[],mode:\"planted\",name:\"oak tree\"}],to:\"1\",seconds:" << 10.5 + id << "}";
+			}
+		}
+		bursts.push_back(ss.str());
+	}
+	return bursts;
+}
+
+void run(const std::string& name, Eris::StreamCompression& compression, const std::vector<std::string>& bursts)
+{
+	Eris::SegmentBuffer writeBuffer;
+	Eris::RingBuffer readBuffer;
+	auto compressor = compression.createCompressor(writeBuffer);
+	auto decompressor = compression.createDecompressor(readBuffer);
+	std::ostream out(compressor.get());
+
+	std::size_t rawBytes = 0, compressedBytes = 0;
+	std::chrono::steady_clock::duration compressTime{}, decompressTime{};
+	std::vector<char> decoded(1024 * 1024);
+
+	for (auto& burst : bursts) {
+		auto start = std::chrono::steady_clock::now();
+		out << burst;
+		out.flush();
+		compressTime += std::chrono::steady_clock::now() - start;
+
+		auto size = writeBuffer.size();
+		auto buffers = readBuffer.prepare(size);
+		boost::asio::buffer_copy(buffers, writeBuffer.data());
+		readBuffer.commit(size);
+		writeBuffer.consume(size);
+
+		start = std::chrono::steady_clock::now();
+		std::size_t decodedSize = 0;
+		std::streamsize count;
+		while ((count = decompressor->in_avail()) > 0) {
+			decodedSize += static_cast<std::size_t>(decompressor->sgetn(decoded.data(), std::min<std::streamsize>(count, decoded.size())));
+		}
+		decompressTime += std::chrono::steady_clock::now() - start;
+
+		if (decodedSize != burst.size()) {
+			std::cerr << "Decompressed size mismatch." << std::endl;
+		}
+		rawBytes += burst.size();
+		compressedBytes += size;
+	}
+
+	auto perBurstMicros = [](std::chrono::steady_clock::duration duration) {
+		return std::chrono::duration<double, std::micro>(duration).count() / burstCount;
+	};
+	std::cout << name << ": " << rawBytes << " bytes -> " << compressedBytes << " bytes ("
+			  << 100.0 * static_cast<double>(compressedBytes) / static_cast<double>(rawBytes) << "%), "
+			  << perBurstMicros(compressTime) << " us compression and "
+			  << perBurstMicros(decompressTime) << " us decompression per burst" << std::endl;
+}
+
+}
+
+int main()
+{
+	auto bursts = makeBursts();
+
+	Eris::DeflateCompression fast(Eris::DeflateCompression::getAtlasDictionary(), 1);
+	Eris::DeflateCompression withDictionary;
+	Eris::DeflateCompression withoutDictionary("");
+
+	run("deflate level 1, dictionary", fast, bursts);
+	run("deflate level 6, dictionary", withDictionary, bursts);
+	run("deflate level 6, no dictionary", withoutDictionary, bursts);
+	return 0;
+}
@@ -0,0 +1,167 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/StreamCompression.h"
+#include "Eris/SegmentBuffer.h"
+#include "Eris/RingBuffer.h"
+#include "Eris/Exceptions.h"
+
+#include <boost/asio.hpp>
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cassert>
+
+using namespace Eris;
+
+static std::string makeOp(int i)
+{
+	std::stringstream ss;
+	ss << "{objtype:\"op\",parent:\"sight\",args:[{objtype:\"obj\",id:\"" << i << "\",parent:\"thing\",loc:\"0\",pos:["
+	   << i * 0.5 << ",0," << i * 0.25 << "],stamp:" << i << "}],to:\"1\"}";
+	return ss.str();
+}
+
+/**
+ * Moves all data from the write buffer into the read buffer, as if it had been sent over a socket.
+ */
+static std::size_t transfer(SegmentBuffer& from, RingBuffer& to)
+{
+	auto size = from.size();
+	auto buffers = to.prepare(size);
+	boost::asio::buffer_copy(buffers, from.data());
+	to.commit(size);
+	from.consume(size);
+	return size;
+}
+
+static std::string readAll(std::istream& stream)
+{
+	std::string result;
+	auto buf = stream.rdbuf();
+	std::streamsize count;
+	while ((count = buf->in_avail()) > 0) {
+		for (std::streamsize i = 0; i < count; ++i) {
+			result += static_cast<char>(buf->sbumpc());
+		}
+	}
+	return result;
+}
+
+int main()
+{
+	//Data should make it through in one piece, and should be readable as soon as it's been flushed.
+	for (auto& dictionary : {DeflateCompression::getAtlasDictionary(), std::string()}) {
+		DeflateCompression compression(dictionary);
+		SegmentBuffer writeBuffer;
+		RingBuffer readBuffer;
+		auto compressor = compression.createCompressor(writeBuffer);
+		auto decompressor = compression.createDecompressor(readBuffer);
+		std::ostream out(compressor.get());
+		std::istream in(decompressor.get());
+
+		std::string expected;
+		std::size_t compressedSize = 0;
+		for (int i = 0; i < 100; ++i) {
+			auto op = makeOp(i);
+			out << op;
+			expected += op;
+		}
+		out.flush();
+		compressedSize += transfer(writeBuffer, readBuffer);
+		assert(readAll(in) == expected);
+		assert(compressedSize * 3 < expected.size());
+
+		out << makeOp(1000);
+		out.flush();
+		transfer(writeBuffer, readBuffer);
+		assert(readAll(in) == makeOp(1000));
+
+		//Nothing should be written if nothing has been added.
+		out.flush();
+		assert(writeBuffer.size() == 0);
+	}
+
+	//Using the wrong dictionary should be reported.
+	{
+		DeflateCompression compressionA("a dictionary"), compressionB("another dictionary");
+		SegmentBuffer writeBuffer;
+		RingBuffer readBuffer;
+		auto compressor = compressionA.createCompressor(writeBuffer);
+		auto decompressor = compressionB.createDecompressor(readBuffer);
+		std::ostream out(compressor.get());
+		out << makeOp(1);
+		out.flush();
+		transfer(writeBuffer, readBuffer);
+		bool thrown = false;
+		try {
+			decompressor->sgetc();
+		} catch (const NetworkFailure&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	//Send compressed data to an echo server over a socket, and read it back in small chunks.
+	{
+		boost::asio::io_service io_service;
+		boost::asio::local::stream_protocol::socket client(io_service), server(io_service);
+		boost::asio::local::connect_pair(client, server);
+
+		std::thread echoServer([&]() {
+			char buf[512];
+			boost::system::error_code ec;
+			while (true) {
+				auto length = server.read_some(boost::asio::buffer(buf), ec);
+				if (ec) {
+					break;
+				}
+				boost::asio::write(server, boost::asio::buffer(buf, length));
+			}
+		});
+
+		DeflateCompression compression;
+		SegmentBuffer writeBuffer;
+		RingBuffer readBuffer(64);
+		auto compressor = compression.createCompressor(writeBuffer);
+		auto decompressor = compression.createDecompressor(readBuffer);
+		std::ostream out(compressor.get());
+		std::istream in(decompressor.get());
+
+		std::string expected;
+		std::string received;
+		std::size_t sent = 0;
+		for (int burst = 0; burst < 10; ++burst) {
+			for (int i = 0; i < 50; ++i) {
+				auto op = makeOp(burst * 100 + i);
+				out << op;
+				expected += op;
+			}
+			out.flush();
+			auto length = boost::asio::write(client, writeBuffer.data());
+			writeBuffer.consume(length);
+			sent += length;
+		}
+
+		std::size_t echoed = 0;
+		while (echoed < sent) {
+			auto length = client.read_some(readBuffer.prepare(32));
+			readBuffer.commit(length);
+			echoed += length;
+			received += readAll(in);
+		}
+		assert(received == expected);
+
+		client.shutdown(boost::asio::socket_base::shutdown_both);
+		echoServer.join();
+	}
+
+	return 0;
+}
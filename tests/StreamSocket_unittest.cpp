@@ -0,0 +1,231 @@
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "Eris/Log.h"
+#include "Eris/StreamSocket_impl.h"
+#include "Eris/ReplayStreamSocket.h"
+#include "Eris/ReplayStreamSocket.h"
+
+#include <Atlas/Message/QueuedDecoder.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <cstdio>
+#include <cstdio>
+
+using namespace Eris;
+using boost::asio::ip::tcp;
+
+namespace
+{
+
+struct Result
+{
+	StreamSocket::Status status = StreamSocket::INVALID_STATUS;
+	std::chrono::steady_clock::duration elapsed{};
+};
+
+/**
+ * Connects to the endpoints, and runs until the connection has either been established or has failed.
+ */
+Result connect(boost::asio::io_service& io_service, Atlas::Bridge& bridge, const std::vector<tcp::endpoint>& endpoints,
+			   std::shared_ptr<ResolvableAsioStreamSocket<tcp>>& socket)
+{
+	Result result;
+	StreamSocket::Callbacks callbacks;
+	callbacks.dispatch = [] {};
+	callbacks.stateChanged = [&](StreamSocket::Status status) {
+		//The negotiation starting means that the connection was established.
+		if (status != StreamSocket::CONNECTING) {
+			result.status = status;
+		}
+	};
+	socket = std::make_shared<ResolvableAsioStreamSocket<tcp>>(io_service, "test", bridge, callbacks);
+	auto start = std::chrono::steady_clock::now();
+	socket->connect(endpoints);
+	while (result.status == StreamSocket::INVALID_STATUS) {
+		io_service.run_one();
+	}
+	result.elapsed = std::chrono::steady_clock::now() - start;
+	socket->detach();
+	return result;
+}
+
+}
+
+int main()
+{
+	//Address families should alternate, keeping the order within each family.
+	{
+		auto v6a = tcp::endpoint(boost::asio::ip::make_address("::1"), 1);
+		auto v6b = tcp::endpoint(boost::asio::ip::make_address("::1"), 2);
+		auto v6c = tcp::endpoint(boost::asio::ip::make_address("::1"), 3);
+		auto v4a = tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 1);
+		auto v4b = tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 2);
+		auto result = ResolvableAsioStreamSocket<tcp>::interleaveAddressFamilies({v6a, v6b, v6c, v4a, v4b});
+		assert((result == std::vector<tcp::endpoint>{v6a, v4a, v6b, v4b, v6c}));
+	}
+
+	//Codecs should be filtered and ordered by preference, ignoring version suffixes.
+	{
+		std::vector<std::string> offered{"Bach_beta2", "XML", "Packed"};
+		assert((StreamSocket::orderCodecs(offered, {"Packed", "Bach"}) == std::vector<std::string>{"Packed", "Bach_beta2"}));
+		assert((StreamSocket::orderCodecs(offered, {"XML"}) == std::vector<std::string>{"XML"}));
+		assert((StreamSocket::orderCodecs(offered, {"Ba"}) == offered));
+		assert((StreamSocket::orderCodecs(offered, {"Unknown"}) == offered));
+	}
+
+	boost::asio::io_service io_service;
+	Atlas::Message::QueuedDecoder bridge;
+	auto loopback = boost::asio::ip::address_v4::loopback();
+
+	//A listener which accepts connections.
+	tcp::acceptor listening(io_service, tcp::endpoint(loopback, 0));
+
+	//A listener which doesn't respond to connection attempts, since its backlog is full.
+	tcp::acceptor blackHoled(io_service);
+	blackHoled.open(tcp::v4());
+	blackHoled.bind(tcp::endpoint(loopback, 0));
+	blackHoled.listen(0);
+	tcp::socket filler(io_service);
+	filler.connect(blackHoled.local_endpoint());
+
+	//A port which refuses connections.
+	tcp::endpoint refusing;
+	{
+		tcp::acceptor closed(io_service, tcp::endpoint(loopback, 0));
+		refusing = closed.local_endpoint();
+	}
+
+	//If the first address doesn't respond, the next should be tried without waiting for the connection timeout.
+	{
+		std::shared_ptr<ResolvableAsioStreamSocket<tcp>> socket;
+		auto result = connect(io_service, bridge, {blackHoled.local_endpoint(), listening.local_endpoint()}, socket);
+		assert(result.status == StreamSocket::NEGOTIATE);
+		assert(result.elapsed < std::chrono::seconds(CONNECT_TIMEOUT_SECONDS));
+		assert(socket->getAsioSocket().remote_endpoint() == listening.local_endpoint());
+
+		auto& attempts = socket->getConnectAttempts();
+		assert(attempts.size() == 2);
+		assert(attempts[0].endpoint == listening.local_endpoint());
+		assert(!attempts[0].error);
+		//The attempt which didn't respond should have been cancelled.
+		assert(attempts[1].endpoint == blackHoled.local_endpoint());
+		assert(attempts[1].error == boost::asio::error::operation_aborted);
+		assert(attempts[1].duration >= std::chrono::milliseconds(CONNECT_ATTEMPT_DELAY_MILLISECONDS));
+	}
+
+	//Failed attempts should move on to the next address right away.
+	{
+		std::shared_ptr<ResolvableAsioStreamSocket<tcp>> socket;
+		auto result = connect(io_service, bridge, {refusing, listening.local_endpoint()}, socket);
+		assert(result.status == StreamSocket::NEGOTIATE);
+		assert(result.elapsed < std::chrono::milliseconds(CONNECT_ATTEMPT_DELAY_MILLISECONDS));
+		auto& attempts = socket->getConnectAttempts();
+		assert(attempts.size() == 2);
+		assert(attempts[0].endpoint == refusing);
+		assert(attempts[0].error);
+		assert(!attempts[1].error);
+	}
+
+	//If no address accepts the connection it should fail.
+	{
+		std::shared_ptr<ResolvableAsioStreamSocket<tcp>> socket;
+		auto result = connect(io_service, bridge, {refusing, refusing}, socket);
+		assert(result.status == StreamSocket::CONNECTING_FAILED);
+		assert(socket->getConnectAttempts().size() == 2);
+	}
+
+	//Only the preferred codecs should be offered to the server.
+	{
+		Result result;
+		StreamSocket::Callbacks callbacks;
+		callbacks.dispatch = [] {};
+		callbacks.stateChanged = [&](StreamSocket::Status status) {
+			result.status = status;
+		};
+		tcp::acceptor acceptor(io_service, tcp::endpoint(loopback, 0));
+		auto socket = std::make_shared<ResolvableAsioStreamSocket<tcp>>(io_service, "test", bridge, callbacks);
+		socket->setCodecPreference({"XML"});
+		socket->connect(std::vector<tcp::endpoint>{acceptor.local_endpoint()});
+		tcp::socket server(io_service);
+		acceptor.accept(server);
+		boost::asio::write(server, boost::asio::buffer(std::string("ATLAS server\n")));
+
+		boost::asio::streambuf received;
+		bool codecsReceived = false;
+		boost::asio::async_read_until(server, received, "\n\n", [&](boost::system::error_code ec, std::size_t) {
+			assert(!ec);
+			codecsReceived = true;
+		});
+		while (!codecsReceived) {
+			io_service.run_one();
+		}
+		std::string negotiation(boost::asio::buffers_begin(received.data()), boost::asio::buffers_end(received.data()));
+		assert(negotiation.find("ICAN XML\n") != std::string::npos);
+		assert(negotiation.find("ICAN Packed") == std::string::npos);
+		assert(negotiation.find("ICAN Bach") == std::string::npos);
+		socket->detach();
+	}
+
+	//Received data should be captured, and replaying the capture should feed the same data to the client.
+	{
+		std::string capturePath = "StreamSocket_unittest.capture";
+		std::string serverGreeting("ATLAS server\n");
+		{
+			StreamSocket::Callbacks callbacks;
+			callbacks.dispatch = [] {};
+			callbacks.stateChanged = [](StreamSocket::Status) {};
+			tcp::acceptor acceptor(io_service, tcp::endpoint(loopback, 0));
+			auto socket = std::make_shared<ResolvableAsioStreamSocket<tcp>>(io_service, "test", bridge, callbacks);
+			auto capture = std::make_shared<CaptureWriter>(capturePath);
+			socket->setCapture(capture);
+			socket->connect(std::vector<tcp::endpoint>{acceptor.local_endpoint()});
+			tcp::socket server(io_service);
+			acceptor.accept(server);
+			boost::asio::write(server, boost::asio::buffer(serverGreeting));
+			while (socket->getStatistics().bytesRead < serverGreeting.size()) {
+				io_service.run_one();
+			}
+			socket->detach();
+			assert(capture->getRecordCount() >= 1);
+			capture->flush();
+		}
+
+		auto reader = std::make_shared<CaptureReader>(capturePath);
+		std::string captured;
+		CaptureReader::Record record{};
+		while (reader->next(record)) {
+			captured.append(record.data, record.size);
+		}
+		assert(captured == serverGreeting);
+		reader->rewind();
+
+		std::vector<StreamSocket::Status> states;
+		StreamSocket::Callbacks callbacks;
+		callbacks.dispatch = [] {};
+		callbacks.stateChanged = [&](StreamSocket::Status status) {
+			states.push_back(status);
+		};
+		auto socket = std::make_shared<ReplayStreamSocket>(io_service, "test", bridge, callbacks, reader, ReplayStreamSocket::Pacing::FAST);
+		socket->connect();
+		//Once all data has been fed the connection should be reported as closed, as when a server disconnects.
+		while (std::find(states.begin(), states.end(), StreamSocket::CONNECTION_FAILED) == states.end()) {
+			io_service.run_one();
+		}
+		assert(states.front() == StreamSocket::NEGOTIATE);
+		assert(socket->getStatistics().bytesRead == serverGreeting.size());
+		//Whatever the client sent should have been discarded.
+		assert(socket->getStatistics().bytesWritten > 0);
+		assert(socket->getQueuedBytes() == 0);
+		socket->detach();
+		std::remove(capturePath.c_str());
+	}
+
+	return 0;
+}
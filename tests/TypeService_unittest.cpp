@@ -24,7 +24,123 @@
 #define DEBUG
 #endif
 
+#include <Eris/Connection.h>
+#include <Eris/EventService.h>
+#include <Eris/TypeInfo.h>
+#include <Eris/TypeService.h>
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+
+static Atlas::Objects::Operation::Info makeTypeInfo(const std::string& name, const std::string& parent)
+{
+    Atlas::Objects::Entity::Anonymous type;
+    type->setObjtype("class");
+    type->setId(name);
+    type->setParent(parent);
+    Atlas::Objects::Operation::Info info;
+    info->setArgs1(type);
+    return info;
+}
+
+static Atlas::Objects::Operation::Sight makeSight(const std::string& id, const std::string& parent)
+{
+    Atlas::Objects::Entity::Anonymous entity;
+    entity->setId(id);
+    entity->setParent(parent);
+    Atlas::Objects::Operation::Sight sight;
+    sight->setArgs1(entity);
+    return sight;
+}
+
 int main()
 {
+    // Test that ops waiting for a type are posted in one go once it's bound
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        Eris::Connection con(io_service, event_service, "name", "localhost", 6767);
+        auto& typeService = con.getTypeService();
+
+        auto thing = typeService.getTypeByName("thing");
+        auto other = typeService.getTypeByName("other");
+        assert(!thing->isBound());
+        typeService.redispatchWhenBound(thing, makeSight("1", "thing"));
+        typeService.redispatchWhenBound(other, makeSight("2", "other"));
+        typeService.redispatchWhenBound(thing, makeSight("3", "thing"));
+        auto statistics = typeService.getWaitingOpsStatistics();
+        assert(statistics.ops == 3);
+        assert(statistics.objects == 6);
+        assert(statistics.peakObjects == 6);
+
+        typeService.handleOperation(makeTypeInfo("thing", "root"));
+        assert(thing->isBound());
+        assert(con.getDispatchQueueStatistics().depth == 2);
+        statistics = typeService.getWaitingOpsStatistics();
+        assert(statistics.ops == 1);
+        assert(statistics.redispatched == 2);
+
+        // Ops waiting for a type the server doesn't know are dropped.
+        Atlas::Objects::Entity::Anonymous request;
+        request->setId("other");
+        Atlas::Objects::Operation::Get get;
+        get->setArgs1(request);
+        Atlas::Objects::Operation::Error error;
+        error->setArgs1(get);
+        typeService.handleOperation(error);
+        statistics = typeService.getWaitingOpsStatistics();
+        assert(statistics.ops == 0);
+        assert(statistics.objects == 0);
+        assert(statistics.peakObjects == 6);
+        assert(statistics.dropped == 1);
+        assert(con.getDispatchQueueStatistics().depth == 2);
+    }
+
+    // Test that types the server doesn't know are no longer found by class number
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        Eris::Connection con(io_service, event_service, "name", "localhost", 6767);
+        auto& typeService = con.getTypeService();
+
+        auto thing = typeService.getTypeByName("thing");
+        typeService.handleOperation(makeTypeInfo("thing", "root"));
+        assert(thing->isBound());
+        Atlas::Objects::Entity::Anonymous entity;
+        entity->setId("1");
+        entity->setParent("thing");
+        assert(typeService.getTypeForAtlas(entity) == thing);
+
+        Atlas::Objects::Entity::Anonymous request;
+        request->setId("thing");
+        Atlas::Objects::Operation::Get get;
+        get->setArgs1(request);
+        Atlas::Objects::Operation::Error error;
+        error->setArgs1(get);
+        typeService.handleOperation(error);
+        assert(typeService.findTypeByName("thing") == nullptr);
+
+        auto type = typeService.getTypeForAtlas(entity);
+        assert(type == typeService.findTypeByName("thing"));
+        assert(!type->isBound());
+    }
+
+    // Test that ops are dropped once the limit has been reached
+    {
+        boost::asio::io_service io_service;
+        Eris::EventService event_service(io_service);
+        Eris::Connection con(io_service, event_service, "name", "localhost", 6767);
+        auto& typeService = con.getTypeService();
+
+        auto thing = typeService.getTypeByName("thing");
+        typeService.setWaitingObjectsLimit(1);
+        typeService.redispatchWhenBound(thing, makeSight("1", "thing"));
+        auto statistics = typeService.getWaitingOpsStatistics();
+        assert(statistics.ops == 0);
+        assert(statistics.dropped == 1);
+    }
+
     return 0;
 }
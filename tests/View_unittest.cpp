@@ -24,7 +24,133 @@
 #define DEBUG
 #endif
 
+#include <Eris/Account.h>
+#include <Eris/Avatar.h>
+#include <Eris/Connection.h>
+#include <Eris/EventService.h>
+#include <Eris/TypeService.h>
+#include <Eris/View.h>
+#include <Eris/ViewEntity.h>
+
+#include <Atlas/Objects/Anonymous.h>
+#include <Atlas/Objects/Operation.h>
+
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+class TestAvatar : public Eris::Avatar {
+  public:
+    TestAvatar(Eris::Account& ac, std::string mind_id, const std::string & ent_id) :
+               Eris::Avatar(ac, mind_id, ent_id) { }
+
+    void setup_setEntity(Eris::Entity * ent) {
+        m_entity = ent;
+    }
+};
+
+class TestView : public Eris::View {
+  public:
+    explicit TestView(Eris::Avatar& av) : Eris::View(av) { }
+
+    using Eris::View::appear;
+    using Eris::View::sight;
+    using Eris::View::isPending;
+    using Eris::View::markEntitiesStale;
+    using Eris::View::resynchronise;
+};
+
+static Atlas::Objects::Entity::Anonymous makeEntity(const std::string& id, const std::string& loc, double stamp)
+{
+    Atlas::Objects::Entity::Anonymous entity;
+    entity->setId(id);
+    entity->setParent("thing");
+    if (!loc.empty()) {
+        entity->setLoc(loc);
+    }
+    entity->setStamp(stamp);
+    return entity;
+}
+
+/**
+ * Sets up a world "0", containing the avatar "1" and the entities "2" and "3", with "4" inside "2".
+ */
+static void setupWorld(TestView& view, TestAvatar& avatar)
+{
+    view.sight(makeEntity("0", "", 1));
+    view.sight(makeEntity("1", "0", 1));
+    view.sight(makeEntity("2", "0", 1));
+    view.sight(makeEntity("3", "0", 1));
+    view.sight(makeEntity("4", "2", 1));
+    avatar.setup_setEntity(view.getEntity("1"));
+}
+
 int main()
 {
+    Atlas::Objects::Factories factories;
+    boost::asio::io_service io_service;
+    Eris::EventService event_service(io_service);
+    Eris::Connection con(io_service, event_service, "name", "localhost", 6767);
+    Eris::Account account(con);
+
+    auto thingType = con.getTypeService().getTypeByName("thing");
+    Atlas::Objects::Entity::Anonymous thing;
+    thing->setObjtype("class");
+    thing->setId("thing");
+    thing->setParent("root");
+    Atlas::Objects::Operation::Info info;
+    info->setArgs1(thing);
+    con.getTypeService().handleOperation(info);
+    assert(thingType->isBound());
+
+    // After a reconnect, entities whose stamps haven't changed should be kept as they are, while changed ones are looked at again
+    {
+        TestAvatar avatar(account, "12", "1");
+        TestView view(avatar);
+        setupWorld(view, avatar);
+        assert(!view.isPending("2"));
+        assert(!view.isPending("3"));
+
+        view.markEntitiesStale();
+        view.appear("2", 1);
+        view.appear("3", 2);
+        assert(!view.isPending("2"));
+        assert(view.getEntity("2")->isVisible());
+        assert(view.isPending("3"));
+
+        //Once confirmed, an appearance with the same stamp shouldn't lead to a look either.
+        view.appear("2", 1);
+        assert(!view.isPending("2"));
+    }
+
+    // Entities not confirmed within the grace period should be deleted, except for the avatar and its ancestors
+    {
+        TestAvatar avatar(account, "12", "1");
+        TestView view(avatar);
+        setupWorld(view, avatar);
+
+        view.markEntitiesStale();
+        view.resynchronise(std::chrono::milliseconds(50));
+        view.appear("3", 1);
+
+        //Nothing should be deleted before the deadline.
+        view.update();
+        assert(view.getEntity("2"));
+        assert(view.getEntity("4"));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        view.update();
+        assert(view.getEntity("0"));
+        assert(view.getEntity("1"));
+        assert(view.getEntity("3"));
+        assert(!view.getEntity("2"));
+        assert(!view.getEntity("4"));
+
+        //Entities seen after the deadline are fresh, and shouldn't be deleted by later updates.
+        view.sight(makeEntity("5", "0", 1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        view.update();
+        assert(view.getEntity("5"));
+    }
     return 0;
 }
@@ -0,0 +1,147 @@
+// Replays a session captured through BaseConnection::setCapture() into a Connection, with an Account, Avatar and
+// View on top, without any network. The client needs to send the same requests as the one which made the capture
+// did, since responses are matched by serial number; so give the same user name and character id as were used then.
+
+#include <Eris/Account.h>
+#include <Eris/Avatar.h>
+#include <Eris/Capture.h>
+#include <Eris/Connection.h>
+#include <Eris/EventService.h>
+#include <Eris/Exceptions.h>
+#include <Eris/Log.h>
+#include <Eris/View.h>
+
+#include <sigc++/functors/ptr_fun.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include <getopt.h>
+
+namespace {
+bool done = false;
+Eris::Avatar* avatar = nullptr;
+std::size_t entitiesSeen = 0;
+
+void usage(const char* prgname) {
+	std::cout << "usage: " << prgname << " [-f] [-u user [-p password] [-c character]] [-v] capture"
+			  << std::endl
+			  << "  -f  replay as fast as possible, instead of at the original timing" << std::endl
+			  << "  -u  log in as this user once connected" << std::endl
+			  << "  -p  the password to log in with" << std::endl
+			  << "  -c  take this character once logged in" << std::endl
+			  << "  -v  show debug log messages" << std::endl;
+}
+
+void erisLog(Eris::LogLevel level, const std::string& msg) {
+	std::cerr << "LOG: " << msg << std::endl;
+}
+}
+
+int main(int argc, char** argv) {
+	bool optionFast = false;
+	bool optionVerbose = false;
+	std::string user;
+	std::string password;
+	std::string character;
+
+	while (true) {
+		int c = getopt(argc, argv, "fu:p:c:v");
+		if (c == -1) {
+			break;
+		} else if (c == 'f') {
+			optionFast = true;
+		} else if (c == 'u') {
+			user = optarg;
+		} else if (c == 'p') {
+			password = optarg;
+		} else if (c == 'c') {
+			character = optarg;
+		} else if (c == 'v') {
+			optionVerbose = true;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (argc - optind != 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string path = argv[optind];
+
+	std::shared_ptr<Eris::CaptureReader> capture;
+	try {
+		capture = std::make_shared<Eris::CaptureReader>(path);
+	} catch (const Eris::BaseException& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	boost::asio::io_service io_service;
+	Eris::EventService event_service(io_service);
+
+	Eris::Logged.connect(sigc::ptr_fun(erisLog));
+	Eris::setLogLevel(optionVerbose ? Eris::LOG_DEBUG : Eris::LOG_WARNING);
+
+	Eris::Connection connection(io_service, event_service, "eris_replay", path, 0);
+	connection.setReplay(capture, optionFast ? Eris::ReplayStreamSocket::Pacing::FAST : Eris::ReplayStreamSocket::Pacing::ORIGINAL);
+	Eris::Account account(connection);
+
+	connection.Connected.connect([&]() {
+		std::cout << "Negotiated with the captured server." << std::endl;
+		if (!user.empty()) {
+			account.login(user, password);
+		}
+	});
+	connection.Failure.connect([](const std::string& message) {
+		std::cout << "Failure: " << message << std::endl;
+	});
+	connection.Disconnected.connect([]() {
+		done = true;
+	});
+	account.LoginSuccess.connect([&]() {
+		std::cout << "Logged in as " << user << "." << std::endl;
+		if (!character.empty()) {
+			account.takeCharacter(character);
+		}
+	});
+	account.LoginFailure.connect([](const std::string& message) {
+		std::cout << "Login failed: " << message << std::endl;
+	});
+	account.AvatarSuccess.connect([](Eris::Avatar* newAvatar) {
+		std::cout << "Took character " << newAvatar->getId() << "." << std::endl;
+		avatar = newAvatar;
+		avatar->getView().EntityCreated.connect([](Eris::ViewEntity*) {
+			entitiesSeen++;
+		});
+	});
+	account.AvatarFailure.connect([](const std::string& message) {
+		std::cout << "Could not take character: " << message << std::endl;
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	if (connection.connect() != 0) {
+		return 1;
+	}
+
+	//The statistics are lost along with the socket once the capture ends, so keep track of them as we go.
+	Eris::Connection::IoStatistics statistics;
+	while (!done) {
+		io_service.run_one();
+		event_service.processAllHandlers();
+		if (connection.isConnected()) {
+			statistics = connection.getIoStatistics();
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Replayed " << statistics.socket.bytesRead << " bytes and " << statistics.opsReceived << " ops in "
+			  << elapsed << " seconds." << std::endl;
+	if (avatar) {
+		std::cout << "The view created " << entitiesSeen << " entities." << std::endl;
+	}
+	return 0;
+}